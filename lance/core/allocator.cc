@@ -0,0 +1,365 @@
+#include "allocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "glog/logging.h"
+
+namespace lance {
+namespace core {
+namespace {
+void* system_allocate(size_t size, size_t alignment) {
+  if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+    return ::operator new(size, std::align_val_t(alignment));
+  }
+  return ::operator new(size);
+}
+
+void system_deallocate(void* ptr, size_t alignment) {
+  if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+    ::operator delete(ptr, std::align_val_t(alignment));
+  } else {
+    ::operator delete(ptr);
+  }
+}
+
+// a counter only ever written by one thread, and read by any
+void bump(std::atomic_uint64_t& counter) {
+  counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+class NewDeleteAllocator : public Allocator {
+ public:
+  void* allocate(size_t size, size_t alignment) override {
+    allocations_.fetch_add(1, std::memory_order_relaxed);
+    bytes_.fetch_add(size, std::memory_order_relaxed);
+    return system_allocate(size, alignment);
+  }
+
+  void deallocate(void* ptr, size_t /*size*/, size_t alignment) override {
+    deallocations_.fetch_add(1, std::memory_order_relaxed);
+    system_deallocate(ptr, alignment);
+  }
+
+  AllocatorStats stats() const override {
+    AllocatorStats stats;
+    stats.allocations = stats.system_allocations = allocations_.load(std::memory_order_relaxed);
+    stats.deallocations = deallocations_.load(std::memory_order_relaxed);
+    stats.system_bytes = bytes_.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+ private:
+  std::atomic_uint64_t allocations_{0};
+  std::atomic_uint64_t deallocations_{0};
+  std::atomic_uint64_t bytes_{0};
+};
+
+constexpr size_t kPoolAlignment = 16;
+constexpr size_t kPoolMaxSize = 512;
+constexpr size_t kNumSizeClasses = kPoolMaxSize / kPoolAlignment;
+constexpr size_t kSlabSize = 64 * 1024;
+
+// blocks moved between a thread cache and the central pool at once
+constexpr uint32_t kBatchSize = 32;
+constexpr uint32_t kMaxCachedBlocks = 4 * kBatchSize;
+
+size_t size_class_of(size_t size) { return (std::max<size_t>(size, 1) - 1) / kPoolAlignment; }
+
+size_t size_of_class(size_t size_class) { return (size_class + 1) * kPoolAlignment; }
+
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+struct FreeList {
+  FreeBlock* head = nullptr;
+  uint32_t count = 0;
+
+  void push(FreeBlock* block) {
+    block->next = head;
+    head = block;
+    ++count;
+  }
+
+  FreeBlock* pop() {
+    FreeBlock* block = head;
+    head = block->next;
+    --count;
+    return block;
+  }
+};
+
+class ThreadCache;
+
+// shared free lists, refilled from slabs which are never returned to the system
+class CentralPool {
+ public:
+  // move `count` blocks of `size_class` to `list`
+  void fetch(size_t size_class, uint32_t count, FreeList* list) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    FreeList& free = free_[size_class];
+    for (uint32_t i = 0; i < count; ++i) {
+      list->push(free.head ? free.pop() : carve(size_class));
+    }
+  }
+
+  // move `count` blocks from the front of `list` back to the central pool
+  void release(size_t size_class, uint32_t count, FreeList* list) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    FreeList& free = free_[size_class];
+    for (uint32_t i = 0; i < count; ++i) {
+      free.push(list->pop());
+    }
+  }
+
+  void add_cache(ThreadCache* cache) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    caches_.push_back(cache);
+  }
+
+  void remove_cache(ThreadCache* cache);
+
+  // requests which bypass the thread caches
+  void count_direct(bool allocation, size_t system_bytes) {
+    bump_shared(allocation ? direct_allocations_ : direct_deallocations_);
+    if (system_bytes > 0) {
+      bump_shared(system_allocations_);
+      system_bytes_.fetch_add(system_bytes, std::memory_order_relaxed);
+    }
+  }
+
+  AllocatorStats stats();
+
+ private:
+  static void bump_shared(std::atomic_uint64_t& counter) {
+    counter.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // caller holds mutex_
+  FreeBlock* carve(size_t size_class) {
+    const size_t block_size = size_of_class(size_class);
+
+    Slab& slab = slabs_[size_class];
+    if (slab.end - slab.begin < static_cast<ptrdiff_t>(block_size)) {
+      slab.begin = static_cast<uint8_t*>(::operator new(kSlabSize));
+      slab.end = slab.begin + kSlabSize;
+
+      bump_shared(system_allocations_);
+      system_bytes_.fetch_add(kSlabSize, std::memory_order_relaxed);
+    }
+
+    auto* block = reinterpret_cast<FreeBlock*>(slab.begin);
+    slab.begin += block_size;
+    return block;
+  }
+
+  struct Slab {
+    uint8_t* begin = nullptr;
+    uint8_t* end = nullptr;
+  };
+
+  std::mutex mutex_;
+  FreeList free_[kNumSizeClasses];
+  Slab slabs_[kNumSizeClasses];
+  std::vector<ThreadCache*> caches_;
+
+  // counts of exited threads are folded in here
+  uint64_t retired_allocations_ = 0;
+  uint64_t retired_deallocations_ = 0;
+
+  std::atomic_uint64_t direct_allocations_{0};
+  std::atomic_uint64_t direct_deallocations_{0};
+  std::atomic_uint64_t system_allocations_{0};
+  std::atomic_uint64_t system_bytes_{0};
+};
+
+// leaked on purpose, objects may be released during static destruction
+CentralPool& central_pool() {
+  static CentralPool* pool = new CentralPool();
+  return *pool;
+}
+
+class ThreadCache {
+ public:
+  ThreadCache() { central_pool().add_cache(this); }
+
+  ~ThreadCache() {
+    for (size_t i = 0; i < kNumSizeClasses; ++i) {
+      if (lists_[i].count > 0) {
+        central_pool().release(i, lists_[i].count, &lists_[i]);
+      }
+    }
+
+    central_pool().remove_cache(this);
+  }
+
+  void* allocate(size_t size_class) {
+    bump(allocations_);
+
+    FreeList& list = lists_[size_class];
+    if (!list.head) {
+      central_pool().fetch(size_class, kBatchSize, &list);
+    }
+
+    return list.pop();
+  }
+
+  void deallocate(void* ptr, size_t size_class) {
+    bump(deallocations_);
+
+    FreeList& list = lists_[size_class];
+    list.push(static_cast<FreeBlock*>(ptr));
+
+    if (list.count > kMaxCachedBlocks) {
+      central_pool().release(size_class, kBatchSize, &list);
+    }
+  }
+
+  uint64_t allocations() const { return allocations_.load(std::memory_order_relaxed); }
+  uint64_t deallocations() const { return deallocations_.load(std::memory_order_relaxed); }
+
+ private:
+  FreeList lists_[kNumSizeClasses];
+
+  // written by the owning thread only, read by stats()
+  std::atomic_uint64_t allocations_{0};
+  std::atomic_uint64_t deallocations_{0};
+};
+
+void CentralPool::remove_cache(ThreadCache* cache) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  retired_allocations_ += cache->allocations();
+  retired_deallocations_ += cache->deallocations();
+  caches_.erase(std::find(caches_.begin(), caches_.end(), cache));
+}
+
+AllocatorStats CentralPool::stats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  AllocatorStats stats;
+  stats.allocations = retired_allocations_ + direct_allocations_.load(std::memory_order_relaxed);
+  stats.deallocations =
+      retired_deallocations_ + direct_deallocations_.load(std::memory_order_relaxed);
+
+  for (const ThreadCache* cache : caches_) {
+    stats.allocations += cache->allocations();
+    stats.deallocations += cache->deallocations();
+  }
+
+  stats.system_allocations = system_allocations_.load(std::memory_order_relaxed);
+  stats.system_bytes = system_bytes_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+// the cache is unusable once the thread starts tearing down its thread locals, late requests
+// go straight to the central pool
+enum class ThreadCacheState : uint8_t { kNone, kAlive, kDestroyed };
+
+thread_local ThreadCacheState thread_cache_state = ThreadCacheState::kNone;
+
+ThreadCache* thread_cache() {
+  struct Holder {
+    Holder() { thread_cache_state = ThreadCacheState::kAlive; }
+    ~Holder() { thread_cache_state = ThreadCacheState::kDestroyed; }
+
+    ThreadCache cache;
+  };
+
+  if (thread_cache_state == ThreadCacheState::kDestroyed) {
+    return nullptr;
+  }
+
+  thread_local Holder holder;
+  return &holder.cache;
+}
+
+class PoolAllocator : public Allocator {
+ public:
+  void* allocate(size_t size, size_t alignment) override {
+    if (size > kPoolMaxSize || alignment > kPoolAlignment) {
+      central_pool().count_direct(true, size);
+      return system_allocate(size, alignment);
+    }
+
+    const size_t size_class = size_class_of(size);
+    if (ThreadCache* cache = thread_cache()) {
+      return cache->allocate(size_class);
+    }
+
+    central_pool().count_direct(true, 0);
+
+    FreeList list;
+    central_pool().fetch(size_class, 1, &list);
+    return list.pop();
+  }
+
+  void deallocate(void* ptr, size_t size, size_t alignment) override {
+    if (size > kPoolMaxSize || alignment > kPoolAlignment) {
+      central_pool().count_direct(false, 0);
+      system_deallocate(ptr, alignment);
+      return;
+    }
+
+    const size_t size_class = size_class_of(size);
+    if (ThreadCache* cache = thread_cache()) {
+      cache->deallocate(ptr, size_class);
+      return;
+    }
+
+    central_pool().count_direct(false, 0);
+
+    FreeList list;
+    list.push(static_cast<FreeBlock*>(ptr));
+    central_pool().release(size_class, 1, &list);
+  }
+
+  AllocatorStats stats() const override { return central_pool().stats(); }
+};
+}  // namespace
+
+Allocator* new_delete_allocator() {
+  static NewDeleteAllocator allocator;
+  return &allocator;
+}
+
+Allocator* pool_allocator() {
+  static PoolAllocator* allocator = new PoolAllocator();
+  return allocator;
+}
+
+FrameArena::FrameArena(size_t block_size) : linear_(block_size) {}
+
+FrameArena::~FrameArena() {
+  DCHECK_EQ(live_count(), 0) << "objects are still alive in the frame arena";
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment) {
+  ++stats_.allocations;
+  return linear_.allocate(size, alignment);
+}
+
+void FrameArena::deallocate(void* /*ptr*/, size_t /*size*/, size_t /*alignment*/) {
+  ++stats_.deallocations;
+}
+
+AllocatorStats FrameArena::stats() const {
+  AllocatorStats stats = stats_;
+  stats.system_allocations = linear_.system_allocations();
+  stats.system_bytes = linear_.capacity();
+  return stats;
+}
+
+void FrameArena::reset() {
+  CHECK_EQ(live_count(), 0) << "objects are still alive in the frame arena";
+
+  linear_.reset();
+}
+}  // namespace core
+}  // namespace lance
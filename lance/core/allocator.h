@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "lance/core/linear_allocator.h"
+
+namespace lance {
+namespace core {
+struct AllocatorStats {
+  // calls to allocate/deallocate
+  uint64_t allocations = 0;
+  uint64_t deallocations = 0;
+
+  // requests forwarded to the system allocator, and the bytes they asked for
+  uint64_t system_allocations = 0;
+  uint64_t system_bytes = 0;
+};
+
+class Allocator {
+ public:
+  virtual ~Allocator() = default;
+
+  virtual void* allocate(size_t size, size_t alignment) = 0;
+
+  // `size` and `alignment` must match the allocate call
+  virtual void deallocate(void* ptr, size_t size, size_t alignment) = 0;
+
+  virtual AllocatorStats stats() const = 0;
+};
+
+// plain operator new/delete
+Allocator* new_delete_allocator();
+
+// size-class pools for small objects with thread-local caches, larger or over-aligned requests go
+// to the system allocator. this is what make_refcounted uses by default.
+Allocator* pool_allocator();
+
+// bump allocator for objects that die within a frame. deallocate is a no-op, memory is recycled
+// in bulk by reset(). not thread-safe.
+class FrameArena : public Allocator {
+ public:
+  static constexpr size_t kDefaultBlockSize = 64 * 1024;
+
+  explicit FrameArena(size_t block_size = kDefaultBlockSize);
+
+  ~FrameArena() override;
+
+  FrameArena(const FrameArena&) = delete;
+  FrameArena& operator=(const FrameArena&) = delete;
+
+  void* allocate(size_t size, size_t alignment) override;
+
+  void deallocate(void* ptr, size_t size, size_t alignment) override;
+
+  AllocatorStats stats() const override;
+
+  // recycle every block, all objects allocated from the arena must be dead
+  void reset();
+
+  // objects allocated and not yet deallocated
+  size_t live_count() const { return stats_.allocations - stats_.deallocations; }
+
+ private:
+  LinearAllocator linear_;
+
+  AllocatorStats stats_;
+};
+}  // namespace core
+}  // namespace lance
@@ -0,0 +1,98 @@
+#include <vector>
+
+#include "allocator.h"
+#include "benchmark/benchmark.h"
+#include "object.h"
+
+namespace lance {
+namespace core {
+namespace {
+// about the size of a small per-frame wrapper like a Framebuffer
+class BenchmarkObject : public Inherit<BenchmarkObject, Object> {
+ public:
+  explicit BenchmarkObject(uint64_t handle) : handle_(handle) {}
+
+ private:
+  uint64_t handle_ = 0;
+  void* device_ = nullptr;
+};
+
+void report(benchmark::State& state, const AllocatorStats& before, const AllocatorStats& after) {
+  const auto iterations = static_cast<double>(state.iterations());
+  state.counters["system_allocs/iter"] =
+      static_cast<double>(after.system_allocations - before.system_allocations) / iterations;
+  state.counters["allocs/iter"] =
+      static_cast<double>(after.allocations - before.allocations) / iterations;
+}
+
+// create a frame's worth of objects, then drop them all
+void churn(Allocator* allocator, size_t count, std::vector<RefCountPtr<BenchmarkObject>>* objects) {
+  for (size_t i = 0; i < count; ++i) {
+    objects->push_back(make_refcounted_with<BenchmarkObject>(allocator, i));
+  }
+  objects->clear();
+}
+
+void BM_refcounted_new_delete(benchmark::State& state) {
+  std::vector<RefCountPtr<BenchmarkObject>> objects;
+  objects.reserve(state.range(0));
+
+  const AllocatorStats before = new_delete_allocator()->stats();
+  for (auto _ : state) {
+    churn(new_delete_allocator(), state.range(0), &objects);
+  }
+  report(state, before, new_delete_allocator()->stats());
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_refcounted_pool(benchmark::State& state) {
+  std::vector<RefCountPtr<BenchmarkObject>> objects;
+  objects.reserve(state.range(0));
+
+  const AllocatorStats before = pool_allocator()->stats();
+  for (auto _ : state) {
+    churn(pool_allocator(), state.range(0), &objects);
+  }
+  report(state, before, pool_allocator()->stats());
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_refcounted_frame_arena(benchmark::State& state) {
+  std::vector<RefCountPtr<BenchmarkObject>> objects;
+  objects.reserve(state.range(0));
+
+  FrameArena arena;
+  const AllocatorStats before = arena.stats();
+  for (auto _ : state) {
+    churn(&arena, state.range(0), &objects);
+    arena.reset();
+  }
+  report(state, before, arena.stats());
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_refcounted_new_delete)->Arg(1 << 10)->Arg(1 << 14);
+BENCHMARK(BM_refcounted_pool)->Arg(1 << 10)->Arg(1 << 14);
+BENCHMARK(BM_refcounted_frame_arena)->Arg(1 << 10)->Arg(1 << 14);
+
+// every thread churns its own objects, the pool should scale with its thread caches
+template <Allocator* (*GetAllocator)()>
+void BM_refcounted_threaded(benchmark::State& state) {
+  std::vector<RefCountPtr<BenchmarkObject>> objects;
+  objects.reserve(1024);
+
+  for (auto _ : state) {
+    churn(GetAllocator(), 1024, &objects);
+  }
+
+  state.SetItemsProcessed(state.iterations() * 1024);
+}
+
+BENCHMARK_TEMPLATE(BM_refcounted_threaded, new_delete_allocator)->ThreadRange(1, 8);
+BENCHMARK_TEMPLATE(BM_refcounted_threaded, pool_allocator)->ThreadRange(1, 8);
+}  // namespace
+}  // namespace core
+}  // namespace lance
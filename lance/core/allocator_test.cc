@@ -0,0 +1,119 @@
+#include "allocator.h"
+
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "object.h"
+
+namespace lance {
+namespace core {
+namespace {
+class AllocatorTestObject : public Inherit<AllocatorTestObject, Object> {
+ public:
+  explicit AllocatorTestObject(int* destroyed) : destroyed_(destroyed) {}
+
+  ~AllocatorTestObject() override { ++*destroyed_; }
+
+ private:
+  int* destroyed_;
+  char payload_[40] = {};
+};
+}  // namespace
+
+TEST(allocator, pool_reuses_blocks) {
+  Allocator* allocator = pool_allocator();
+
+  std::vector<void*> blocks;
+  for (size_t i = 0; i < 1000; ++i) {
+    void* p = allocator->allocate(48, 16);
+    ASSERT_EQ(0, reinterpret_cast<uintptr_t>(p) % 16);
+    blocks.push_back(p);
+  }
+  for (void* p : blocks) {
+    allocator->deallocate(p, 48, 16);
+  }
+
+  // a second round is served from the cache without touching the system allocator
+  const AllocatorStats before = allocator->stats();
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    blocks[i] = allocator->allocate(48, 16);
+  }
+  for (void* p : blocks) {
+    allocator->deallocate(p, 48, 16);
+  }
+  const AllocatorStats after = allocator->stats();
+
+  ASSERT_EQ(before.system_allocations, after.system_allocations);
+  ASSERT_EQ(before.allocations + blocks.size(), after.allocations);
+  ASSERT_EQ(before.deallocations + blocks.size(), after.deallocations);
+}
+
+TEST(allocator, pool_large_and_over_aligned) {
+  Allocator* allocator = pool_allocator();
+
+  void* large = allocator->allocate(4096, 16);
+  void* aligned = allocator->allocate(64, 64);
+  ASSERT_EQ(0, reinterpret_cast<uintptr_t>(aligned) % 64);
+
+  allocator->deallocate(large, 4096, 16);
+  allocator->deallocate(aligned, 64, 64);
+}
+
+TEST(allocator, pool_cross_thread) {
+  Allocator* allocator = pool_allocator();
+
+  // blocks freed on another thread, which then exits and hands its cache back
+  std::vector<void*> blocks;
+  for (size_t i = 0; i < 500; ++i) {
+    blocks.push_back(allocator->allocate(100, 8));
+  }
+
+  std::thread([&]() {
+    for (void* p : blocks) {
+      allocator->deallocate(p, 100, 8);
+    }
+  }).join();
+
+  const AllocatorStats stats = allocator->stats();
+  ASSERT_GE(stats.deallocations, blocks.size());
+}
+
+TEST(allocator, make_refcounted_with_frame_arena) {
+  FrameArena arena(1024);
+  int destroyed = 0;
+
+  for (size_t frame = 0; frame < 3; ++frame) {
+    {
+      std::vector<RefCountPtr<AllocatorTestObject>> objects;
+      for (size_t i = 0; i < 100; ++i) {
+        objects.push_back(make_refcounted_with<AllocatorTestObject>(&arena, &destroyed));
+      }
+      ASSERT_EQ(100, arena.live_count());
+    }
+
+    ASSERT_EQ(0, arena.live_count());
+    arena.reset();
+  }
+
+  ASSERT_EQ(300, destroyed);
+
+  // blocks are recycled after the first frame
+  const AllocatorStats stats = arena.stats();
+  ASSERT_EQ(300, stats.allocations);
+  ASSERT_LE(stats.system_bytes, 100 * 1024);
+}
+
+TEST(allocator, make_refcounted_uses_pool) {
+  int destroyed = 0;
+
+  const AllocatorStats before = pool_allocator()->stats();
+  { auto object = make_refcounted<AllocatorTestObject>(&destroyed); }
+  const AllocatorStats after = pool_allocator()->stats();
+
+  ASSERT_EQ(1, destroyed);
+  ASSERT_EQ(before.allocations + 1, after.allocations);
+  ASSERT_EQ(before.deallocations + 1, after.deallocations);
+}
+}  // namespace core
+}  // namespace lance
@@ -0,0 +1,491 @@
+#include "async_read.h"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "absl/strings/str_format.h"
+#include "glog/logging.h"
+
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+namespace lance {
+namespace core {
+namespace detail {
+AsyncReadBatch::AsyncReadBatch(RefCountPtr<Object> owner, size_t count, ReadCallback callback)
+    : owner_(owner), callback_(std::move(callback)), pending_(count) {}
+
+void AsyncReadBatch::complete(size_t index, absl::Status status) {
+  if (!status.ok()) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (status_.ok()) {
+      status_ = status;
+    }
+  }
+
+  if (callback_) {
+    callback_(index, status);
+  }
+
+  if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cv_.notify_all();
+  }
+}
+
+bool AsyncReadBatch::done() const { return pending_.load(std::memory_order_acquire) == 0; }
+
+absl::Status AsyncReadBatch::wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait(lock, [this]() { return done(); });
+
+  return status_;
+}
+
+namespace {
+// threads blocking on reads, sized for io rather than for cpu work
+class IoThreadPool {
+ public:
+  static IoThreadPool& instance() {
+    static IoThreadPool pool;
+    return pool;
+  }
+
+  IoThreadPool() {
+    const uint32_t num_threads = std::clamp(std::thread::hardware_concurrency(), 2u, 16u);
+    for (uint32_t i = 0; i < num_threads; ++i) {
+      threads_.emplace_back(&IoThreadPool::run, this);
+    }
+  }
+
+  ~IoThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    cv_.notify_all();
+
+    for (auto& t : threads_) {
+      t.join();
+    }
+  }
+
+  void enqueue(std::function<void()> task) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+  }
+
+ private:
+  void run() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+
+        // drain the queue before stopping
+        if (tasks_.empty()) {
+          return;
+        }
+
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+      }
+
+      task();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> tasks_;
+  bool stopping_ = false;
+  std::vector<std::thread> threads_;
+};
+
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+// a read in flight, resubmitted until short reads are exhausted
+struct IoUringRead {
+  RefCountPtr<AsyncReadBatch> batch;
+  size_t index = 0;
+  int fd = -1;
+  size_t offset = 0;
+  uint8_t* out = nullptr;
+  size_t remaining = 0;
+};
+
+// process-wide ring, submissions are serialized by a mutex and completions are reaped by a
+// dedicated thread which runs the callbacks. reads submitted by those callbacks while the ring is
+// full are queued, since only the reaper makes room.
+class IoUring {
+ public:
+  static constexpr uint32_t kEntries = 256;
+
+  // sqe lengths are 32 bits, larger reads complete as a sequence of short reads
+  static constexpr size_t kMaxReadLength = size_t(1) << 30;
+
+  // nullptr if the kernel does not support io_uring
+  static IoUring* instance() {
+    static std::unique_ptr<IoUring> ring = create();
+    return ring.get();
+  }
+
+  ~IoUring();
+
+  void submit(int fd, absl::Span<const ReadRequest> requests, RefCountPtr<AsyncReadBatch> batch);
+
+ private:
+  static std::unique_ptr<IoUring> create();
+
+  IoUring() = default;
+
+  bool init();
+
+  // caller holds mutex_
+  void push(uint8_t opcode, IoUringRead* read);
+  void flush();
+
+  void reap();
+  bool on_reaper() const;
+  void resubmit(IoUringRead* read);
+  void finish(IoUringRead* read, absl::Status status);
+
+  int ring_fd_ = -1;
+
+  void* sq_ring_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  void* cq_ring_ = nullptr;
+  size_t cq_ring_size_ = 0;
+  io_uring_sqe* sqes_ = nullptr;
+  size_t sqes_size_ = 0;
+
+  uint32_t* sq_tail_ = nullptr;
+  uint32_t sq_mask_ = 0;
+  uint32_t sq_entries_ = 0;
+  uint32_t* sq_array_ = nullptr;
+
+  uint32_t* cq_head_ = nullptr;
+  uint32_t* cq_tail_ = nullptr;
+  uint32_t cq_mask_ = 0;
+  io_uring_cqe* cqes_ = nullptr;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  uint32_t unsubmitted_ = 0;
+
+  // bounded by the completion queue size, so completions are never dropped
+  uint32_t in_flight_ = 0;
+  uint32_t capacity_ = 0;
+
+  // submitted by callbacks while the ring was full, pushed by finish() as reads complete
+  std::deque<IoUringRead*> pending_;
+
+  std::thread reaper_;
+};
+
+std::unique_ptr<IoUring> IoUring::create() {
+  std::unique_ptr<IoUring> ring(new IoUring());
+  if (!ring->init()) {
+    return nullptr;
+  }
+
+  ring->reaper_ = std::thread(&IoUring::reap, ring.get());
+  return ring;
+}
+
+bool IoUring::init() {
+  io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+
+  ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, kEntries, &params));
+  if (ring_fd_ < 0) {
+    VLOG(1) << "io_uring is not available, err: " << std::strerror(errno);
+    return false;
+  }
+
+  // IORING_OP_READ came with the same kernel release as this feature
+  if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+    VLOG(1) << "io_uring does not support IORING_OP_READ";
+    return false;
+  }
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+  const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                  ring_fd_, IORING_OFF_SQ_RING);
+  if (sq_ring_ == MAP_FAILED) {
+    sq_ring_ = nullptr;
+    return false;
+  }
+
+  if (single_mmap) {
+    cq_ring_ = sq_ring_;
+  } else {
+    cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    ring_fd_, IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      cq_ring_ = nullptr;
+      return false;
+    }
+  }
+
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    ring_fd_, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    return false;
+  }
+  sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+  auto* sq = static_cast<uint8_t*>(sq_ring_);
+  sq_tail_ = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+  sq_mask_ = *reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+  sq_entries_ = params.sq_entries;
+
+  auto* cq = static_cast<uint8_t*>(cq_ring_);
+  cq_head_ = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+  cq_mask_ = *reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+  // leave room for the nop that stops the reaper
+  capacity_ = params.cq_entries - 1;
+
+  return true;
+}
+
+IoUring::~IoUring() {
+  if (reaper_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      push(IORING_OP_NOP, nullptr);
+      flush();
+    }
+    reaper_.join();
+  }
+
+  if (sqes_) {
+    munmap(sqes_, sqes_size_);
+  }
+  if (cq_ring_ && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  if (sq_ring_) {
+    munmap(sq_ring_, sq_ring_size_);
+  }
+  if (ring_fd_ >= 0) {
+    close(ring_fd_);
+  }
+}
+
+void IoUring::submit(int fd, absl::Span<const ReadRequest> requests,
+                     RefCountPtr<AsyncReadBatch> batch) {
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  const bool reaper = on_reaper();
+  for (size_t i = 0; i < requests.size(); ++i) {
+    const ReadRequest& request = requests[i];
+    auto* read = new IoUringRead{batch, i, fd, request.offset, static_cast<uint8_t*>(request.out),
+                                 request.length};
+
+    if (in_flight_ >= capacity_ || !pending_.empty()) {
+      if (reaper) {
+        // waiting here would wait for ourselves
+        pending_.push_back(read);
+        continue;
+      }
+
+      // submit what is queued, then wait for the reaper to make room
+      flush();
+      cv_.wait(lock, [this]() { return in_flight_ < capacity_ && pending_.empty(); });
+    }
+
+    if (unsubmitted_ == sq_entries_) {
+      flush();
+    }
+
+    push(IORING_OP_READ, read);
+    ++in_flight_;
+  }
+
+  flush();
+}
+
+void IoUring::push(uint8_t opcode, IoUringRead* read) {
+  // the submission queue has a single producer, guarded by mutex_
+  const uint32_t tail = *sq_tail_;
+  const uint32_t index = tail & sq_mask_;
+
+  io_uring_sqe* sqe = &sqes_[index];
+  std::memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = opcode;
+  sqe->user_data = reinterpret_cast<uint64_t>(read);
+
+  if (read) {
+    sqe->fd = read->fd;
+    sqe->off = read->offset;
+    sqe->addr = reinterpret_cast<uint64_t>(read->out);
+    sqe->len = static_cast<uint32_t>(std::min(read->remaining, kMaxReadLength));
+  }
+
+  sq_array_[index] = index;
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+
+  ++unsubmitted_;
+}
+
+void IoUring::flush() {
+  while (unsubmitted_ > 0) {
+    const int ret =
+        static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, unsubmitted_, 0, 0, nullptr, 0));
+    if (ret < 0) {
+      CHECK(errno == EINTR || errno == EAGAIN || errno == EBUSY)
+          << "io_uring_enter failed, err: " << std::strerror(errno);
+      std::this_thread::yield();
+      continue;
+    }
+
+    unsubmitted_ -= static_cast<uint32_t>(ret);
+  }
+}
+
+thread_local bool t_io_uring_reaper = false;
+
+bool IoUring::on_reaper() const { return t_io_uring_reaper; }
+
+void IoUring::reap() {
+  t_io_uring_reaper = true;
+
+  while (true) {
+    const int ret = static_cast<int>(
+        syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0));
+    if (ret < 0) {
+      CHECK(errno == EINTR || errno == EAGAIN || errno == EBUSY)
+          << "io_uring_enter failed, err: " << std::strerror(errno);
+    }
+
+    uint32_t head = *cq_head_;
+    const uint32_t tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+
+    bool stopping = false;
+    for (; head != tail; ++head) {
+      const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+      auto* read = reinterpret_cast<IoUringRead*>(cqe.user_data);
+      const int res = cqe.res;
+
+      // release the slot before running callbacks, which may submit more reads
+      __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+
+      if (!read) {
+        stopping = true;
+      } else if (res == -EINTR || res == -EAGAIN) {
+        resubmit(read);
+      } else if (res < 0) {
+        finish(read, absl::UnknownError(absl::StrFormat("read failed, offset: %d, err: %s",
+                                                        read->offset, std::strerror(-res))));
+      } else if (res == 0 && read->remaining > 0) {
+        finish(read, absl::OutOfRangeError(
+                         absl::StrFormat("unexpected end of file, offset: %d", read->offset)));
+      } else {
+        read->offset += res;
+        read->out += res;
+        read->remaining -= res;
+
+        if (read->remaining > 0) {
+          resubmit(read);
+        } else {
+          finish(read, absl::OkStatus());
+        }
+      }
+    }
+
+    if (stopping) {
+      return;
+    }
+  }
+}
+
+void IoUring::resubmit(IoUringRead* read) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (unsubmitted_ == sq_entries_) {
+    flush();
+  }
+
+  push(IORING_OP_READ, read);
+  flush();
+}
+
+void IoUring::finish(IoUringRead* read, absl::Status status) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    --in_flight_;
+
+    // queued reads go first, blocked submitters wait until they are gone
+    if (!pending_.empty()) {
+      if (unsubmitted_ == sq_entries_) {
+        flush();
+      }
+
+      push(IORING_OP_READ, pending_.front());
+      pending_.pop_front();
+      ++in_flight_;
+      flush();
+    }
+  }
+  cv_.notify_all();
+
+  read->batch->complete(read->index, std::move(status));
+  delete read;
+}
+#endif
+}  // namespace
+
+void enqueue_io(std::function<void()> task) { IoThreadPool::instance().enqueue(std::move(task)); }
+
+void submit_pool_reads(InputStream* stream, absl::Span<const ReadRequest> requests,
+                       RefCountPtr<AsyncReadBatch> batch) {
+  auto& pool = IoThreadPool::instance();
+  for (size_t i = 0; i < requests.size(); ++i) {
+    pool.enqueue([stream, request = requests[i], batch, i]() {
+      batch->complete(i, stream->read(request.offset, request.length, request.out));
+    });
+  }
+}
+
+bool submit_io_uring_reads(int fd, absl::Span<const ReadRequest> requests,
+                           RefCountPtr<AsyncReadBatch> batch) {
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+  IoUring* ring = IoUring::instance();
+  if (!ring) {
+    return false;
+  }
+
+  ring->submit(fd, requests, batch);
+  return true;
+#else
+  return false;
+#endif
+}
+}  // namespace detail
+}  // namespace core
+}  // namespace lance
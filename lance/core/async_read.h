@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+#include "file_system.h"
+
+namespace lance {
+namespace core {
+namespace detail {
+class AsyncReadBatch : public Inherit<AsyncReadBatch, ReadBatch> {
+ public:
+  // `owner` is kept alive until the batch is done
+  AsyncReadBatch(RefCountPtr<Object> owner, size_t count, ReadCallback callback);
+
+  // record the completion of request `index`, thread-safe
+  void complete(size_t index, absl::Status status);
+
+  bool done() const override;
+
+  absl::Status wait() override;
+
+ private:
+  RefCountPtr<Object> owner_;
+  ReadCallback callback_;
+
+  std::atomic_size_t pending_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  absl::Status status_;
+};
+
+// run `task` on the shared io thread pool
+void enqueue_io(std::function<void()> task);
+
+// run every request on the shared io thread pool
+void submit_pool_reads(InputStream* stream, absl::Span<const ReadRequest> requests,
+                       RefCountPtr<AsyncReadBatch> batch);
+
+// submit every request to the shared io_uring instance, reading from `fd`. returns false without
+// submitting anything when io_uring is not available.
+bool submit_io_uring_reads(int fd, absl::Span<const ReadRequest> requests,
+                           RefCountPtr<AsyncReadBatch> batch);
+}  // namespace detail
+}  // namespace core
+}  // namespace lance
@@ -0,0 +1,358 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "absl/strings/str_format.h"
+#include "async_read.h"
+#include "file_system.h"
+#include "glog/logging.h"
+
+namespace lance {
+namespace core {
+namespace {
+struct BlockKey {
+  uint64_t file = 0;
+  uint64_t index = 0;
+
+  bool operator==(const BlockKey& other) const {
+    return file == other.file && index == other.index;
+  }
+};
+
+struct BlockKeyHash {
+  size_t operator()(const BlockKey& key) const {
+    return std::hash<uint64_t>()(key.file * 0x9e3779b97f4a7c15ull ^ key.index);
+  }
+};
+
+// one block of a file. whoever moves it from queued to loading reads it, everyone else waits.
+class CachedBlock : public Inherit<CachedBlock, Object> {
+ public:
+  explicit CachedBlock(size_t size) : data_(new uint8_t[size]), size_(size) {}
+
+  uint8_t* data() const { return data_.get(); }
+
+  size_t size() const { return size_; }
+
+  bool ready() const { return state_.load(std::memory_order_acquire) == State::kReady; }
+
+  // true if the caller won the right to load the block
+  bool try_start_loading() {
+    State expected = State::kQueued;
+    return state_.compare_exchange_strong(expected, State::kLoading, std::memory_order_acq_rel);
+  }
+
+  void finish_loading(absl::Status status) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      status_ = std::move(status);
+      state_.store(State::kReady, std::memory_order_release);
+    }
+    cv_.notify_all();
+  }
+
+  // block until the block is loaded, returns the load's status
+  absl::Status wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this]() { return state_.load(std::memory_order_relaxed) == State::kReady; });
+    return status_;
+  }
+
+ private:
+  enum class State {
+    kQueued,
+    kLoading,
+    kReady,
+  };
+
+  const std::unique_ptr<uint8_t[]> data_;
+  const size_t size_;
+
+  std::atomic<State> state_{State::kQueued};
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  absl::Status status_;
+};
+
+// blocks of every file of a cached file system, under a single memory budget
+class BlockCache : public Inherit<BlockCache, Object> {
+ public:
+  explicit BlockCache(const CachedFileSystemOptions& options) : options_(options) {}
+
+  const CachedFileSystemOptions& options() const { return options_; }
+
+  uint64_t file_id(std::string_view uri) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = file_ids_.find(std::string(uri));
+    if (it == file_ids_.end()) {
+      it = file_ids_.emplace(std::string(uri), next_file_id_++).first;
+    }
+    return it->second;
+  }
+
+  // drops the blocks of `uri` after it was written. streams opened from now on get a new id, so
+  // a load of the old content still in flight is never found by them.
+  void invalidate(std::string_view uri) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = file_ids_.find(std::string(uri));
+    if (it == file_ids_.end()) {
+      return;
+    }
+
+    const uint64_t file = it->second;
+    file_ids_.erase(it);
+    for (auto entry = entries_.begin(); entry != entries_.end();) {
+      auto next = std::next(entry);
+      if (entry->first.file == file) {
+        erase_locked(entry);
+      }
+      entry = next;
+    }
+  }
+
+  // the cached block for `key`, or a new queued one of `size` bytes. `created` tells whether the
+  // block was just inserted.
+  RefCountPtr<CachedBlock> get(const BlockKey& key, size_t size, bool* created) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      lru_.splice(lru_.begin(), lru_, it->second.lru);
+      *created = false;
+      return it->second.block;
+    }
+
+    auto block = make_refcounted<CachedBlock>(size);
+    lru_.push_front(key);
+    entries_.emplace(key, Entry{block, lru_.begin()});
+    used_bytes_ += size;
+    *created = true;
+
+    evict_locked();
+
+    return block;
+  }
+
+  // drop `block` if it is still the one cached for `key`, e.g. after its load failed
+  void erase(const BlockKey& key, const CachedBlock* block) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = entries_.find(key);
+    if (it != entries_.end() && it->second.block.get() == block) {
+      erase_locked(it);
+    }
+  }
+
+ private:
+  struct Entry {
+    RefCountPtr<CachedBlock> block;
+    std::list<BlockKey>::iterator lru;
+  };
+
+  using EntryMap = std::unordered_map<BlockKey, Entry, BlockKeyHash>;
+
+  void evict_locked() {
+    // blocks still loading stay, their memory is in use anyway. a reader holding an evicted block
+    // keeps its data alive until it finished copying.
+    auto it = lru_.end();
+    while (used_bytes_ > options_.capacity && it != lru_.begin()) {
+      --it;
+      auto entry = entries_.find(*it);
+      if (!entry->second.block->ready()) {
+        continue;
+      }
+
+      it = std::next(it);
+      erase_locked(entry);
+    }
+  }
+
+  void erase_locked(EntryMap::iterator it) {
+    used_bytes_ -= it->second.block->size();
+    lru_.erase(it->second.lru);
+    entries_.erase(it);
+  }
+
+  const CachedFileSystemOptions options_;
+
+  std::mutex mutex_;
+  std::unordered_map<std::string, uint64_t> file_ids_;
+  uint64_t next_file_id_ = 0;
+  EntryMap entries_;
+  // most recently used first
+  std::list<BlockKey> lru_;
+  size_t used_bytes_ = 0;
+};
+
+class CachedInputStream : public Inherit<CachedInputStream, InputStream> {
+ public:
+  CachedInputStream(RefCountPtr<BlockCache> cache, uint64_t file, RefCountPtr<InputStream> base)
+      : cache_(cache),
+        file_(file),
+        base_(base),
+        size_(base->size()),
+        block_size_(cache->options().block_size) {}
+
+  absl::Status read(size_t offset, size_t length, void* out) override {
+    if (offset > size_ || length > size_ - offset) {
+      return absl::OutOfRangeError(
+          absl::StrFormat("offset: %d, length: %d, size: %d", offset, length, size_));
+    }
+
+    if (length == 0) {
+      return absl::OkStatus();
+    }
+
+    const uint64_t first = offset / block_size_;
+    const uint64_t last = (offset + length - 1) / block_size_;
+
+    // a read starting where the previous one ended fetches the following blocks in the background
+    if (next_offset_.exchange(offset + length, std::memory_order_relaxed) == offset) {
+      read_ahead(last + 1);
+    }
+
+    auto* dst = static_cast<uint8_t*>(out);
+    for (uint64_t index = first; index <= last; ++index) {
+      bool created = false;
+      auto block = cache_->get(BlockKey{file_, index}, block_length(index), &created);
+      if (block->try_start_loading()) {
+        load(block.get(), index);
+      }
+      LANCE_RETURN_IF_FAILED(block->wait());
+
+      const size_t block_offset = index * block_size_;
+      const size_t begin = std::max<size_t>(offset, block_offset);
+      const size_t end = std::min<size_t>(offset + length, block_offset + block->size());
+      std::memcpy(dst, block->data() + (begin - block_offset), end - begin);
+      dst += end - begin;
+    }
+
+    return absl::OkStatus();
+  }
+
+  size_t size() const override { return size_; }
+
+ private:
+  size_t block_length(uint64_t index) const {
+    return std::min<size_t>(block_size_, size_ - index * block_size_);
+  }
+
+  void load(CachedBlock* block, uint64_t index) {
+    absl::Status status = base_->read(index * block_size_, block->size(), block->data());
+    if (!status.ok()) {
+      // the next reader retries
+      cache_->erase(BlockKey{file_, index}, block);
+    }
+    block->finish_loading(std::move(status));
+  }
+
+  void read_ahead(uint64_t first) {
+    const uint64_t num_blocks = (size_ + block_size_ - 1) / block_size_;
+    const uint64_t end =
+        std::min<uint64_t>(num_blocks, first + cache_->options().read_ahead_blocks);
+
+    for (uint64_t index = first; index < end; ++index) {
+      bool created = false;
+      auto block = cache_->get(BlockKey{file_, index}, block_length(index), &created);
+      if (!created) {
+        continue;
+      }
+
+      // a reader needing the block before the task runs loads it itself
+      detail::enqueue_io([self = RefCountPtr<CachedInputStream>(this), block, index]() {
+        if (block->try_start_loading()) {
+          self->load(block.get(), index);
+        }
+      });
+    }
+  }
+
+  RefCountPtr<BlockCache> cache_;
+  const uint64_t file_;
+  RefCountPtr<InputStream> base_;
+  const size_t size_;
+  const size_t block_size_;
+
+  std::atomic_size_t next_offset_{0};
+};
+
+// writes go to the base file system, the cached blocks of the file are dropped whenever its
+// content may have changed: on open, sync and close
+class CachedOutputStream : public Inherit<CachedOutputStream, OutputStream> {
+ public:
+  CachedOutputStream(RefCountPtr<BlockCache> cache, std::string uri, RefCountPtr<OutputStream> base)
+      : cache_(cache), uri_(std::move(uri)), base_(base) {}
+
+  ~CachedOutputStream() override {
+    // the base stream may only finish the file when it is destroyed
+    base_.reset(nullptr);
+    cache_->invalidate(uri_);
+  }
+
+  absl::Status write(size_t offset, size_t length, const void* data) override {
+    return base_->write(offset, length, data);
+  }
+
+  absl::Status sync() override {
+    LANCE_RETURN_IF_FAILED(base_->sync());
+
+    cache_->invalidate(uri_);
+    return absl::OkStatus();
+  }
+
+  absl::Status reserve(size_t size) override { return base_->reserve(size); }
+
+  size_t size() const override { return base_->size(); }
+
+ private:
+  RefCountPtr<BlockCache> cache_;
+  const std::string uri_;
+  RefCountPtr<OutputStream> base_;
+};
+
+class CachedFileSystem : public Inherit<CachedFileSystem, FileSystem> {
+ public:
+  CachedFileSystem(RefCountPtr<FileSystem> base, const CachedFileSystemOptions& options)
+      : base_(base), cache_(make_refcounted<BlockCache>(options)) {}
+
+  absl::StatusOr<RefCountPtr<InputStream>> create_input_stream(std::string_view uri) override {
+    LANCE_ASSIGN_OR_RETURN(base_stream, base_->create_input_stream(uri));
+
+    return make_refcounted<CachedInputStream>(cache_, cache_->file_id(uri), base_stream);
+  }
+
+  absl::StatusOr<RefCountPtr<OutputStream>> create_output_stream(std::string_view uri) override {
+    LANCE_ASSIGN_OR_RETURN(base_stream, base_->create_output_stream(uri));
+    cache_->invalidate(uri);
+
+    return make_refcounted<CachedOutputStream>(cache_, std::string(uri), base_stream);
+  }
+
+ private:
+  RefCountPtr<FileSystem> base_;
+  RefCountPtr<BlockCache> cache_;
+};
+}  // namespace
+
+absl::StatusOr<RefCountPtr<FileSystem>> create_cached_file_system(
+    RefCountPtr<FileSystem> base, const CachedFileSystemOptions& options) {
+  if (base.get() == nullptr) {
+    return absl::InvalidArgumentError("base file system is null");
+  }
+  if (options.block_size == 0) {
+    return absl::InvalidArgumentError("block_size must not be 0");
+  }
+
+  return make_refcounted<CachedFileSystem>(base, options);
+}
+}  // namespace core
+}  // namespace lance
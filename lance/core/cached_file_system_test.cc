@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "file_system.h"
+#include "gtest/gtest.h"
+
+namespace lance {
+namespace core {
+namespace {
+// stands in for network storage, every read sleeps for `latency` and is counted
+class SlowFileSystem : public Inherit<SlowFileSystem, FileSystem> {
+ public:
+  explicit SlowFileSystem(std::chrono::microseconds latency) : latency_(latency) {}
+
+  void add_file(const std::string& uri, std::string content) { files_[uri] = std::move(content); }
+
+  size_t reads() const { return reads_.load(); }
+
+  // reads starting at `offset`
+  size_t reads_at(size_t offset) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return reads_at_[offset];
+  }
+
+  absl::StatusOr<RefCountPtr<InputStream>> create_input_stream(std::string_view uri) override {
+    auto it = files_.find(std::string(uri));
+    if (it == files_.end()) {
+      return absl::NotFoundError(std::string(uri));
+    }
+
+    return make_refcounted<Stream>(this, &it->second);
+  }
+
+  absl::StatusOr<RefCountPtr<OutputStream>> create_output_stream(
+      std::string_view /*uri*/) override {
+    return absl::UnimplementedError("read only");
+  }
+
+ private:
+  class Stream : public Inherit<Stream, InputStream> {
+   public:
+    // `fs` outlives its streams in the tests
+    Stream(SlowFileSystem* fs, const std::string* content) : fs_(fs), content_(content) {}
+
+    absl::Status read(size_t offset, size_t length, void* out) override {
+      std::this_thread::sleep_for(fs_->latency_);
+      fs_->reads_.fetch_add(1);
+      {
+        std::lock_guard<std::mutex> lock(fs_->mutex_);
+        ++fs_->reads_at_[offset];
+      }
+
+      if (offset + length > content_->size()) {
+        return absl::OutOfRangeError("out of range");
+      }
+      std::memcpy(out, content_->data() + offset, length);
+      return absl::OkStatus();
+    }
+
+    size_t size() const override { return content_->size(); }
+
+   private:
+    SlowFileSystem* fs_;
+    const std::string* content_;
+  };
+
+  const std::chrono::microseconds latency_;
+  std::map<std::string, std::string> files_;
+
+  std::atomic_size_t reads_{0};
+  std::mutex mutex_;
+  std::map<size_t, size_t> reads_at_;
+};
+
+std::string make_content(size_t size) {
+  std::string content(size, 0);
+  for (size_t i = 0; i < size; ++i) {
+    content[i] = static_cast<char>(i * 131 + i / 251);
+  }
+  return content;
+}
+
+CachedFileSystemOptions make_options(size_t block_size, size_t capacity, size_t read_ahead) {
+  CachedFileSystemOptions options;
+  options.block_size = block_size;
+  options.capacity = capacity;
+  options.read_ahead_blocks = read_ahead;
+  return options;
+}
+}  // namespace
+
+TEST(cached_file_system, reads_match_base) {
+  const std::string content = make_content(100 * 1000 + 17);
+  auto slow = make_refcounted<SlowFileSystem>(std::chrono::microseconds(0));
+  slow->add_file("pack", content);
+
+  // a budget of a few blocks, so that blocks get evicted and read again
+  auto fs = create_cached_file_system(slow, make_options(4096, 4 * 4096, 2));
+  ASSERT_TRUE(fs.ok()) << fs.status();
+
+  auto stream = (*fs)->create_input_stream("pack");
+  ASSERT_TRUE(stream.ok()) << stream.status();
+  ASSERT_EQ(content.size(), (*stream)->size());
+
+  uint32_t state = 1;
+  for (int i = 0; i < 2000; ++i) {
+    state = state * 1664525u + 1013904223u;
+    const size_t offset = state % content.size();
+    const size_t length = std::min<size_t>((state >> 8) % 10000, content.size() - offset);
+
+    std::string buffer(length, 0);
+    ASSERT_TRUE((*stream)->read(offset, length, buffer.data()).ok());
+    ASSERT_EQ(content.substr(offset, length), buffer) << offset << ", " << length;
+  }
+
+  char byte = 0;
+  ASSERT_EQ(absl::StatusCode::kOutOfRange, (*stream)->read(content.size(), 1, &byte).code());
+  ASSERT_EQ(absl::StatusCode::kNotFound, (*fs)->create_input_stream("missing").status().code());
+}
+
+TEST(cached_file_system, small_reads_hit_the_cache) {
+  const std::string content = make_content(64 * 1024);
+  auto slow = make_refcounted<SlowFileSystem>(std::chrono::microseconds(100));
+  slow->add_file("pack", content);
+
+  auto fs = create_cached_file_system(slow, make_options(16 * 1024, 1 << 20, 0));
+  ASSERT_TRUE(fs.ok()) << fs.status();
+
+  // streams of the same uri share blocks
+  for (int pass = 0; pass < 3; ++pass) {
+    auto stream = (*fs)->create_input_stream("pack");
+    ASSERT_TRUE(stream.ok()) << stream.status();
+
+    char buffer[64];
+    for (size_t offset = 0; offset + sizeof(buffer) <= content.size(); offset += 100) {
+      ASSERT_TRUE((*stream)->read(offset, sizeof(buffer), buffer).ok());
+      ASSERT_EQ(0, std::memcmp(buffer, content.data() + offset, sizeof(buffer)));
+    }
+  }
+
+  ASSERT_EQ(4, slow->reads());
+}
+
+TEST(cached_file_system, concurrent_readers_share_a_load) {
+  const std::string content = make_content(64 * 1024);
+  auto slow = make_refcounted<SlowFileSystem>(std::chrono::milliseconds(20));
+  slow->add_file("pack", content);
+
+  auto fs = create_cached_file_system(slow, make_options(64 * 1024, 1 << 20, 0));
+  ASSERT_TRUE(fs.ok()) << fs.status();
+
+  std::vector<std::thread> threads;
+  std::atomic_int failures{0};
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([&, i]() {
+      auto stream = (*fs)->create_input_stream("pack");
+      char buffer[256];
+      if (!stream.ok() || !(*stream)->read(i * 1000, sizeof(buffer), buffer).ok() ||
+          std::memcmp(buffer, content.data() + i * 1000, sizeof(buffer)) != 0) {
+        failures.fetch_add(1);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_EQ(0, failures.load());
+  ASSERT_EQ(1, slow->reads());
+}
+
+TEST(cached_file_system, sequential_reads_fetch_ahead) {
+  constexpr size_t kBlockSize = 4096;
+  const std::string content = make_content(16 * kBlockSize);
+  auto slow = make_refcounted<SlowFileSystem>(std::chrono::milliseconds(1));
+  slow->add_file("pack", content);
+
+  auto fs = create_cached_file_system(slow, make_options(kBlockSize, 1 << 20, 4));
+  ASSERT_TRUE(fs.ok()) << fs.status();
+
+  auto stream = (*fs)->create_input_stream("pack");
+  ASSERT_TRUE(stream.ok()) << stream.status();
+
+  char buffer[512];
+  ASSERT_TRUE((*stream)->read(0, sizeof(buffer), buffer).ok());
+
+  // the next four blocks arrive without being asked for
+  for (int i = 0; i < 1000 && slow->reads() < 5; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  for (size_t index = 1; index <= 4; ++index) {
+    ASSERT_EQ(1, slow->reads_at(index * kBlockSize)) << index;
+  }
+  ASSERT_EQ(0, slow->reads_at(5 * kBlockSize));
+
+  // reading on keeps the window ahead, and every block is read once
+  std::string out(content.size(), 0);
+  ASSERT_TRUE((*stream)->read(0, sizeof(buffer), out.data()).ok());
+  for (size_t offset = sizeof(buffer); offset < content.size(); offset += sizeof(buffer)) {
+    ASSERT_TRUE((*stream)->read(offset, sizeof(buffer), out.data() + offset).ok());
+  }
+  ASSERT_EQ(content, out);
+
+  for (size_t index = 0; index < 16; ++index) {
+    ASSERT_EQ(1, slow->reads_at(index * kBlockSize)) << index;
+  }
+}
+
+TEST(cached_file_system, reads_after_rewrite) {
+  const std::string path = ::testing::TempDir() + "cached_rewrite.bin";
+  auto local = create_local_file_system();
+  ASSERT_TRUE(local.ok()) << local.status();
+  auto fs = create_cached_file_system(*local, make_options(4096, 64 * 4096, 0));
+  ASSERT_TRUE(fs.ok()) << fs.status();
+
+  const auto write = [&](const std::string& content) {
+    auto stream = (*fs)->create_output_stream(path);
+    ASSERT_TRUE(stream.ok()) << stream.status();
+    ASSERT_TRUE((*stream)->write(0, content.size(), content.data()).ok());
+  };
+  const auto read = [&]() {
+    auto stream = (*fs)->create_input_stream(path);
+    EXPECT_TRUE(stream.ok()) << stream.status();
+    std::string content((*stream)->size(), 0);
+    EXPECT_TRUE((*stream)->read(0, content.size(), content.data()).ok());
+    return content;
+  };
+
+  const std::string first = make_content(3 * 4096 + 5);
+  write(first);
+  ASSERT_EQ(first, read());
+
+  // same size, different bytes, so only stale blocks could tell
+  std::string second = first;
+  std::reverse(second.begin(), second.end());
+  write(second);
+  ASSERT_EQ(second, read());
+}
+}  // namespace core
+}  // namespace lance
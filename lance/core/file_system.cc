@@ -1,16 +1,482 @@
 #include "file_system.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+
+#include "absl/strings/str_format.h"
+#include "async_read.h"
+#include "glog/logging.h"
+
+#if defined(_WIN64)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
 namespace lance {
 namespace core {
+absl::StatusOr<core::RefCountPtr<Blob>> InputStream::map(size_t offset, size_t length) {
+  if (offset > size() || length > size() - offset) {
+    return absl::OutOfRangeError(
+        absl::StrFormat("offset: %d, length: %d, size: %d", offset, length, size()));
+  }
+
+  void* data = std::malloc(length);
+  auto blob = Blob::adopt(data, length, [](void* data, size_t) { std::free(data); });
+
+  LANCE_RETURN_IF_FAILED(read(offset, length, data));
+
+  return blob;
+}
+
+absl::StatusOr<core::RefCountPtr<ReadBatch>> InputStream::read_async(
+    absl::Span<const ReadRequest> requests, ReadCallback callback) {
+  auto batch = make_refcounted<detail::AsyncReadBatch>(RefCountPtr<Object>(this), requests.size(),
+                                                       std::move(callback));
+  detail::submit_pool_reads(this, requests, batch);
+
+  return batch;
+}
 
 namespace {
+std::string_view strip_scheme(std::string_view uri) {
+  constexpr std::string_view kScheme = "file://";
+  if (uri.substr(0, kScheme.size()) == kScheme) {
+    uri.remove_prefix(kScheme.size());
+  }
+  return uri;
+}
+
+// read-only mapping of a whole file, the mapping itself is a blob so that views of it can outlive
+// the stream
+class MappedFile : public Inherit<MappedFile, Object> {
+ public:
+  static absl::StatusOr<RefCountPtr<MappedFile>> open(const std::string& path);
+
+#if defined(_WIN64)
+  MappedFile(HANDLE file, RefCountPtr<Blob> mapping) : file_(file), mapping_(mapping) {}
+#else
+  MappedFile(int fd, RefCountPtr<Blob> mapping) : fd_(fd), mapping_(mapping) {}
+
+  int fd() const { return fd_; }
+#endif
+
+  ~MappedFile() override;
+
+  const uint8_t* data() const { return static_cast<const uint8_t*>(mapping_->data()); }
+
+  size_t size() const { return mapping_->size(); }
+
+  RefCountPtr<Blob> slice(size_t offset, size_t length) const {
+    return mapping_->slice(offset, length);
+  }
+
+  // hint the kernel that [offset, offset + length) is about to be accessed
+  void will_need(size_t offset, size_t length) const;
+
+ private:
+#if defined(_WIN64)
+  HANDLE file_ = INVALID_HANDLE_VALUE;
+#else
+  int fd_ = -1;
+#endif
+
+  RefCountPtr<Blob> mapping_;
+};
+
+#if defined(_WIN64)
+absl::StatusOr<RefCountPtr<MappedFile>> MappedFile::open(const std::string& path) {
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return absl::NotFoundError(
+        absl::StrFormat("failed to open file, path: %s, err: %d", path, GetLastError()));
+  }
+
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size)) {
+    CloseHandle(file);
+    return absl::UnknownError(absl::StrFormat("failed to get file size, path: %s", path));
+  }
+
+  // empty files can not be mapped
+  if (file_size.QuadPart == 0) {
+    return make_refcounted<MappedFile>(file, Blob::adopt(nullptr, 0, nullptr));
+  }
+
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping == nullptr) {
+    CloseHandle(file);
+    return absl::UnknownError(absl::StrFormat("failed to create file mapping, path: %s", path));
+  }
+
+  // the view keeps the mapping object alive
+  void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+  if (data == nullptr) {
+    CloseHandle(file);
+    return absl::UnknownError(absl::StrFormat("failed to map view of file, path: %s", path));
+  }
+
+  return make_refcounted<MappedFile>(
+      file, Blob::adopt_mapping(data, static_cast<size_t>(file_size.QuadPart)));
+}
+
+MappedFile::~MappedFile() {
+  if (file_ != INVALID_HANDLE_VALUE) {
+    CloseHandle(file_);
+  }
+}
+
+void MappedFile::will_need(size_t offset, size_t length) const {
+  WIN32_MEMORY_RANGE_ENTRY entry;
+  entry.VirtualAddress = const_cast<uint8_t*>(data()) + offset;
+  entry.NumberOfBytes = length;
+  PrefetchVirtualMemory(GetCurrentProcess(), 1, &entry, 0);
+}
+#else
+absl::StatusOr<RefCountPtr<MappedFile>> MappedFile::open(const std::string& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return absl::NotFoundError(
+        absl::StrFormat("failed to open file, path: %s, err: %s", path, std::strerror(errno)));
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    const int err = errno;
+    ::close(fd);
+    return absl::UnknownError(
+        absl::StrFormat("failed to stat file, path: %s, err: %s", path, std::strerror(err)));
+  }
+
+  const size_t size = static_cast<size_t>(st.st_size);
+
+  // empty files can not be mapped
+  if (size == 0) {
+    return make_refcounted<MappedFile>(fd, Blob::adopt(nullptr, 0, nullptr));
+  }
+
+  void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    const int err = errno;
+    ::close(fd);
+    return absl::UnknownError(
+        absl::StrFormat("failed to mmap file, path: %s, err: %s", path, std::strerror(err)));
+  }
+
+  return make_refcounted<MappedFile>(fd, Blob::adopt_mapping(data, size));
+}
+
+MappedFile::~MappedFile() {
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+}
+
+void MappedFile::will_need(size_t offset, size_t length) const {
+  // madvise requires a page aligned address
+  static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+  const size_t begin = offset / page_size * page_size;
+  madvise(const_cast<uint8_t*>(data()) + begin, offset + length - begin, MADV_WILLNEED);
+}
+#endif
+
 class LocalInputStream : public Inherit<LocalInputStream, InputStream> {
  public:
+  explicit LocalInputStream(RefCountPtr<MappedFile> file) : file_(file) {}
+
+  absl::Status read(size_t offset, size_t length, void* out) override {
+    LANCE_RETURN_IF_FAILED(check_range(offset, length));
+
+    if (length > 0) {
+      std::memcpy(out, file_->data() + offset, length);
+    }
+
+    return absl::OkStatus();
+  }
+
+  size_t size() const override { return file_->size(); }
+
+  absl::StatusOr<RefCountPtr<Blob>> map(size_t offset, size_t length) override {
+    LANCE_RETURN_IF_FAILED(check_range(offset, length));
+
+    if (length > 0) {
+      file_->will_need(offset, length);
+    }
+
+    return file_->slice(offset, length);
+  }
+
+  absl::StatusOr<RefCountPtr<ReadBatch>> read_async(absl::Span<const ReadRequest> requests,
+                                                    ReadCallback callback) override {
+    for (const auto& request : requests) {
+      LANCE_RETURN_IF_FAILED(check_range(request.offset, request.length));
+    }
+
+#if !defined(_WIN64)
+    // read through the file descriptor, so that page faults never stall the caller
+    auto batch = make_refcounted<detail::AsyncReadBatch>(RefCountPtr<Object>(this),
+                                                         requests.size(), callback);
+    if (detail::submit_io_uring_reads(file_->fd(), requests, batch)) {
+      return batch;
+    }
+#endif
+
+    return InputStream::read_async(requests, std::move(callback));
+  }
+
+ private:
+  absl::Status check_range(size_t offset, size_t length) const {
+    if (offset > file_->size() || length > file_->size() - offset) {
+      return absl::OutOfRangeError(
+          absl::StrFormat("offset: %d, length: %d, size: %d", offset, length, file_->size()));
+    }
+
+    return absl::OkStatus();
+  }
+
+  RefCountPtr<MappedFile> file_;
+};
+
+#if !defined(_WIN64)
+// writes go to a shared mapping of the file. the file is preallocated ahead of the writes, and
+// once enough bytes are dirty an io thread asks the kernel to start writing them back.
+class LocalOutputStream : public Inherit<LocalOutputStream, OutputStream> {
+ public:
+  static absl::StatusOr<RefCountPtr<LocalOutputStream>> open(const std::string& path);
+
+  LocalOutputStream(int fd, std::string path) : fd_(fd), path_(std::move(path)) {}
+
+  // trims the preallocated tail, without waiting for the data to be durable
+  ~LocalOutputStream() override;
+
+  absl::Status write(size_t offset, size_t length, const void* data) override;
+
+  absl::Status sync() override;
+
+  absl::Status reserve(size_t size) override {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    return reserve_locked(size);
+  }
+
+  size_t size() const override { return size_.load(std::memory_order_acquire); }
+
+ private:
+  static constexpr size_t kMinCapacity = 1024 * 1024;
+  static constexpr size_t kMaxGrowth = 64 * 1024 * 1024;
+
+  // dirty bytes which trigger a background writeback
+  static constexpr size_t kFlushThreshold = 4 * 1024 * 1024;
+
+  // grow the file and its mapping to hold at least `size` bytes, the exclusive lock is held
+  absl::Status reserve_locked(size_t size);
+
+  void unmap_locked();
+
+  // raises size_ to `end`, the lock is held
+  void advance_size(size_t end);
+
+  void schedule_flush(size_t length);
+
+  const int fd_;
+  const std::string path_;
+
+  // shared by writers, exclusive while the mapping changes
+  std::shared_mutex mutex_;
+  uint8_t* data_ = nullptr;
+  size_t capacity_ = 0;
+
+  std::atomic_size_t size_{0};
+  std::atomic_size_t unflushed_{0};
 };
 
-class LocalFileSystem : public Inherit<LocalFileSystem, FileSystem> {};
+absl::StatusOr<RefCountPtr<LocalOutputStream>> LocalOutputStream::open(const std::string& path) {
+  const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return absl::NotFoundError(
+        absl::StrFormat("failed to open file, path: %s, err: %s", path, std::strerror(errno)));
+  }
+
+  return make_refcounted<LocalOutputStream>(fd, path);
+}
+
+LocalOutputStream::~LocalOutputStream() {
+  unmap_locked();
+
+  if (ftruncate(fd_, static_cast<off_t>(size_.load())) != 0) {
+    LOG(ERROR) << "failed to truncate file, path: " << path_ << ", err: " << std::strerror(errno);
+  }
+  ::close(fd_);
+}
+
+absl::Status LocalOutputStream::write(size_t offset, size_t length, const void* data) {
+  if (length == 0) {
+    return absl::OkStatus();
+  }
+
+  const size_t end = offset + length;
+  if (end < offset) {
+    return absl::OutOfRangeError(absl::StrFormat("offset: %d, length: %d", offset, length));
+  }
+
+  // the size is published before the lock is dropped, so that sync() never truncates bytes a
+  // write already copied
+  bool written = false;
+  {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (end <= capacity_) {
+      std::memcpy(data_ + offset, data, length);
+      advance_size(end);
+      written = true;
+    }
+  }
+
+  if (!written) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    LANCE_RETURN_IF_FAILED(reserve_locked(end));
+    std::memcpy(data_ + offset, data, length);
+    advance_size(end);
+  }
+
+  schedule_flush(length);
+
+  return absl::OkStatus();
+}
+
+void LocalOutputStream::advance_size(size_t end) {
+  size_t size = size_.load(std::memory_order_relaxed);
+  while (size < end &&
+         !size_.compare_exchange_weak(size, end, std::memory_order_release,
+                                      std::memory_order_relaxed)) {
+  }
+}
+
+absl::Status LocalOutputStream::sync() {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+
+  if (data_ && msync(data_, capacity_, MS_SYNC) != 0) {
+    return absl::UnknownError(
+        absl::StrFormat("failed to msync file, path: %s, err: %s", path_, std::strerror(errno)));
+  }
+
+  // drop the preallocated tail, so that the file on disk is exactly what was written. the mapping
+  // has to go first, touching pages past the end of the file would fault.
+  unmap_locked();
+  if (ftruncate(fd_, static_cast<off_t>(size_.load())) != 0) {
+    return absl::UnknownError(
+        absl::StrFormat("failed to truncate file, path: %s, err: %s", path_, std::strerror(errno)));
+  }
+
+#if defined(__linux__)
+  const int ret = fdatasync(fd_);
+#else
+  const int ret = fsync(fd_);
+#endif
+  if (ret != 0) {
+    return absl::UnknownError(
+        absl::StrFormat("failed to sync file, path: %s, err: %s", path_, std::strerror(errno)));
+  }
+
+  unflushed_.store(0, std::memory_order_relaxed);
+
+  return absl::OkStatus();
+}
+
+absl::Status LocalOutputStream::reserve_locked(size_t size) {
+  if (size <= capacity_) {
+    return absl::OkStatus();
+  }
+
+  static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+  // double up to kMaxGrowth at a time, from what was written when the mapping was dropped by sync
+  const size_t base = std::max(capacity_, size_.load());
+  size_t capacity = std::max({size, base + std::min(base, kMaxGrowth), kMinCapacity});
+  capacity = (capacity + page_size - 1) / page_size * page_size;
+
+  // allocate the blocks up front, file systems without fallocate get a sparse file
+  int err = posix_fallocate(fd_, 0, static_cast<off_t>(capacity));
+  if (err == EOPNOTSUPP || err == EINVAL) {
+    err = ftruncate(fd_, static_cast<off_t>(capacity)) == 0 ? 0 : errno;
+  }
+  if (err != 0) {
+    return absl::ResourceExhaustedError(absl::StrFormat(
+        "failed to grow file, path: %s, size: %d, err: %s", path_, capacity, std::strerror(err)));
+  }
+
+  unmap_locked();
+
+  void* data = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (data == MAP_FAILED) {
+    return absl::UnknownError(
+        absl::StrFormat("failed to mmap file, path: %s, err: %s", path_, std::strerror(errno)));
+  }
+
+  data_ = static_cast<uint8_t*>(data);
+  capacity_ = capacity;
+
+  return absl::OkStatus();
+}
+
+void LocalOutputStream::unmap_locked() {
+  if (data_) {
+    munmap(data_, capacity_);
+    data_ = nullptr;
+    capacity_ = 0;
+  }
+}
+
+void LocalOutputStream::schedule_flush(size_t length) {
+#if defined(__linux__)
+  size_t unflushed = unflushed_.fetch_add(length, std::memory_order_relaxed) + length;
+  if (unflushed < kFlushThreshold ||
+      !unflushed_.compare_exchange_strong(unflushed, 0, std::memory_order_relaxed)) {
+    return;
+  }
+
+  // starts writeback of the dirty pages without waiting for it, may still block on a congested
+  // device, hence the io thread
+  detail::enqueue_io([self = RefCountPtr<LocalOutputStream>(this)]() {
+    sync_file_range(self->fd_, 0, 0, SYNC_FILE_RANGE_WRITE);
+  });
+#endif
+}
+#endif
+
+class LocalFileSystem : public Inherit<LocalFileSystem, FileSystem> {
+ public:
+  absl::StatusOr<RefCountPtr<InputStream>> create_input_stream(std::string_view uri) override {
+    LANCE_ASSIGN_OR_RETURN(file, MappedFile::open(std::string(strip_scheme(uri))));
+
+    return make_refcounted<LocalInputStream>(file);
+  }
+
+  absl::StatusOr<RefCountPtr<OutputStream>> create_output_stream(std::string_view uri) override {
+#if defined(_WIN64)
+    return absl::UnimplementedError(absl::StrFormat("uri: %s", uri));
+#else
+    LANCE_ASSIGN_OR_RETURN(stream, LocalOutputStream::open(std::string(strip_scheme(uri))));
+
+    return stream;
+#endif
+  }
+};
 }  // namespace
 
-absl::StatusOr<core::RefCountPtr<FileSystem>> create_local_file_system() { return nullptr; }
+absl::StatusOr<core::RefCountPtr<FileSystem>> create_local_file_system() {
+  return make_refcounted<LocalFileSystem>();
+}
 }  // namespace core
-}  // namespace lance
\ No newline at end of file
+}  // namespace lance
@@ -1,20 +1,66 @@
 #pragma once
 
+#include <functional>
 #include <string_view>
 
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "object.h"
 
 namespace lance {
 namespace core {
+struct ReadRequest {
+  size_t offset = 0;
+  size_t length = 0;
+  void* out = nullptr;
+};
+
+// called once per request with its index in the batch. may run on an io thread, or on the calling
+// thread before read_async returns. must not block, e.g. on waiting for another batch, since it
+// holds up the completion of every other read; submitting more reads is fine.
+using ReadCallback = std::function<void(size_t index, const absl::Status& status)>;
+
+class ReadBatch : public core::Inherit<ReadBatch, core::Object> {
+ public:
+  // true once every request of the batch completed
+  virtual bool done() const = 0;
+
+  // block until every request completed, returns the first error
+  virtual absl::Status wait() = 0;
+};
+
 class InputStream : public core::Inherit<InputStream, core::Object> {
  public:
   virtual absl::Status read(size_t offset, size_t length, void* out) = 0;
+
+  // submit a batch of reads without blocking, the destination buffers must stay valid until the
+  // batch is done. the default implementation runs read() on a shared io thread pool, local
+  // streams use io_uring when the kernel supports it.
+  virtual absl::StatusOr<core::RefCountPtr<ReadBatch>> read_async(
+      absl::Span<const ReadRequest> requests, ReadCallback callback = nullptr);
+
+  // size of the stream in bytes
+  virtual size_t size() const = 0;
+
+  // view [offset, offset + length) of the stream as a blob. the default implementation copies, the
+  // local file system returns a zero-copy view into the page cache.
+  virtual absl::StatusOr<core::RefCountPtr<Blob>> map(size_t offset, size_t length);
 };
 
 class OutputStream : public core::Inherit<OutputStream, core::Object> {
  public:
+  // copy `data` to [offset, offset + length) of the stream, growing it as needed. writes may land
+  // in memory first, they are only durable after sync().
   virtual absl::Status write(size_t offset, size_t length, const void* data) = 0;
+
+  // block until every write issued before the call is durable
+  virtual absl::Status sync() = 0;
+
+  // hint that the stream will grow to at least `size` bytes
+  virtual absl::Status reserve([[maybe_unused]] size_t size) { return absl::OkStatus(); }
+
+  // end of the furthest write
+  virtual size_t size() const = 0;
 };
 
 class FileSystem : public core::Inherit<FileSystem, core::Object> {
@@ -26,6 +72,27 @@ class FileSystem : public core::Inherit<FileSystem, core::Object> {
       std::string_view uri) = 0;
 };
 
+// file system over local files, input streams are backed by read-only memory mappings. output
+// streams create or truncate the file and write into a shared mapping of it, the file is grown
+// ahead of the writes and the kernel is asked to start writeback in the background, so that a
+// write is a memcpy. uris are plain paths, optionally prefixed with "file://".
 absl::StatusOr<core::RefCountPtr<FileSystem>> create_local_file_system();
+
+struct CachedFileSystemOptions {
+  size_t block_size = 64 * 1024;
+
+  // bytes of blocks kept in memory, least recently used blocks are evicted beyond it
+  size_t capacity = 64 * 1024 * 1024;
+
+  // blocks fetched in the background ahead of a sequential reader, 0 disables read-ahead
+  size_t read_ahead_blocks = 4;
+};
+
+// file system caching the input streams of `base` in fixed-size blocks, for storage where every
+// read pays a high latency. concurrent reads of a missing block share a single read of `base`.
+// streams opened with the same uri share blocks, files must not change while they are cached.
+// output streams go straight to `base`.
+absl::StatusOr<core::RefCountPtr<FileSystem>> create_cached_file_system(
+    core::RefCountPtr<FileSystem> base, const CachedFileSystemOptions& options = {});
 }  // namespace core
 }  // namespace lance
@@ -0,0 +1,304 @@
+#include "file_system.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace lance {
+namespace core {
+namespace {
+std::string write_temp_file(const std::string& name, const std::string& content) {
+  const std::string path = ::testing::TempDir() + name;
+
+  FILE* f = std::fopen(path.c_str(), "wb");
+  EXPECT_NE(nullptr, f);
+  std::fwrite(content.data(), 1, content.size(), f);
+  std::fclose(f);
+
+  return path;
+}
+
+class MemoryInputStream : public Inherit<MemoryInputStream, InputStream> {
+ public:
+  explicit MemoryInputStream(std::string content) : content_(std::move(content)) {}
+
+  absl::Status read(size_t offset, size_t length, void* out) override {
+    if (offset + length > content_.size()) {
+      return absl::OutOfRangeError("out of range");
+    }
+
+    std::memcpy(out, content_.data() + offset, length);
+    return absl::OkStatus();
+  }
+
+  size_t size() const override { return content_.size(); }
+
+ private:
+  std::string content_;
+};
+
+std::string read_file(FileSystem* fs, const std::string& path) {
+  auto stream = fs->create_input_stream(path);
+  EXPECT_TRUE(stream.ok()) << stream.status();
+
+  std::string content((*stream)->size(), 0);
+  EXPECT_TRUE((*stream)->read(0, content.size(), content.data()).ok());
+  return content;
+}
+
+std::string make_content(size_t size) {
+  std::string content(size, 0);
+  for (size_t i = 0; i < size; ++i) {
+    content[i] = static_cast<char>(i * 31 + 7);
+  }
+  return content;
+}
+
+// issue `count` reads of `length` bytes at a stride of `length`, and check the results
+void check_read_async(InputStream* stream, const std::string& content, size_t count,
+                      size_t length) {
+  std::vector<std::string> buffers(count, std::string(length, 0));
+  std::vector<ReadRequest> requests(count);
+  for (size_t i = 0; i < count; ++i) {
+    requests[i] = ReadRequest{i * length, length, buffers[i].data()};
+  }
+
+  std::atomic_size_t completed{0};
+  auto batch = stream->read_async(requests, [&](size_t index, const absl::Status& status) {
+    EXPECT_TRUE(status.ok()) << status;
+    EXPECT_LT(index, count);
+    completed.fetch_add(1);
+  });
+  ASSERT_TRUE(batch.ok()) << batch.status();
+  ASSERT_TRUE((*batch)->wait().ok());
+  ASSERT_TRUE((*batch)->done());
+  ASSERT_EQ(count, completed.load());
+
+  for (size_t i = 0; i < count; ++i) {
+    ASSERT_EQ(content.substr(i * length, length), buffers[i]) << i;
+  }
+}
+}  // namespace
+
+TEST(file_system, local_read) {
+  const std::string content = "hello, memory mapped world";
+  const std::string path = write_temp_file("local_read.txt", content);
+
+  auto fs = create_local_file_system();
+  ASSERT_TRUE(fs.ok()) << fs.status();
+
+  auto stream = (*fs)->create_input_stream("file://" + path);
+  ASSERT_TRUE(stream.ok()) << stream.status();
+  ASSERT_EQ(content.size(), (*stream)->size());
+
+  char buffer[6] = {};
+  ASSERT_TRUE((*stream)->read(7, 6, buffer).ok());
+  ASSERT_EQ(0, std::memcmp(buffer, "memory", 6));
+
+  ASSERT_EQ(absl::StatusCode::kOutOfRange, (*stream)->read(content.size() - 2, 3, buffer).code());
+}
+
+TEST(file_system, local_map_outlives_stream) {
+  const std::string content(1 << 16, 'x');
+  const std::string path = write_temp_file("local_map.bin", content);
+
+  auto fs = create_local_file_system();
+  ASSERT_TRUE(fs.ok()) << fs.status();
+
+  absl::StatusOr<RefCountPtr<Blob>> blob;
+  {
+    auto stream = (*fs)->create_input_stream(path);
+    ASSERT_TRUE(stream.ok()) << stream.status();
+
+    blob = (*stream)->map(4096 + 3, 1000);
+    ASSERT_TRUE(blob.ok()) << blob.status();
+
+    ASSERT_EQ(absl::StatusCode::kOutOfRange, (*stream)->map(content.size(), 1).status().code());
+  }
+
+  ASSERT_EQ(1000, (*blob)->size());
+  ASSERT_EQ(0, std::memcmp((*blob)->data(), content.data(), 1000));
+}
+
+TEST(file_system, local_read_async) {
+  const std::string content = make_content(1 << 20);
+  const std::string path = write_temp_file("local_read_async.bin", content);
+
+  auto fs = create_local_file_system();
+  ASSERT_TRUE(fs.ok()) << fs.status();
+
+  auto stream = (*fs)->create_input_stream(path);
+  ASSERT_TRUE(stream.ok()) << stream.status();
+
+  // more requests than the ring holds at once
+  check_read_async(stream->get(), content, 1024, 1024);
+
+  std::vector<ReadRequest> requests = {{content.size() - 1, 2, nullptr}};
+  ASSERT_EQ(absl::StatusCode::kOutOfRange, (*stream)->read_async(requests).status().code());
+}
+
+TEST(file_system, local_read_async_from_callback) {
+  const std::string content = make_content(1 << 20);
+  const std::string path = write_temp_file("local_read_async_from_callback.bin", content);
+
+  auto fs = create_local_file_system();
+  ASSERT_TRUE(fs.ok()) << fs.status();
+
+  auto stream = (*fs)->create_input_stream(path);
+  ASSERT_TRUE(stream.ok()) << stream.status();
+
+  // the callback submits more reads than the ring holds, while none of them can complete before
+  // it returns
+  constexpr size_t kCount = 2048;
+  constexpr size_t kLength = 512;
+  std::vector<std::string> buffers(kCount, std::string(kLength, 0));
+  std::vector<ReadRequest> requests(kCount);
+  for (size_t i = 0; i < kCount; ++i) {
+    requests[i] = ReadRequest{i * kLength, kLength, buffers[i].data()};
+  }
+
+  char first[4] = {};
+  std::vector<ReadRequest> first_requests = {{0, 4, first}};
+  absl::StatusOr<RefCountPtr<ReadBatch>> second;
+  auto batch = (*stream)->read_async(first_requests, [&](size_t, const absl::Status& status) {
+    EXPECT_TRUE(status.ok()) << status;
+    second = (*stream)->read_async(requests);
+  });
+  ASSERT_TRUE(batch.ok()) << batch.status();
+  ASSERT_TRUE((*batch)->wait().ok());
+
+  ASSERT_TRUE(second.ok()) << second.status();
+  ASSERT_TRUE((*second)->wait().ok());
+  for (size_t i = 0; i < kCount; ++i) {
+    ASSERT_EQ(content.substr(i * kLength, kLength), buffers[i]) << i;
+  }
+}
+
+TEST(file_system, default_read_async) {
+  const std::string content = make_content(1 << 16);
+  auto stream = make_refcounted<MemoryInputStream>(content);
+
+  check_read_async(stream.get(), content, 256, 256);
+
+  // errors are reported per request and by wait()
+  char buffer[4];
+  std::vector<ReadRequest> requests = {{0, 4, buffer}, {content.size(), 4, buffer}};
+  auto batch = stream->read_async(requests);
+  ASSERT_TRUE(batch.ok()) << batch.status();
+  ASSERT_EQ(absl::StatusCode::kOutOfRange, (*batch)->wait().code());
+}
+
+TEST(file_system, local_write) {
+  const std::string path = ::testing::TempDir() + "local_write.bin";
+  auto fs = create_local_file_system();
+  ASSERT_TRUE(fs.ok()) << fs.status();
+
+  // bigger than the first preallocation and the flush threshold, written back to front
+  const std::string content = make_content(9 * 1024 * 1024 + 123);
+  auto stream = (*fs)->create_output_stream("file://" + path);
+  ASSERT_TRUE(stream.ok()) << stream.status();
+
+  constexpr size_t kChunk = 64 * 1024;
+  for (size_t end = content.size(); end > 0;) {
+    const size_t begin = end > kChunk ? end - kChunk : 0;
+    ASSERT_TRUE((*stream)->write(begin, end - begin, content.data() + begin).ok());
+    end = begin;
+  }
+  ASSERT_EQ(content.size(), (*stream)->size());
+
+  ASSERT_TRUE((*stream)->sync().ok());
+  ASSERT_EQ(content, read_file(fs->get(), path));
+
+  // writing on after a sync
+  ASSERT_TRUE((*stream)->write(content.size(), 5, "tail!").ok());
+  ASSERT_TRUE((*stream)->write(0, 4, "head").ok());
+  ASSERT_TRUE((*stream)->sync().ok());
+
+  const std::string updated = read_file(fs->get(), path);
+  ASSERT_EQ(content.size() + 5, updated.size());
+  ASSERT_EQ("head", updated.substr(0, 4));
+  ASSERT_EQ("tail!", updated.substr(content.size()));
+}
+
+TEST(file_system, local_write_concurrent) {
+  const std::string path = ::testing::TempDir() + "local_write_concurrent.bin";
+  auto fs = create_local_file_system();
+  ASSERT_TRUE(fs.ok()) << fs.status();
+
+  const std::string content = make_content(4 * 1024 * 1024);
+  {
+    auto stream = (*fs)->create_output_stream(path);
+    ASSERT_TRUE(stream.ok()) << stream.status();
+
+    // interleaved chunks, so that the file grows while others write
+    constexpr size_t kThreads = 4;
+    constexpr size_t kChunk = 4096;
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < kThreads; ++t) {
+      threads.emplace_back([&, t]() {
+        for (size_t offset = t * kChunk; offset < content.size(); offset += kThreads * kChunk) {
+          EXPECT_TRUE((*stream)->write(offset, kChunk, content.data() + offset).ok());
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  // destroying the stream trims the preallocated tail as well
+  ASSERT_EQ(content, read_file(fs->get(), path));
+}
+
+TEST(file_system, local_write_concurrent_sync) {
+  const std::string path = ::testing::TempDir() + "local_write_concurrent_sync.bin";
+  auto fs = create_local_file_system();
+  ASSERT_TRUE(fs.ok()) << fs.status();
+
+  const std::string content = make_content(4 * 1024 * 1024);
+  {
+    auto stream = (*fs)->create_output_stream(path);
+    ASSERT_TRUE(stream.ok()) << stream.status();
+
+    // syncs truncate the file to its size while writes are copying
+    constexpr size_t kThreads = 4;
+    constexpr size_t kChunk = 4096;
+    std::atomic_bool writing{true};
+    std::thread syncer([&]() {
+      while (writing.load()) {
+        EXPECT_TRUE((*stream)->sync().ok());
+      }
+    });
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < kThreads; ++t) {
+      threads.emplace_back([&, t]() {
+        for (size_t offset = t * kChunk; offset < content.size(); offset += kThreads * kChunk) {
+          EXPECT_TRUE((*stream)->write(offset, kChunk, content.data() + offset).ok());
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    writing.store(false);
+    syncer.join();
+  }
+
+  ASSERT_EQ(content, read_file(fs->get(), path));
+}
+
+TEST(file_system, local_missing_file) {
+  auto fs = create_local_file_system();
+  ASSERT_TRUE(fs.ok()) << fs.status();
+
+  auto stream = (*fs)->create_input_stream(::testing::TempDir() + "does_not_exist");
+  ASSERT_EQ(absl::StatusCode::kNotFound, stream.status().code());
+}
+}  // namespace core
+}  // namespace lance
@@ -0,0 +1,80 @@
+#include "interned_string.h"
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "glog/logging.h"
+
+namespace lance {
+namespace core {
+namespace {
+// ids index fixed size chunks of views, so that a chunk never moves once published and str()
+// reads it without the lock. whoever got an id from intern() sees its view.
+class InternTable {
+ public:
+  static constexpr size_t kChunkSize = 4096;
+  static constexpr size_t kMaxChunks = 4096;
+
+  InternTable() { intern(""); }
+
+  uint32_t intern(std::string_view str) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = ids_.find(str);
+    if (it != ids_.end()) {
+      return it->second;
+    }
+
+    const auto id = static_cast<uint32_t>(strings_.size());
+    const size_t chunk = id / kChunkSize;
+    CHECK_LT(chunk, kMaxChunks) << "too many interned strings";
+
+    // the deque never moves its elements, views into them stay valid
+    const std::string& stored = strings_.emplace_back(str);
+
+    std::string_view* views = chunks_[chunk].load(std::memory_order_relaxed);
+    if (views == nullptr) {
+      views = new std::string_view[kChunkSize];
+      chunks_[chunk].store(views, std::memory_order_release);
+    }
+    views[id % kChunkSize] = stored;
+
+    ids_.emplace(stored, id);
+    return id;
+  }
+
+  std::string_view str(uint32_t id) const {
+    const std::string_view* views = chunks_[id / kChunkSize].load(std::memory_order_acquire);
+    return views[id % kChunkSize];
+  }
+
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return strings_.size();
+  }
+
+ private:
+  mutable std::mutex mutex_;
+  std::deque<std::string> strings_;
+  std::unordered_map<std::string_view, uint32_t> ids_;
+
+  std::atomic<std::string_view*> chunks_[kMaxChunks] = {};
+};
+
+// leaked, interned strings may be used from static destructors
+InternTable* intern_table() {
+  static auto* table = new InternTable();
+  return table;
+}
+}  // namespace
+
+InternedString::InternedString(std::string_view str) : id_(intern_table()->intern(str)) {}
+
+std::string_view InternedString::str() const { return intern_table()->str(id_); }
+
+size_t InternedString::table_size() { return intern_table()->size(); }
+}  // namespace core
+}  // namespace lance
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace lance {
+namespace core {
+// a string stored once in a process-wide table, copying and comparing it are integer operations.
+// interning takes a lock and is meant for setup code, str() does not lock. the characters live
+// until the process exits.
+class InternedString {
+ public:
+  // the empty string
+  InternedString() = default;
+
+  InternedString(std::string_view str);
+  InternedString(const std::string& str) : InternedString(std::string_view(str)) {}
+  InternedString(const char* str) : InternedString(std::string_view(str)) {}
+
+  // dense, in order of first interning, 0 is the empty string
+  uint32_t id() const { return id_; }
+
+  bool empty() const { return id_ == 0; }
+
+  std::string_view str() const;
+
+  // null terminated
+  const char* c_str() const { return str().data(); }
+
+  // number of distinct strings interned so far, including the empty one
+  static size_t table_size();
+
+  friend bool operator==(InternedString a, InternedString b) { return a.id_ == b.id_; }
+  friend bool operator!=(InternedString a, InternedString b) { return a.id_ != b.id_; }
+  // by id, not lexicographic
+  friend bool operator<(InternedString a, InternedString b) { return a.id_ < b.id_; }
+
+  friend std::ostream& operator<<(std::ostream& os, InternedString s) { return os << s.str(); }
+
+ private:
+  uint32_t id_ = 0;
+};
+}  // namespace core
+}  // namespace lance
+
+template <>
+struct std::hash<lance::core::InternedString> {
+  size_t operator()(lance::core::InternedString s) const { return s.id(); }
+};
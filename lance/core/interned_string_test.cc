@@ -0,0 +1,62 @@
+#include "interned_string.h"
+
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "absl/strings/str_format.h"
+#include "gtest/gtest.h"
+
+namespace lance {
+namespace core {
+TEST(interned_string, same_string_same_id) {
+  InternedString a = "interned_string.a";
+  InternedString b = std::string("interned_string.a");
+  InternedString c = "interned_string.c";
+
+  ASSERT_EQ(a, b);
+  ASSERT_NE(a, c);
+  ASSERT_EQ("interned_string.a", a.str());
+  ASSERT_STREQ("interned_string.c", c.c_str());
+
+  ASSERT_TRUE(InternedString().empty());
+  ASSERT_EQ(InternedString(), InternedString(""));
+  ASSERT_EQ("", InternedString().str());
+}
+
+TEST(interned_string, concurrent_interning) {
+  const size_t before = InternedString::table_size();
+
+  constexpr int kThreads = 8;
+  constexpr int kStrings = 10000;
+  std::vector<std::vector<InternedString>> results(kThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&results, t]() {
+      // every thread interns the same strings in a different order
+      for (int i = 0; i < kStrings; ++i) {
+        const int n = (i * (t + 1) * 7919) % kStrings;
+        InternedString s = absl::StrFormat("interned_string.concurrent.%d", n);
+        if (s.str() != absl::StrFormat("interned_string.concurrent.%d", n)) {
+          return;
+        }
+        results[t].push_back(s);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_EQ(before + kStrings, InternedString::table_size());
+
+  std::unordered_set<InternedString> distinct;
+  for (int t = 0; t < kThreads; ++t) {
+    ASSERT_EQ(kStrings, results[t].size());
+    distinct.insert(results[t].begin(), results[t].end());
+  }
+  ASSERT_EQ(kStrings, distinct.size());
+}
+}  // namespace core
+}  // namespace lance
@@ -0,0 +1,355 @@
+#include "job_system.h"
+
+#include <algorithm>
+
+#include "glog/logging.h"
+
+namespace lance {
+namespace core {
+struct JobEntry {
+  Job fn;
+  JobCounter* counter = nullptr;
+};
+
+namespace {
+thread_local const JobSystem* current_job_system = nullptr;
+thread_local int32_t current_worker_index = -1;
+
+// victim selection for stealing
+uint32_t next_random() {
+  thread_local uint32_t state =
+      static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id())) | 1;
+
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+// spins over the queues before an idle worker or waiter goes to sleep
+constexpr uint32_t kIdleSpins = 64;
+}  // namespace
+
+void JobCounter::add(int64_t count) {
+  if (count_.fetch_add(count, std::memory_order_acq_rel) == 0) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    finished_ = false;
+    done_.store(false, std::memory_order_release);
+  }
+}
+
+bool JobCounter::finish_one(std::vector<JobEntry*>* continuations) {
+  if (count_.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+    return false;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    finished_ = true;
+    continuations->swap(continuations_);
+  }
+
+  done_.store(true, std::memory_order_release);
+  return true;
+}
+
+// chase-lev deque of fixed capacity. the owner pushes and pops at the bottom, thieves take from
+// the top. a full deque makes push fail, the job then goes to the injection queue.
+class JobSystem::Deque {
+ public:
+  static constexpr int64_t kCapacity = 4096;
+
+  bool push(JobEntry* entry) {
+    const int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    const int64_t top = top_.load(std::memory_order_acquire);
+    if (bottom - top >= kCapacity) {
+      return false;
+    }
+
+    buffer_[bottom & (kCapacity - 1)].store(entry, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(bottom + 1, std::memory_order_relaxed);
+
+    return true;
+  }
+
+  JobEntry* pop() {
+    const int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    int64_t top = top_.load(std::memory_order_relaxed);
+    if (top > bottom) {
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+
+    JobEntry* entry = buffer_[bottom & (kCapacity - 1)].load(std::memory_order_relaxed);
+    if (top == bottom) {
+      // last entry, race the thieves for it
+      if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                        std::memory_order_relaxed)) {
+        entry = nullptr;
+      }
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    return entry;
+  }
+
+  JobEntry* steal() {
+    int64_t top = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t bottom = bottom_.load(std::memory_order_acquire);
+    if (top >= bottom) {
+      return nullptr;
+    }
+
+    JobEntry* entry = buffer_[top & (kCapacity - 1)].load(std::memory_order_relaxed);
+    if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      return nullptr;
+    }
+
+    return entry;
+  }
+
+ private:
+  alignas(64) std::atomic_int64_t top_{0};
+  alignas(64) std::atomic_int64_t bottom_{0};
+  std::atomic<JobEntry*> buffer_[kCapacity];
+};
+
+JobSystem::JobSystem(const Options& options) {
+  uint32_t num_workers = options.num_workers;
+  if (num_workers == 0) {
+    num_workers = std::max(2u, std::thread::hardware_concurrency()) - 1;
+  }
+
+  // every deque exists before any worker starts stealing
+  workers_.resize(num_workers);
+  for (auto& worker : workers_) {
+    worker.deque = std::make_unique<Deque>();
+  }
+
+  for (uint32_t i = 0; i < num_workers; ++i) {
+    workers_[i].thread = std::thread(&JobSystem::worker_main, this, i);
+  }
+}
+
+JobSystem::~JobSystem() {
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    stopping_.store(true);
+  }
+  sleep_cv_.notify_all();
+
+  for (auto& worker : workers_) {
+    worker.thread.join();
+  }
+
+  // jobs scheduled by the last running jobs, after every worker left
+  while (JobEntry* entry = find_job(-1)) {
+    execute(entry);
+  }
+}
+
+JobSystem* JobSystem::global() {
+  static JobSystem system;
+  return &system;
+}
+
+void JobSystem::run(Job job, JobCounter* counter) {
+  if (counter) {
+    counter->add(1);
+  }
+
+  schedule(new JobEntry{std::move(job), counter});
+}
+
+void JobSystem::run_after(JobCounter* dependency, Job job, JobCounter* counter) {
+  if (counter) {
+    counter->add(1);
+  }
+
+  auto* entry = new JobEntry{std::move(job), counter};
+  {
+    std::lock_guard<std::mutex> lock(dependency->mutex_);
+    if (!dependency->finished_) {
+      dependency->continuations_.push_back(entry);
+      return;
+    }
+  }
+
+  schedule(entry);
+}
+
+void JobSystem::wait(JobCounter* counter) {
+  const int32_t worker = current_worker();
+
+  uint32_t idle = 0;
+  while (!counter->done()) {
+    if (JobEntry* entry = find_job(worker)) {
+      execute(entry);
+      idle = 0;
+      continue;
+    }
+
+    if (++idle < kIdleSpins) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    // the remaining jobs run elsewhere, sleep until they finish or new ones show up
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    waiting_.fetch_add(1);
+    wait_cv_.wait(lock, [&]() { return counter->done() || queued_.load() > 0; });
+    waiting_.fetch_sub(1);
+    idle = 0;
+  }
+}
+
+void JobSystem::parallel_for(size_t begin, size_t end, size_t grain,
+                             const std::function<void(size_t, size_t)>& fn) {
+  if (begin >= end) {
+    return;
+  }
+
+  const size_t count = end - begin;
+  if (grain == 0) {
+    grain = std::max<size_t>(1, count / ((num_workers() + 1) * 4));
+  }
+
+  if (count <= grain) {
+    fn(begin, end);
+    return;
+  }
+
+  // the calling thread takes the first chunk itself
+  JobCounter counter;
+  for (size_t chunk = begin + grain; chunk < end; chunk += grain) {
+    const size_t chunk_end = std::min(end, chunk + grain);
+    run([&fn, chunk, chunk_end]() { fn(chunk, chunk_end); }, &counter);
+  }
+
+  fn(begin, begin + grain);
+
+  wait(&counter);
+}
+
+void JobSystem::worker_main(uint32_t index) {
+  current_job_system = this;
+  current_worker_index = static_cast<int32_t>(index);
+
+  while (true) {
+    JobEntry* entry = find_job(index);
+    for (uint32_t i = 0; !entry && i < kIdleSpins; ++i) {
+      std::this_thread::yield();
+      entry = find_job(index);
+    }
+
+    if (entry) {
+      execute(entry);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    sleeping_.fetch_add(1);
+    sleep_cv_.wait(lock, [this]() { return stopping_.load() || queued_.load() > 0; });
+    sleeping_.fetch_sub(1);
+
+    if (stopping_.load() && queued_.load() == 0) {
+      return;
+    }
+  }
+}
+
+void JobSystem::schedule(JobEntry* entry) {
+  // counted before the job is visible, so that a worker going to sleep can not miss it
+  queued_.fetch_add(1);
+
+  const int32_t worker = current_worker();
+  if (worker < 0 || !workers_[worker].deque->push(entry)) {
+    std::lock_guard<std::mutex> lock(injection_mutex_);
+    injection_queue_.push_back(entry);
+    injected_.fetch_add(1, std::memory_order_release);
+  }
+
+  if (sleeping_.load() > 0) {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    sleep_cv_.notify_one();
+  }
+
+  if (waiting_.load() > 0) {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    wait_cv_.notify_all();
+  }
+}
+
+int32_t JobSystem::current_worker() const {
+  return current_job_system == this ? current_worker_index : -1;
+}
+
+JobEntry* JobSystem::find_job(int32_t worker) {
+  JobEntry* entry = nullptr;
+
+  if (worker >= 0) {
+    entry = workers_[worker].deque->pop();
+  }
+
+  if (!entry && injected_.load(std::memory_order_acquire) > 0) {
+    std::lock_guard<std::mutex> lock(injection_mutex_);
+    if (!injection_queue_.empty()) {
+      entry = injection_queue_.front();
+      injection_queue_.pop_front();
+      injected_.fetch_sub(1, std::memory_order_relaxed);
+    }
+  }
+
+  if (!entry && !workers_.empty()) {
+    const size_t num_workers = workers_.size();
+    const size_t start = next_random() % num_workers;
+    for (size_t i = 0; i < num_workers && !entry; ++i) {
+      const size_t victim = (start + i) % num_workers;
+      if (static_cast<int32_t>(victim) != worker) {
+        entry = workers_[victim].deque->steal();
+      }
+    }
+  }
+
+  if (entry) {
+    queued_.fetch_sub(1);
+  }
+
+  return entry;
+}
+
+void JobSystem::execute(JobEntry* entry) {
+  entry->fn();
+
+  JobCounter* counter = entry->counter;
+  delete entry;
+
+  if (!counter) {
+    return;
+  }
+
+  // the counter may be destroyed by its waiter as soon as it is done, do not touch it after
+  std::vector<JobEntry*> continuations;
+  if (!counter->finish_one(&continuations)) {
+    return;
+  }
+
+  for (JobEntry* continuation : continuations) {
+    schedule(continuation);
+  }
+
+  // pairs with waiting_ being raised before a waiter checks the counter
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiting_.load() > 0) {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    wait_cv_.notify_all();
+  }
+}
+}  // namespace core
+}  // namespace lance
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lance {
+namespace core {
+using Job = std::function<void()>;
+
+struct JobEntry;
+
+// number of outstanding jobs. a counter may only be incremented from outside while it is done, or
+// from one of the jobs it counts.
+class JobCounter {
+ public:
+  JobCounter() = default;
+
+  JobCounter(const JobCounter&) = delete;
+  JobCounter& operator=(const JobCounter&) = delete;
+
+  bool done() const { return done_.load(std::memory_order_acquire); }
+
+ private:
+  friend class JobSystem;
+
+  void add(int64_t count);
+
+  // returns whether this was the last job, its continuations to schedule are moved to
+  // `continuations`
+  bool finish_one(std::vector<JobEntry*>* continuations);
+
+  std::atomic_int64_t count_{0};
+
+  // set last by the finishing job, so that the waiter may destroy the counter right away
+  std::atomic_bool done_{true};
+
+  std::mutex mutex_;
+  bool finished_ = true;
+  std::vector<JobEntry*> continuations_;
+};
+
+// work-stealing scheduler. each worker owns a deque it pushes to and pops from, idle workers steal
+// from the other end of the others' deques. jobs submitted from other threads go through a shared
+// injection queue.
+class JobSystem {
+ public:
+  struct Options {
+    // 0 means one less than the hardware threads, the waiting thread helps as well
+    uint32_t num_workers = 0;
+  };
+
+  JobSystem() : JobSystem(Options{}) {}
+
+  explicit JobSystem(const Options& options);
+
+  // runs the remaining jobs, then joins the workers
+  ~JobSystem();
+
+  JobSystem(const JobSystem&) = delete;
+  JobSystem& operator=(const JobSystem&) = delete;
+
+  // process-wide instance
+  static JobSystem* global();
+
+  uint32_t num_workers() const { return static_cast<uint32_t>(workers_.size()); }
+
+  // schedule `job`, `counter` is incremented now and decremented once the job finished
+  void run(Job job, JobCounter* counter = nullptr);
+
+  // schedule `job` once every job counted by `dependency` finished
+  void run_after(JobCounter* dependency, Job job, JobCounter* counter = nullptr);
+
+  // block until `counter` is done, running pending jobs on the calling thread meanwhile. with
+  // nothing to run, the caller sleeps after a short spin rather than taking a core
+  void wait(JobCounter* counter);
+
+  // call fn(chunk_begin, chunk_end) over [begin, end) split into chunks of at most `grain`
+  // elements, and wait for all of them. a grain of 0 picks one that gives each thread a few chunks.
+  void parallel_for(size_t begin, size_t end, size_t grain,
+                    const std::function<void(size_t, size_t)>& fn);
+
+ private:
+  class Deque;
+
+  struct Worker {
+    std::unique_ptr<Deque> deque;
+    std::thread thread;
+  };
+
+  void worker_main(uint32_t index);
+
+  void schedule(JobEntry* entry);
+
+  // -1 for threads which are not workers of this system
+  int32_t current_worker() const;
+
+  JobEntry* find_job(int32_t worker);
+
+  void execute(JobEntry* entry);
+
+  std::vector<Worker> workers_;
+
+  std::mutex injection_mutex_;
+  std::deque<JobEntry*> injection_queue_;
+  std::atomic_int64_t injected_{0};
+
+  // jobs sitting in any queue, workers only sleep when there are none
+  std::atomic_int64_t queued_{0};
+
+  std::mutex sleep_mutex_;
+  std::condition_variable sleep_cv_;
+  std::atomic_uint32_t sleeping_{0};
+
+  // threads in wait() with nothing to run, woken by new jobs and by counters finishing
+  std::condition_variable wait_cv_;
+  std::atomic_uint32_t waiting_{0};
+  std::atomic_bool stopping_{false};
+};
+}  // namespace core
+}  // namespace lance
@@ -0,0 +1,150 @@
+#include "job_system.h"
+
+#include <atomic>
+#include <chrono>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace lance {
+namespace core {
+TEST(job_system, run_and_wait) {
+  JobSystem jobs(JobSystem::Options{4});
+
+  std::atomic_int sum{0};
+  JobCounter counter;
+  for (int i = 1; i <= 1000; ++i) {
+    jobs.run([&sum, i]() { sum.fetch_add(i); }, &counter);
+  }
+  jobs.wait(&counter);
+
+  ASSERT_TRUE(counter.done());
+  ASSERT_EQ(500500, sum.load());
+}
+
+TEST(job_system, nested_jobs) {
+  JobSystem jobs(JobSystem::Options{3});
+
+  // jobs spawning jobs on the same counter, from the workers' own deques
+  std::atomic_int leaves{0};
+  JobCounter counter;
+  std::function<void(int)> spawn = [&](int depth) {
+    if (depth == 0) {
+      leaves.fetch_add(1);
+      return;
+    }
+    for (int i = 0; i < 4; ++i) {
+      jobs.run([&spawn, depth]() { spawn(depth - 1); }, &counter);
+    }
+  };
+
+  jobs.run([&spawn]() { spawn(5); }, &counter);
+  jobs.wait(&counter);
+
+  ASSERT_EQ(1024, leaves.load());
+}
+
+TEST(job_system, run_after) {
+  JobSystem jobs(JobSystem::Options{2});
+
+  std::atomic_int first{0};
+  std::atomic_bool ordered{true};
+
+  JobCounter stage1;
+  JobCounter stage2;
+  for (int i = 0; i < 100; ++i) {
+    jobs.run([&first]() { first.fetch_add(1); }, &stage1);
+  }
+  for (int i = 0; i < 10; ++i) {
+    jobs.run_after(
+        &stage1,
+        [&]() {
+          if (first.load() != 100) {
+            ordered = false;
+          }
+        },
+        &stage2);
+  }
+  jobs.wait(&stage2);
+
+  ASSERT_TRUE(ordered.load());
+
+  // a finished dependency runs the job right away
+  JobCounter stage3;
+  std::atomic_bool ran{false};
+  jobs.run_after(&stage1, [&ran]() { ran = true; }, &stage3);
+  jobs.wait(&stage3);
+  ASSERT_TRUE(ran.load());
+}
+
+TEST(job_system, parallel_for) {
+  JobSystem jobs(JobSystem::Options{4});
+
+  std::vector<int> values(100003, 0);
+  jobs.parallel_for(0, values.size(), 0, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      ++values[i];
+    }
+  });
+
+  ASSERT_EQ(values.size(), std::accumulate(values.begin(), values.end(), size_t(0)));
+
+  // nested parallel_for from inside a job
+  std::atomic_size_t total{0};
+  jobs.parallel_for(0, 16, 1, [&](size_t, size_t) {
+    jobs.parallel_for(0, 1000, 10, [&](size_t begin, size_t end) { total += end - begin; });
+  });
+  ASSERT_EQ(16000, total.load());
+}
+
+TEST(job_system, waiters_sleep_until_done) {
+  JobSystem jobs(JobSystem::Options{2});
+
+  // leaves long enough for the waiting jobs to run out of work and go to sleep, they are woken
+  // both by their counters finishing and by leaves scheduled from elsewhere
+  std::atomic_int leaves{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 3; ++t) {
+    threads.emplace_back([&]() {
+      JobCounter outer;
+      for (int i = 0; i < 4; ++i) {
+        jobs.run(
+            [&]() {
+              JobCounter inner;
+              for (int j = 0; j < 4; ++j) {
+                jobs.run(
+                    [&leaves]() {
+                      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                      leaves.fetch_add(1);
+                    },
+                    &inner);
+              }
+              jobs.wait(&inner);
+            },
+            &outer);
+      }
+      jobs.wait(&outer);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_EQ(48, leaves.load());
+}
+
+TEST(job_system, destructor_runs_pending_jobs) {
+  std::atomic_int count{0};
+  {
+    JobSystem jobs(JobSystem::Options{1});
+    for (int i = 0; i < 100; ++i) {
+      jobs.run([&count]() { count.fetch_add(1); });
+    }
+  }
+
+  ASSERT_EQ(100, count.load());
+}
+}  // namespace core
+}  // namespace lance
@@ -0,0 +1,306 @@
+#include "linalg.h"
+
+#include <cmath>
+
+#include "glog/logging.h"
+
+namespace lance {
+namespace core {
+namespace {
+inline Float3 transform_point(const Matrix4x4& m, const Float3& p) {
+  return Float3{
+      m.m[0][0] * p.x + m.m[0][1] * p.y + m.m[0][2] * p.z + m.m[0][3],
+      m.m[1][0] * p.x + m.m[1][1] * p.y + m.m[1][2] * p.z + m.m[1][3],
+      m.m[2][0] * p.x + m.m[2][1] * p.y + m.m[2][2] * p.z + m.m[2][3],
+  };
+}
+
+// transform the box by its center and half extent, see Arvo, "Transforming Axis-Aligned Bounding
+// Boxes", Graphics Gems 1990
+inline BoundingBox transform_bounding_box(const Matrix4x4& m, const BoundingBox& box) {
+  const float c[3] = {(box.lower.x + box.upper.x) * 0.5f, (box.lower.y + box.upper.y) * 0.5f,
+                      (box.lower.z + box.upper.z) * 0.5f};
+  const float e[3] = {(box.upper.x - box.lower.x) * 0.5f, (box.upper.y - box.lower.y) * 0.5f,
+                      (box.upper.z - box.lower.z) * 0.5f};
+
+  float lower[3], upper[3];
+  for (size_t i = 0; i < 3; ++i) {
+    const float center = m.m[i][0] * c[0] + m.m[i][1] * c[1] + m.m[i][2] * c[2] + m.m[i][3];
+    const float extent = std::abs(m.m[i][0]) * e[0] + std::abs(m.m[i][1]) * e[1] +
+                         std::abs(m.m[i][2]) * e[2];
+    lower[i] = center - extent;
+    upper[i] = center + extent;
+  }
+
+  return BoundingBox{{lower[0], lower[1], lower[2]}, {upper[0], upper[1], upper[2]}};
+}
+
+#if defined(LANCE_SIMD_AVX2)
+constexpr size_t kLanes = 8;
+
+struct Float3x8 {
+  __m256 x, y, z;
+};
+
+// affine matrix with every element broadcast, or gathered from 8 matrices
+struct Matrix3x4x8 {
+  __m256 m[3][4];
+};
+
+// de-interleave 8 consecutive Float3 into structure-of-arrays registers
+inline Float3x8 load_soa(const Float3* p) {
+  const float* f = &p->x;
+
+  __m256 m03 = _mm256_castps128_ps256(_mm_loadu_ps(f + 0));
+  __m256 m14 = _mm256_castps128_ps256(_mm_loadu_ps(f + 4));
+  __m256 m25 = _mm256_castps128_ps256(_mm_loadu_ps(f + 8));
+  m03 = _mm256_insertf128_ps(m03, _mm_loadu_ps(f + 12), 1);
+  m14 = _mm256_insertf128_ps(m14, _mm_loadu_ps(f + 16), 1);
+  m25 = _mm256_insertf128_ps(m25, _mm_loadu_ps(f + 20), 1);
+
+  const __m256 xy = _mm256_shuffle_ps(m14, m25, _MM_SHUFFLE(2, 1, 3, 2));
+  const __m256 yz = _mm256_shuffle_ps(m03, m14, _MM_SHUFFLE(1, 0, 2, 1));
+
+  Float3x8 result;
+  result.x = _mm256_shuffle_ps(m03, xy, _MM_SHUFFLE(2, 0, 3, 0));
+  result.y = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+  result.z = _mm256_shuffle_ps(yz, m25, _MM_SHUFFLE(3, 0, 3, 1));
+  return result;
+}
+
+// inverse of `load_soa`
+inline void store_soa(const Float3x8& v, Float3* p) {
+  float* f = &p->x;
+
+  const __m256 xy = _mm256_shuffle_ps(v.x, v.y, _MM_SHUFFLE(2, 0, 2, 0));
+  const __m256 yz = _mm256_shuffle_ps(v.y, v.z, _MM_SHUFFLE(3, 1, 3, 1));
+  const __m256 zx = _mm256_shuffle_ps(v.z, v.x, _MM_SHUFFLE(3, 1, 2, 0));
+
+  const __m256 r03 = _mm256_shuffle_ps(xy, zx, _MM_SHUFFLE(2, 0, 2, 0));
+  const __m256 r14 = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+  const __m256 r25 = _mm256_shuffle_ps(zx, yz, _MM_SHUFFLE(3, 1, 3, 1));
+
+  _mm_storeu_ps(f + 0, _mm256_castps256_ps128(r03));
+  _mm_storeu_ps(f + 4, _mm256_castps256_ps128(r14));
+  _mm_storeu_ps(f + 8, _mm256_castps256_ps128(r25));
+  _mm_storeu_ps(f + 12, _mm256_extractf128_ps(r03, 1));
+  _mm_storeu_ps(f + 16, _mm256_extractf128_ps(r14, 1));
+  _mm_storeu_ps(f + 20, _mm256_extractf128_ps(r25, 1));
+}
+
+// a BoundingBox is a (lower, upper) pair of Float3, 8 boxes are 16 interleaved Float3
+inline void load_soa(const BoundingBox* boxes, Float3x8* lower, Float3x8* upper) {
+  const Float3x8 a = load_soa(&boxes[0].lower);
+  const Float3x8 b = load_soa(&boxes[4].lower);
+
+  // (l0, u0, l1, u1, ...) -> (l0, l1, l2, l3, u0, u1, u2, u3)
+  const __m256i split = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+  const auto deinterleave = [&](__m256 va, __m256 vb, __m256* l, __m256* u) {
+    va = _mm256_permutevar8x32_ps(va, split);
+    vb = _mm256_permutevar8x32_ps(vb, split);
+    *l = _mm256_permute2f128_ps(va, vb, 0x20);
+    *u = _mm256_permute2f128_ps(va, vb, 0x31);
+  };
+
+  deinterleave(a.x, b.x, &lower->x, &upper->x);
+  deinterleave(a.y, b.y, &lower->y, &upper->y);
+  deinterleave(a.z, b.z, &lower->z, &upper->z);
+}
+
+inline void store_soa(const Float3x8& lower, const Float3x8& upper, BoundingBox* boxes) {
+  const __m256i merge = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  const auto interleave = [&](__m256 l, __m256 u, __m256* va, __m256* vb) {
+    *va = _mm256_permutevar8x32_ps(_mm256_permute2f128_ps(l, u, 0x20), merge);
+    *vb = _mm256_permutevar8x32_ps(_mm256_permute2f128_ps(l, u, 0x31), merge);
+  };
+
+  Float3x8 a, b;
+  interleave(lower.x, upper.x, &a.x, &b.x);
+  interleave(lower.y, upper.y, &a.y, &b.y);
+  interleave(lower.z, upper.z, &a.z, &b.z);
+
+  store_soa(a, &boxes[0].lower);
+  store_soa(b, &boxes[4].lower);
+}
+
+inline Matrix3x4x8 broadcast_matrix(const Matrix4x4& m) {
+  Matrix3x4x8 result;
+  for (size_t i = 0; i < 3; ++i) {
+    for (size_t j = 0; j < 4; ++j) {
+      result.m[i][j] = _mm256_set1_ps(m.m[i][j]);
+    }
+  }
+  return result;
+}
+
+inline Matrix3x4x8 gather_matrices(const Matrix4x4* matrices) {
+  // element (i, j) of matrix k lives at float offset k * 16 + i * 4 + j
+  const __m256i base = _mm256_setr_epi32(0, 16, 32, 48, 64, 80, 96, 112);
+  const float* f = &matrices->m[0][0];
+
+  Matrix3x4x8 result;
+  for (size_t i = 0; i < 3; ++i) {
+    for (size_t j = 0; j < 4; ++j) {
+      result.m[i][j] = _mm256_i32gather_ps(f + i * 4 + j, base, sizeof(float));
+    }
+  }
+  return result;
+}
+
+inline Float3x8 transform_point(const Matrix3x4x8& m, const Float3x8& p) {
+  const auto row = [&](size_t i) {
+    __m256 r = _mm256_fmadd_ps(m.m[i][0], p.x, m.m[i][3]);
+    r = _mm256_fmadd_ps(m.m[i][1], p.y, r);
+    return _mm256_fmadd_ps(m.m[i][2], p.z, r);
+  };
+
+  return Float3x8{row(0), row(1), row(2)};
+}
+
+inline void transform_bounding_box(const Matrix3x4x8& m, Float3x8* lower, Float3x8* upper) {
+  const __m256 half = _mm256_set1_ps(0.5f);
+  const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+
+  const Float3x8 c{
+      _mm256_mul_ps(_mm256_add_ps(lower->x, upper->x), half),
+      _mm256_mul_ps(_mm256_add_ps(lower->y, upper->y), half),
+      _mm256_mul_ps(_mm256_add_ps(lower->z, upper->z), half),
+  };
+  const Float3x8 e{
+      _mm256_mul_ps(_mm256_sub_ps(upper->x, lower->x), half),
+      _mm256_mul_ps(_mm256_sub_ps(upper->y, lower->y), half),
+      _mm256_mul_ps(_mm256_sub_ps(upper->z, lower->z), half),
+  };
+
+  const Float3x8 center = transform_point(m, c);
+
+  const auto extent = [&](size_t i) {
+    __m256 r = _mm256_mul_ps(_mm256_and_ps(m.m[i][0], abs_mask), e.x);
+    r = _mm256_fmadd_ps(_mm256_and_ps(m.m[i][1], abs_mask), e.y, r);
+    return _mm256_fmadd_ps(_mm256_and_ps(m.m[i][2], abs_mask), e.z, r);
+  };
+  const Float3x8 ext{extent(0), extent(1), extent(2)};
+
+  *lower = Float3x8{_mm256_sub_ps(center.x, ext.x), _mm256_sub_ps(center.y, ext.y),
+                    _mm256_sub_ps(center.z, ext.z)};
+  *upper = Float3x8{_mm256_add_ps(center.x, ext.x), _mm256_add_ps(center.y, ext.y),
+                    _mm256_add_ps(center.z, ext.z)};
+}
+#endif
+}  // namespace
+
+namespace scalar {
+void transform_points(const Matrix4x4& m, absl::Span<const Float3> in, absl::Span<Float3> out) {
+  CHECK_EQ(in.size(), out.size());
+
+  for (size_t i = 0; i < in.size(); ++i) {
+    out[i] = transform_point(m, in[i]);
+  }
+}
+
+void transform_points(absl::Span<const Matrix4x4> matrices, absl::Span<const Float3> in,
+                      absl::Span<Float3> out) {
+  CHECK_EQ(in.size(), out.size());
+  CHECK_EQ(in.size(), matrices.size());
+
+  for (size_t i = 0; i < in.size(); ++i) {
+    out[i] = transform_point(matrices[i], in[i]);
+  }
+}
+
+void transform_bounding_boxes(const Matrix4x4& m, absl::Span<const BoundingBox> in,
+                              absl::Span<BoundingBox> out) {
+  CHECK_EQ(in.size(), out.size());
+
+  for (size_t i = 0; i < in.size(); ++i) {
+    out[i] = transform_bounding_box(m, in[i]);
+  }
+}
+
+void transform_bounding_boxes(absl::Span<const Matrix4x4> matrices,
+                              absl::Span<const BoundingBox> in, absl::Span<BoundingBox> out) {
+  CHECK_EQ(in.size(), out.size());
+  CHECK_EQ(in.size(), matrices.size());
+
+  for (size_t i = 0; i < in.size(); ++i) {
+    out[i] = transform_bounding_box(matrices[i], in[i]);
+  }
+}
+}  // namespace scalar
+
+void transform_points(const Matrix4x4& m, absl::Span<const Float3> in, absl::Span<Float3> out) {
+#if defined(LANCE_SIMD_AVX2)
+  CHECK_EQ(in.size(), out.size());
+
+  const Matrix3x4x8 mat = broadcast_matrix(m);
+
+  size_t i = 0;
+  for (; i + kLanes <= in.size(); i += kLanes) {
+    store_soa(transform_point(mat, load_soa(&in[i])), &out[i]);
+  }
+
+  scalar::transform_points(m, in.subspan(i), out.subspan(i));
+#else
+  scalar::transform_points(m, in, out);
+#endif
+}
+
+void transform_points(absl::Span<const Matrix4x4> matrices, absl::Span<const Float3> in,
+                      absl::Span<Float3> out) {
+#if defined(LANCE_SIMD_AVX2)
+  CHECK_EQ(in.size(), out.size());
+  CHECK_EQ(in.size(), matrices.size());
+
+  size_t i = 0;
+  for (; i + kLanes <= in.size(); i += kLanes) {
+    store_soa(transform_point(gather_matrices(&matrices[i]), load_soa(&in[i])), &out[i]);
+  }
+
+  scalar::transform_points(matrices.subspan(i), in.subspan(i), out.subspan(i));
+#else
+  scalar::transform_points(matrices, in, out);
+#endif
+}
+
+void transform_bounding_boxes(const Matrix4x4& m, absl::Span<const BoundingBox> in,
+                              absl::Span<BoundingBox> out) {
+#if defined(LANCE_SIMD_AVX2)
+  CHECK_EQ(in.size(), out.size());
+
+  const Matrix3x4x8 mat = broadcast_matrix(m);
+
+  size_t i = 0;
+  for (; i + kLanes <= in.size(); i += kLanes) {
+    Float3x8 lower, upper;
+    load_soa(&in[i], &lower, &upper);
+    transform_bounding_box(mat, &lower, &upper);
+    store_soa(lower, upper, &out[i]);
+  }
+
+  scalar::transform_bounding_boxes(m, in.subspan(i), out.subspan(i));
+#else
+  scalar::transform_bounding_boxes(m, in, out);
+#endif
+}
+
+void transform_bounding_boxes(absl::Span<const Matrix4x4> matrices,
+                              absl::Span<const BoundingBox> in, absl::Span<BoundingBox> out) {
+#if defined(LANCE_SIMD_AVX2)
+  CHECK_EQ(in.size(), out.size());
+  CHECK_EQ(in.size(), matrices.size());
+
+  size_t i = 0;
+  for (; i + kLanes <= in.size(); i += kLanes) {
+    Float3x8 lower, upper;
+    load_soa(&in[i], &lower, &upper);
+    transform_bounding_box(gather_matrices(&matrices[i]), &lower, &upper);
+    store_soa(lower, upper, &out[i]);
+  }
+
+  scalar::transform_bounding_boxes(matrices.subspan(i), in.subspan(i), out.subspan(i));
+#else
+  scalar::transform_bounding_boxes(matrices, in, out);
+#endif
+}
+}  // namespace core
+}  // namespace lance
@@ -1,6 +1,22 @@
 #pragma once
 
 #include "absl/strings/str_format.h"
+#include "absl/types/span.h"
+
+// compile-time dispatch of simd kernels, build with `--config=avx2` to enable the avx2 path
+#if defined(__AVX2__) && defined(__FMA__)
+#define LANCE_SIMD_AVX2 1
+#include <immintrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define LANCE_SIMD_SSE 1
+#include <emmintrin.h>
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define LANCE_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
 
 namespace lance {
 namespace core {
@@ -12,7 +28,7 @@ struct Float3 {
   float x, y, z;
 };
 
-struct Float4 {
+struct alignas(16) Float4 {
   union {
     struct {
       float x, y, z, w;
@@ -22,6 +38,8 @@ struct Float4 {
 
   Float4() = default;
 
+  Float4(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) {}
+
   explicit Float4(Float3 v, float _w) : x(v.x), y(v.y), z(v.z), w(_w) {}
 
   float operator[](size_t i) const { return v[i]; }
@@ -29,35 +47,44 @@ struct Float4 {
   float& operator[](size_t i) { return v[i]; }
 };
 
-// row major matrix
-struct Matrix4x4 {
+struct Matrix4x4;
+
+// reference implementations, kept for validating the simd kernels
+namespace scalar {
+Float4 transform(const Matrix4x4& m, const Float4& t);
+
+Matrix4x4 multiply(const Matrix4x4& l, const Matrix4x4& r);
+
+Matrix4x4 transpose(const Matrix4x4& m);
+
+Matrix4x4 inverse(const Matrix4x4& m);
+
+Matrix4x4 affine_inverse(const Matrix4x4& m);
+}  // namespace scalar
+
+Matrix4x4 transpose(const Matrix4x4& m);
+
+// the result is undefined if `m` is singular
+Matrix4x4 inverse(const Matrix4x4& m);
+
+// inverse of a matrix whose last row is (0, 0, 0, 1), cheaper than `inverse`
+Matrix4x4 affine_inverse(const Matrix4x4& m);
+
+// row major matrix, rows are 32 bytes aligned so that two rows fit in one avx register
+struct alignas(32) Matrix4x4 {
   float m[4][4];
 
-  Float4 operator*(const Float4& t) const {
-    Float4 result;
+  static Matrix4x4 identity() {
+    Matrix4x4 result = {};
     for (size_t i = 0; i < 4; ++i) {
-      result.v[i] = 0;
-      for (size_t j = 0; j < 4; ++j) {
-        result.v[i] += m[i][j] * t.v[j];
-      }
+      result.m[i][i] = 1;
     }
     return result;
   }
 
-  Matrix4x4 operator*(const Matrix4x4& l) const {
-    Matrix4x4 result;
-    for (size_t i = 0; i < 4; ++i) {
-      for (size_t j = 0; j < 4; ++j) {
-        result.m[i][j] = 0;
+  Float4 operator*(const Float4& t) const;
 
-        for (size_t k = 0; k < 4; ++k) {
-          result.m[i][j] += m[i][k] * l.m[k][j];
-        }
-      }
-    }
-
-    return result;
-  }
+  Matrix4x4 operator*(const Matrix4x4& l) const;
 };
 
 struct BoundingBox {
@@ -66,6 +93,404 @@ struct BoundingBox {
   Float3 upper;
 };
 
+namespace scalar {
+inline Float4 transform(const Matrix4x4& m, const Float4& t) {
+  Float4 result;
+  for (size_t i = 0; i < 4; ++i) {
+    result.v[i] = 0;
+    for (size_t j = 0; j < 4; ++j) {
+      result.v[i] += m.m[i][j] * t.v[j];
+    }
+  }
+  return result;
+}
+
+inline Matrix4x4 multiply(const Matrix4x4& l, const Matrix4x4& r) {
+  Matrix4x4 result;
+  for (size_t i = 0; i < 4; ++i) {
+    for (size_t j = 0; j < 4; ++j) {
+      result.m[i][j] = 0;
+
+      for (size_t k = 0; k < 4; ++k) {
+        result.m[i][j] += l.m[i][k] * r.m[k][j];
+      }
+    }
+  }
+
+  return result;
+}
+
+inline Matrix4x4 transpose(const Matrix4x4& m) {
+  Matrix4x4 result;
+  for (size_t i = 0; i < 4; ++i) {
+    for (size_t j = 0; j < 4; ++j) {
+      result.m[i][j] = m.m[j][i];
+    }
+  }
+  return result;
+}
+
+inline Matrix4x4 inverse(const Matrix4x4& m) {
+  // cofactor expansion with shared 2x2 sub determinants
+  const float(&a)[4][4] = m.m;
+
+  const float s0 = a[0][0] * a[1][1] - a[1][0] * a[0][1];
+  const float s1 = a[0][0] * a[1][2] - a[1][0] * a[0][2];
+  const float s2 = a[0][0] * a[1][3] - a[1][0] * a[0][3];
+  const float s3 = a[0][1] * a[1][2] - a[1][1] * a[0][2];
+  const float s4 = a[0][1] * a[1][3] - a[1][1] * a[0][3];
+  const float s5 = a[0][2] * a[1][3] - a[1][2] * a[0][3];
+
+  const float c5 = a[2][2] * a[3][3] - a[3][2] * a[2][3];
+  const float c4 = a[2][1] * a[3][3] - a[3][1] * a[2][3];
+  const float c3 = a[2][1] * a[3][2] - a[3][1] * a[2][2];
+  const float c2 = a[2][0] * a[3][3] - a[3][0] * a[2][3];
+  const float c1 = a[2][0] * a[3][2] - a[3][0] * a[2][2];
+  const float c0 = a[2][0] * a[3][1] - a[3][0] * a[2][1];
+
+  const float det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+  const float inv_det = 1.0f / det;
+
+  Matrix4x4 result;
+  result.m[0][0] = (a[1][1] * c5 - a[1][2] * c4 + a[1][3] * c3) * inv_det;
+  result.m[0][1] = (-a[0][1] * c5 + a[0][2] * c4 - a[0][3] * c3) * inv_det;
+  result.m[0][2] = (a[3][1] * s5 - a[3][2] * s4 + a[3][3] * s3) * inv_det;
+  result.m[0][3] = (-a[2][1] * s5 + a[2][2] * s4 - a[2][3] * s3) * inv_det;
+
+  result.m[1][0] = (-a[1][0] * c5 + a[1][2] * c2 - a[1][3] * c1) * inv_det;
+  result.m[1][1] = (a[0][0] * c5 - a[0][2] * c2 + a[0][3] * c1) * inv_det;
+  result.m[1][2] = (-a[3][0] * s5 + a[3][2] * s2 - a[3][3] * s1) * inv_det;
+  result.m[1][3] = (a[2][0] * s5 - a[2][2] * s2 + a[2][3] * s1) * inv_det;
+
+  result.m[2][0] = (a[1][0] * c4 - a[1][1] * c2 + a[1][3] * c0) * inv_det;
+  result.m[2][1] = (-a[0][0] * c4 + a[0][1] * c2 - a[0][3] * c0) * inv_det;
+  result.m[2][2] = (a[3][0] * s4 - a[3][1] * s2 + a[3][3] * s0) * inv_det;
+  result.m[2][3] = (-a[2][0] * s4 + a[2][1] * s2 - a[2][3] * s0) * inv_det;
+
+  result.m[3][0] = (-a[1][0] * c3 + a[1][1] * c1 - a[1][2] * c0) * inv_det;
+  result.m[3][1] = (a[0][0] * c3 - a[0][1] * c1 + a[0][2] * c0) * inv_det;
+  result.m[3][2] = (-a[3][0] * s3 + a[3][1] * s1 - a[3][2] * s0) * inv_det;
+  result.m[3][3] = (a[2][0] * s3 - a[2][1] * s1 + a[2][2] * s0) * inv_det;
+
+  return result;
+}
+
+inline Matrix4x4 affine_inverse(const Matrix4x4& m) {
+  const float(&a)[4][4] = m.m;
+
+  // inverse of the upper-left 3x3 block by its adjugate
+  const float c00 = a[1][1] * a[2][2] - a[1][2] * a[2][1];
+  const float c01 = a[1][2] * a[2][0] - a[1][0] * a[2][2];
+  const float c02 = a[1][0] * a[2][1] - a[1][1] * a[2][0];
+  const float inv_det = 1.0f / (a[0][0] * c00 + a[0][1] * c01 + a[0][2] * c02);
+
+  Matrix4x4 result;
+  result.m[0][0] = c00 * inv_det;
+  result.m[0][1] = (a[0][2] * a[2][1] - a[0][1] * a[2][2]) * inv_det;
+  result.m[0][2] = (a[0][1] * a[1][2] - a[0][2] * a[1][1]) * inv_det;
+  result.m[1][0] = c01 * inv_det;
+  result.m[1][1] = (a[0][0] * a[2][2] - a[0][2] * a[2][0]) * inv_det;
+  result.m[1][2] = (a[0][2] * a[1][0] - a[0][0] * a[1][2]) * inv_det;
+  result.m[2][0] = c02 * inv_det;
+  result.m[2][1] = (a[0][1] * a[2][0] - a[0][0] * a[2][1]) * inv_det;
+  result.m[2][2] = (a[0][0] * a[1][1] - a[0][1] * a[1][0]) * inv_det;
+
+  // translation: -inv(R) * t
+  for (size_t i = 0; i < 3; ++i) {
+    result.m[i][3] = -(result.m[i][0] * a[0][3] + result.m[i][1] * a[1][3] +
+                       result.m[i][2] * a[2][3]);
+  }
+
+  result.m[3][0] = 0;
+  result.m[3][1] = 0;
+  result.m[3][2] = 0;
+  result.m[3][3] = 1;
+
+  return result;
+}
+}  // namespace scalar
+
+namespace detail {
+#if defined(LANCE_SIMD_SSE)
+#define LANCE_SHUFFLE_MASK(X, Y, Z, W) ((X) | ((Y) << 2) | ((Z) << 4) | ((W) << 6))
+#define LANCE_SWIZZLE(V, X, Y, Z, W) \
+  _mm_castsi128_ps(_mm_shuffle_epi32(_mm_castps_si128(V), LANCE_SHUFFLE_MASK(X, Y, Z, W)))
+#define LANCE_SHUFFLE(V1, V2, X, Y, Z, W) _mm_shuffle_ps(V1, V2, LANCE_SHUFFLE_MASK(X, Y, Z, W))
+
+// 2x2 row major matrices packed as (m00, m01, m10, m11)
+
+// A * B
+inline __m128 mat2_mul(__m128 a, __m128 b) {
+  return _mm_add_ps(_mm_mul_ps(a, LANCE_SWIZZLE(b, 0, 3, 0, 3)),
+                    _mm_mul_ps(LANCE_SWIZZLE(a, 1, 0, 3, 2), LANCE_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+// adj(A) * B
+inline __m128 mat2_adj_mul(__m128 a, __m128 b) {
+  return _mm_sub_ps(_mm_mul_ps(LANCE_SWIZZLE(a, 3, 3, 0, 0), b),
+                    _mm_mul_ps(LANCE_SWIZZLE(a, 1, 1, 2, 2), LANCE_SWIZZLE(b, 2, 3, 0, 1)));
+}
+
+// A * adj(B)
+inline __m128 mat2_mul_adj(__m128 a, __m128 b) {
+  return _mm_sub_ps(_mm_mul_ps(a, LANCE_SWIZZLE(b, 3, 0, 3, 0)),
+                    _mm_mul_ps(LANCE_SWIZZLE(a, 1, 0, 3, 2), LANCE_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+// (a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x, 0)
+inline __m128 cross3(__m128 a, __m128 b) {
+  const __m128 a_yzx = LANCE_SWIZZLE(a, 1, 2, 0, 3);
+  const __m128 b_yzx = LANCE_SWIZZLE(b, 1, 2, 0, 3);
+  const __m128 c = _mm_sub_ps(_mm_mul_ps(a, b_yzx), _mm_mul_ps(a_yzx, b));
+  return LANCE_SWIZZLE(c, 1, 2, 0, 3);
+}
+#endif
+}  // namespace detail
+
+inline Float4 Matrix4x4::operator*(const Float4& t) const {
+#if defined(LANCE_SIMD_SSE)
+  __m128 r0 = _mm_load_ps(m[0]);
+  __m128 r1 = _mm_load_ps(m[1]);
+  __m128 r2 = _mm_load_ps(m[2]);
+  __m128 r3 = _mm_load_ps(m[3]);
+  _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+  const __m128 v = _mm_load_ps(t.v);
+  __m128 result = _mm_mul_ps(r0, LANCE_SWIZZLE(v, 0, 0, 0, 0));
+  result = _mm_add_ps(result, _mm_mul_ps(r1, LANCE_SWIZZLE(v, 1, 1, 1, 1)));
+  result = _mm_add_ps(result, _mm_mul_ps(r2, LANCE_SWIZZLE(v, 2, 2, 2, 2)));
+  result = _mm_add_ps(result, _mm_mul_ps(r3, LANCE_SWIZZLE(v, 3, 3, 3, 3)));
+
+  Float4 out;
+  _mm_store_ps(out.v, result);
+  return out;
+#elif defined(LANCE_SIMD_NEON)
+  // vld4q de-interleaves, so the registers hold the columns of the matrix
+  const float32x4x4_t c = vld4q_f32(&m[0][0]);
+  const float32x4_t v = vld1q_f32(t.v);
+  float32x4_t result = vmulq_laneq_f32(c.val[0], v, 0);
+  result = vfmaq_laneq_f32(result, c.val[1], v, 1);
+  result = vfmaq_laneq_f32(result, c.val[2], v, 2);
+  result = vfmaq_laneq_f32(result, c.val[3], v, 3);
+
+  Float4 out;
+  vst1q_f32(out.v, result);
+  return out;
+#else
+  return scalar::transform(*this, t);
+#endif
+}
+
+inline Matrix4x4 Matrix4x4::operator*(const Matrix4x4& l) const {
+  Matrix4x4 result;
+#if defined(LANCE_SIMD_AVX2)
+  // every row of the result is a linear combination of the rows of `l`
+  const __m256 l0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(l.m[0]));
+  const __m256 l1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(l.m[1]));
+  const __m256 l2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(l.m[2]));
+  const __m256 l3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(l.m[3]));
+
+  for (size_t i = 0; i < 4; i += 2) {
+    // rows i and i + 1 of this matrix
+    const __m256 a = _mm256_load_ps(m[i]);
+
+    __m256 r = _mm256_mul_ps(_mm256_shuffle_ps(a, a, 0x00), l0);
+    r = _mm256_fmadd_ps(_mm256_shuffle_ps(a, a, 0x55), l1, r);
+    r = _mm256_fmadd_ps(_mm256_shuffle_ps(a, a, 0xaa), l2, r);
+    r = _mm256_fmadd_ps(_mm256_shuffle_ps(a, a, 0xff), l3, r);
+    _mm256_store_ps(result.m[i], r);
+  }
+#elif defined(LANCE_SIMD_SSE)
+  const __m128 l0 = _mm_load_ps(l.m[0]);
+  const __m128 l1 = _mm_load_ps(l.m[1]);
+  const __m128 l2 = _mm_load_ps(l.m[2]);
+  const __m128 l3 = _mm_load_ps(l.m[3]);
+
+  for (size_t i = 0; i < 4; ++i) {
+    const __m128 a = _mm_load_ps(m[i]);
+
+    __m128 r = _mm_mul_ps(LANCE_SWIZZLE(a, 0, 0, 0, 0), l0);
+    r = _mm_add_ps(r, _mm_mul_ps(LANCE_SWIZZLE(a, 1, 1, 1, 1), l1));
+    r = _mm_add_ps(r, _mm_mul_ps(LANCE_SWIZZLE(a, 2, 2, 2, 2), l2));
+    r = _mm_add_ps(r, _mm_mul_ps(LANCE_SWIZZLE(a, 3, 3, 3, 3), l3));
+    _mm_store_ps(result.m[i], r);
+  }
+#elif defined(LANCE_SIMD_NEON)
+  const float32x4_t l0 = vld1q_f32(l.m[0]);
+  const float32x4_t l1 = vld1q_f32(l.m[1]);
+  const float32x4_t l2 = vld1q_f32(l.m[2]);
+  const float32x4_t l3 = vld1q_f32(l.m[3]);
+
+  for (size_t i = 0; i < 4; ++i) {
+    const float32x4_t a = vld1q_f32(m[i]);
+
+    float32x4_t r = vmulq_laneq_f32(l0, a, 0);
+    r = vfmaq_laneq_f32(r, l1, a, 1);
+    r = vfmaq_laneq_f32(r, l2, a, 2);
+    r = vfmaq_laneq_f32(r, l3, a, 3);
+    vst1q_f32(result.m[i], r);
+  }
+#else
+  result = scalar::multiply(*this, l);
+#endif
+  return result;
+}
+
+inline Matrix4x4 transpose(const Matrix4x4& m) {
+#if defined(LANCE_SIMD_SSE)
+  __m128 r0 = _mm_load_ps(m.m[0]);
+  __m128 r1 = _mm_load_ps(m.m[1]);
+  __m128 r2 = _mm_load_ps(m.m[2]);
+  __m128 r3 = _mm_load_ps(m.m[3]);
+  _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+  Matrix4x4 result;
+  _mm_store_ps(result.m[0], r0);
+  _mm_store_ps(result.m[1], r1);
+  _mm_store_ps(result.m[2], r2);
+  _mm_store_ps(result.m[3], r3);
+  return result;
+#elif defined(LANCE_SIMD_NEON)
+  const float32x4x4_t c = vld4q_f32(&m.m[0][0]);
+
+  Matrix4x4 result;
+  vst1q_f32(result.m[0], c.val[0]);
+  vst1q_f32(result.m[1], c.val[1]);
+  vst1q_f32(result.m[2], c.val[2]);
+  vst1q_f32(result.m[3], c.val[3]);
+  return result;
+#else
+  return scalar::transpose(m);
+#endif
+}
+
+inline Matrix4x4 inverse(const Matrix4x4& m) {
+#if defined(LANCE_SIMD_SSE)
+  // block-wise inverse, the matrix is split into the 2x2 blocks | A B |
+  //                                                             | C D |
+  const __m128 r0 = _mm_load_ps(m.m[0]);
+  const __m128 r1 = _mm_load_ps(m.m[1]);
+  const __m128 r2 = _mm_load_ps(m.m[2]);
+  const __m128 r3 = _mm_load_ps(m.m[3]);
+
+  const __m128 a = _mm_movelh_ps(r0, r1);
+  const __m128 b = _mm_movehl_ps(r1, r0);
+  const __m128 c = _mm_movelh_ps(r2, r3);
+  const __m128 d = _mm_movehl_ps(r3, r2);
+
+  // (|A|, |B|, |C|, |D|)
+  const __m128 det_sub =
+      _mm_sub_ps(_mm_mul_ps(LANCE_SHUFFLE(r0, r2, 0, 2, 0, 2), LANCE_SHUFFLE(r1, r3, 1, 3, 1, 3)),
+                 _mm_mul_ps(LANCE_SHUFFLE(r0, r2, 1, 3, 1, 3), LANCE_SHUFFLE(r1, r3, 0, 2, 0, 2)));
+  const __m128 det_a = LANCE_SWIZZLE(det_sub, 0, 0, 0, 0);
+  const __m128 det_b = LANCE_SWIZZLE(det_sub, 1, 1, 1, 1);
+  const __m128 det_c = LANCE_SWIZZLE(det_sub, 2, 2, 2, 2);
+  const __m128 det_d = LANCE_SWIZZLE(det_sub, 3, 3, 3, 3);
+
+  const __m128 d_c = detail::mat2_adj_mul(d, c);
+  const __m128 a_b = detail::mat2_adj_mul(a, b);
+
+  __m128 x = _mm_sub_ps(_mm_mul_ps(det_d, a), detail::mat2_mul(b, d_c));
+  __m128 w = _mm_sub_ps(_mm_mul_ps(det_a, d), detail::mat2_mul(c, a_b));
+  __m128 y = _mm_sub_ps(_mm_mul_ps(det_b, c), detail::mat2_mul_adj(d, a_b));
+  __m128 z = _mm_sub_ps(_mm_mul_ps(det_c, b), detail::mat2_mul_adj(a, d_c));
+
+  // |M| = |A| * |D| + |B| * |C| - tr(adj(A) * B * adj(D) * C)
+  __m128 tr = _mm_mul_ps(a_b, LANCE_SWIZZLE(d_c, 0, 2, 1, 3));
+  tr = _mm_add_ps(tr, LANCE_SWIZZLE(tr, 2, 3, 0, 1));
+  tr = _mm_add_ps(tr, LANCE_SWIZZLE(tr, 1, 0, 3, 2));
+  const __m128 det_m =
+      _mm_sub_ps(_mm_add_ps(_mm_mul_ps(det_a, det_d), _mm_mul_ps(det_b, det_c)), tr);
+
+  const __m128 r_det_m = _mm_div_ps(_mm_setr_ps(1.f, -1.f, -1.f, 1.f), det_m);
+  x = _mm_mul_ps(x, r_det_m);
+  y = _mm_mul_ps(y, r_det_m);
+  z = _mm_mul_ps(z, r_det_m);
+  w = _mm_mul_ps(w, r_det_m);
+
+  // the adjugate of every block is folded into the final shuffles
+  Matrix4x4 result;
+  _mm_store_ps(result.m[0], LANCE_SHUFFLE(x, y, 3, 1, 3, 1));
+  _mm_store_ps(result.m[1], LANCE_SHUFFLE(x, y, 2, 0, 2, 0));
+  _mm_store_ps(result.m[2], LANCE_SHUFFLE(z, w, 3, 1, 3, 1));
+  _mm_store_ps(result.m[3], LANCE_SHUFFLE(z, w, 2, 0, 2, 0));
+  return result;
+#else
+  return scalar::inverse(m);
+#endif
+}
+
+inline Matrix4x4 affine_inverse(const Matrix4x4& m) {
+#if defined(LANCE_SIMD_SSE)
+  const __m128 r0 = _mm_load_ps(m.m[0]);
+  const __m128 r1 = _mm_load_ps(m.m[1]);
+  const __m128 r2 = _mm_load_ps(m.m[2]);
+
+  // columns of adj(R), where R is the upper-left 3x3 block
+  __m128 c0 = detail::cross3(r1, r2);
+  __m128 c1 = detail::cross3(r2, r0);
+  __m128 c2 = detail::cross3(r0, r1);
+
+  // |R| = dot(r0, c0), the w lane of c0 is zero
+  __m128 det = _mm_mul_ps(r0, c0);
+  det = _mm_add_ps(det, LANCE_SWIZZLE(det, 2, 3, 0, 1));
+  det = _mm_add_ps(det, LANCE_SWIZZLE(det, 1, 0, 3, 2));
+  const __m128 inv_det = _mm_div_ps(_mm_set1_ps(1.0f), det);
+  c0 = _mm_mul_ps(c0, inv_det);
+  c1 = _mm_mul_ps(c1, inv_det);
+  c2 = _mm_mul_ps(c2, inv_det);
+
+  // translation: -inv(R) * t
+  __m128 t = _mm_mul_ps(c0, LANCE_SWIZZLE(r0, 3, 3, 3, 3));
+  t = _mm_add_ps(t, _mm_mul_ps(c1, LANCE_SWIZZLE(r1, 3, 3, 3, 3)));
+  t = _mm_add_ps(t, _mm_mul_ps(c2, LANCE_SWIZZLE(r2, 3, 3, 3, 3)));
+  t = _mm_sub_ps(_mm_setzero_ps(), t);
+
+  __m128 r3 = _mm_setr_ps(0, 0, 0, 1);
+  _MM_TRANSPOSE4_PS(c0, c1, c2, t);
+
+  Matrix4x4 result;
+  _mm_store_ps(result.m[0], c0);
+  _mm_store_ps(result.m[1], c1);
+  _mm_store_ps(result.m[2], c2);
+  _mm_store_ps(result.m[3], r3);
+  return result;
+#else
+  return scalar::affine_inverse(m);
+#endif
+}
+
+// batch kernels, matrices are expected to be affine (last row is (0, 0, 0, 1)). the points are
+// processed as structure-of-arrays, 8 lanes at a time when avx2 is available. `in` and `out` must
+// have the same size and may alias.
+//
+// out[i] = m * (in[i], 1)
+void transform_points(const Matrix4x4& m, absl::Span<const Float3> in, absl::Span<Float3> out);
+
+// out[i] = matrices[i] * (in[i], 1)
+void transform_points(absl::Span<const Matrix4x4> matrices, absl::Span<const Float3> in,
+                      absl::Span<Float3> out);
+
+// out[i] is the axis aligned bounding box of the transformed in[i]
+void transform_bounding_boxes(const Matrix4x4& m, absl::Span<const BoundingBox> in,
+                              absl::Span<BoundingBox> out);
+
+void transform_bounding_boxes(absl::Span<const Matrix4x4> matrices,
+                              absl::Span<const BoundingBox> in, absl::Span<BoundingBox> out);
+
+namespace scalar {
+void transform_points(const Matrix4x4& m, absl::Span<const Float3> in, absl::Span<Float3> out);
+
+void transform_points(absl::Span<const Matrix4x4> matrices, absl::Span<const Float3> in,
+                      absl::Span<Float3> out);
+
+void transform_bounding_boxes(const Matrix4x4& m, absl::Span<const BoundingBox> in,
+                              absl::Span<BoundingBox> out);
+
+void transform_bounding_boxes(absl::Span<const Matrix4x4> matrices,
+                              absl::Span<const BoundingBox> in, absl::Span<BoundingBox> out);
+}  // namespace scalar
+
 template <typename Sink>
 inline void AbslStringify(Sink& sink, const Float3& v) {
   absl::Format(&sink, "(%f, %f, %f)", v.x, v.y, v.z);
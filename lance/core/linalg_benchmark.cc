@@ -0,0 +1,134 @@
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "linalg.h"
+
+namespace lance {
+namespace core {
+namespace {
+Matrix4x4 test_matrix() {
+  Matrix4x4 m = Matrix4x4::identity();
+  m.m[0][1] = 0.5f;
+  m.m[1][2] = -0.25f;
+  m.m[0][3] = 10.0f;
+  m.m[2][3] = -3.0f;
+  return m;
+}
+
+std::vector<Float3> test_points(size_t n) {
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(-100.0f, 100.0f);
+
+  std::vector<Float3> points(n);
+  for (auto& p : points) {
+    p = Float3{dist(rng), dist(rng), dist(rng)};
+  }
+  return points;
+}
+
+std::vector<BoundingBox> test_bounding_boxes(size_t n) {
+  const auto points = test_points(n);
+
+  std::vector<BoundingBox> boxes(n);
+  for (size_t i = 0; i < n; ++i) {
+    boxes[i].lower = points[i];
+    boxes[i].upper = Float3{points[i].x + 1.0f, points[i].y + 2.0f, points[i].z + 3.0f};
+  }
+  return boxes;
+}
+
+template <void (*Fn)(const Matrix4x4&, absl::Span<const Float3>, absl::Span<Float3>)>
+void BM_transform_points(benchmark::State& state) {
+  const Matrix4x4 m = test_matrix();
+  const auto points = test_points(state.range(0));
+  std::vector<Float3> out(points.size());
+
+  for (auto _ : state) {
+    Fn(m, points, absl::MakeSpan(out));
+    benchmark::DoNotOptimize(out.data());
+  }
+
+  state.SetItemsProcessed(state.iterations() * points.size());
+}
+
+template <void (*Fn)(absl::Span<const Matrix4x4>, absl::Span<const Float3>, absl::Span<Float3>)>
+void BM_transform_points_by_matrices(benchmark::State& state) {
+  const auto points = test_points(state.range(0));
+  const std::vector<Matrix4x4> matrices(points.size(), test_matrix());
+  std::vector<Float3> out(points.size());
+
+  for (auto _ : state) {
+    Fn(matrices, points, absl::MakeSpan(out));
+    benchmark::DoNotOptimize(out.data());
+  }
+
+  state.SetItemsProcessed(state.iterations() * points.size());
+}
+
+template <void (*Fn)(const Matrix4x4&, absl::Span<const BoundingBox>, absl::Span<BoundingBox>)>
+void BM_transform_bounding_boxes(benchmark::State& state) {
+  const Matrix4x4 m = test_matrix();
+  const auto boxes = test_bounding_boxes(state.range(0));
+  std::vector<BoundingBox> out(boxes.size());
+
+  for (auto _ : state) {
+    Fn(m, boxes, absl::MakeSpan(out));
+    benchmark::DoNotOptimize(out.data());
+  }
+
+  state.SetItemsProcessed(state.iterations() * boxes.size());
+}
+
+// single matrix kernels, per element calls through the operators
+void BM_matrix_multiply(benchmark::State& state) {
+  const Matrix4x4 a = test_matrix();
+  Matrix4x4 b = test_matrix();
+
+  for (auto _ : state) {
+    b = a * b;
+    benchmark::DoNotOptimize(b);
+  }
+}
+
+void BM_matrix_multiply_scalar(benchmark::State& state) {
+  const Matrix4x4 a = test_matrix();
+  Matrix4x4 b = test_matrix();
+
+  for (auto _ : state) {
+    b = scalar::multiply(a, b);
+    benchmark::DoNotOptimize(b);
+  }
+}
+
+void BM_transform_points_per_element(benchmark::State& state) {
+  const Matrix4x4 m = test_matrix();
+  const auto points = test_points(state.range(0));
+  std::vector<Float3> out(points.size());
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < points.size(); ++i) {
+      const Float4 t = m * Float4(points[i], 1.0f);
+      out[i] = Float3{t.x, t.y, t.z};
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+
+  state.SetItemsProcessed(state.iterations() * points.size());
+}
+
+}  // namespace
+
+BENCHMARK(BM_matrix_multiply);
+BENCHMARK(BM_matrix_multiply_scalar);
+BENCHMARK(BM_transform_points_per_element)->Range(1 << 10, 1 << 16);
+BENCHMARK_TEMPLATE(BM_transform_points, transform_points)->Range(1 << 10, 1 << 16);
+BENCHMARK_TEMPLATE(BM_transform_points, scalar::transform_points)->Range(1 << 10, 1 << 16);
+BENCHMARK_TEMPLATE(BM_transform_points_by_matrices, transform_points)->Range(1 << 10, 1 << 16);
+BENCHMARK_TEMPLATE(BM_transform_points_by_matrices, scalar::transform_points)
+    ->Range(1 << 10, 1 << 16);
+BENCHMARK_TEMPLATE(BM_transform_bounding_boxes, transform_bounding_boxes)->Range(1 << 10, 1 << 16);
+BENCHMARK_TEMPLATE(BM_transform_bounding_boxes, scalar::transform_bounding_boxes)
+    ->Range(1 << 10, 1 << 16);
+}  // namespace core
+}  // namespace lance
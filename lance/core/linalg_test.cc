@@ -0,0 +1,214 @@
+#include "linalg.h"
+
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace lance {
+namespace core {
+namespace {
+Matrix4x4 random_matrix(std::mt19937* rng) {
+  std::uniform_real_distribution<float> dist(-2.0f, 2.0f);
+
+  Matrix4x4 result;
+  for (size_t i = 0; i < 4; ++i) {
+    for (size_t j = 0; j < 4; ++j) {
+      result.m[i][j] = dist(*rng);
+    }
+    // keep the matrix well conditioned
+    result.m[i][i] += 4.0f;
+  }
+  return result;
+}
+
+Matrix4x4 random_affine_matrix(std::mt19937* rng) {
+  Matrix4x4 result = random_matrix(rng);
+  result.m[3][0] = 0;
+  result.m[3][1] = 0;
+  result.m[3][2] = 0;
+  result.m[3][3] = 1;
+  return result;
+}
+
+std::vector<Float3> random_points(std::mt19937* rng, size_t n) {
+  std::uniform_real_distribution<float> dist(-100.0f, 100.0f);
+
+  std::vector<Float3> result(n);
+  for (auto& p : result) {
+    p = Float3{dist(*rng), dist(*rng), dist(*rng)};
+  }
+  return result;
+}
+
+std::vector<BoundingBox> random_bounding_boxes(std::mt19937* rng, size_t n) {
+  std::uniform_real_distribution<float> extent(0.0f, 10.0f);
+
+  std::vector<BoundingBox> result(n);
+  const auto centers = random_points(rng, n);
+  for (size_t i = 0; i < n; ++i) {
+    const Float3 e{extent(*rng), extent(*rng), extent(*rng)};
+    result[i].lower = Float3{centers[i].x - e.x, centers[i].y - e.y, centers[i].z - e.z};
+    result[i].upper = Float3{centers[i].x + e.x, centers[i].y + e.y, centers[i].z + e.z};
+  }
+  return result;
+}
+
+void expect_float3_near(const Float3& expected, const Float3& actual, float eps) {
+  EXPECT_NEAR(expected.x, actual.x, eps);
+  EXPECT_NEAR(expected.y, actual.y, eps);
+  EXPECT_NEAR(expected.z, actual.z, eps);
+}
+
+void expect_matrix_near(const Matrix4x4& expected, const Matrix4x4& actual, float eps) {
+  for (size_t i = 0; i < 4; ++i) {
+    for (size_t j = 0; j < 4; ++j) {
+      EXPECT_NEAR(expected.m[i][j], actual.m[i][j], eps) << "i: " << i << ", j: " << j;
+    }
+  }
+}
+}  // namespace
+
+TEST(linalg, matrix_multiply) {
+  std::mt19937 rng(0);
+  for (int32_t i = 0; i < 64; ++i) {
+    const Matrix4x4 a = random_matrix(&rng);
+    const Matrix4x4 b = random_matrix(&rng);
+
+    expect_matrix_near(scalar::multiply(a, b), a * b, 1e-4f);
+  }
+}
+
+TEST(linalg, matrix_vector_multiply) {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> dist(-10.0f, 10.0f);
+  for (int32_t i = 0; i < 64; ++i) {
+    const Matrix4x4 a = random_matrix(&rng);
+    const Float4 v(dist(rng), dist(rng), dist(rng), dist(rng));
+
+    const Float4 expected = scalar::transform(a, v);
+    const Float4 actual = a * v;
+    for (size_t j = 0; j < 4; ++j) {
+      EXPECT_NEAR(expected[j], actual[j], 1e-4f);
+    }
+  }
+}
+
+TEST(linalg, transpose) {
+  std::mt19937 rng(2);
+  const Matrix4x4 a = random_matrix(&rng);
+
+  expect_matrix_near(scalar::transpose(a), transpose(a), 0);
+}
+
+TEST(linalg, inverse) {
+  std::mt19937 rng(3);
+  for (int32_t i = 0; i < 64; ++i) {
+    const Matrix4x4 a = random_matrix(&rng);
+
+    expect_matrix_near(scalar::inverse(a), inverse(a), 1e-4f);
+    expect_matrix_near(Matrix4x4::identity(), a * inverse(a), 1e-4f);
+  }
+}
+
+TEST(linalg, affine_inverse) {
+  std::mt19937 rng(4);
+  for (int32_t i = 0; i < 64; ++i) {
+    const Matrix4x4 a = random_affine_matrix(&rng);
+
+    expect_matrix_near(scalar::affine_inverse(a), affine_inverse(a), 1e-4f);
+    expect_matrix_near(scalar::inverse(a), affine_inverse(a), 1e-4f);
+    expect_matrix_near(Matrix4x4::identity(), a * affine_inverse(a), 1e-4f);
+  }
+}
+
+TEST(linalg, transform_points) {
+  std::mt19937 rng(5);
+  const Matrix4x4 m = random_affine_matrix(&rng);
+
+  // odd size to cover the scalar tail
+  const auto points = random_points(&rng, 1003);
+
+  std::vector<Float3> expected(points.size()), actual(points.size());
+  scalar::transform_points(m, points, absl::MakeSpan(expected));
+  transform_points(m, points, absl::MakeSpan(actual));
+
+  for (size_t i = 0; i < points.size(); ++i) {
+    expect_float3_near(expected[i], actual[i], 1e-3f);
+  }
+
+  // in place
+  std::vector<Float3> in_place = points;
+  transform_points(m, in_place, absl::MakeSpan(in_place));
+  for (size_t i = 0; i < points.size(); ++i) {
+    expect_float3_near(expected[i], in_place[i], 1e-3f);
+  }
+}
+
+TEST(linalg, transform_points_by_matrices) {
+  std::mt19937 rng(6);
+  const auto points = random_points(&rng, 101);
+
+  std::vector<Matrix4x4> matrices(points.size());
+  for (auto& m : matrices) {
+    m = random_affine_matrix(&rng);
+  }
+
+  std::vector<Float3> expected(points.size()), actual(points.size());
+  scalar::transform_points(matrices, points, absl::MakeSpan(expected));
+  transform_points(matrices, points, absl::MakeSpan(actual));
+
+  for (size_t i = 0; i < points.size(); ++i) {
+    expect_float3_near(expected[i], actual[i], 1e-3f);
+  }
+}
+
+TEST(linalg, transform_bounding_boxes) {
+  std::mt19937 rng(7);
+  const Matrix4x4 m = random_affine_matrix(&rng);
+  const auto boxes = random_bounding_boxes(&rng, 77);
+
+  std::vector<BoundingBox> expected(boxes.size()), actual(boxes.size());
+  scalar::transform_bounding_boxes(m, boxes, absl::MakeSpan(expected));
+  transform_bounding_boxes(m, boxes, absl::MakeSpan(actual));
+
+  for (size_t i = 0; i < boxes.size(); ++i) {
+    expect_float3_near(expected[i].lower, actual[i].lower, 1e-3f);
+    expect_float3_near(expected[i].upper, actual[i].upper, 1e-3f);
+
+    // every corner of the source box must lie in the transformed box
+    for (int32_t corner = 0; corner < 8; ++corner) {
+      const Float3 p{(corner & 1) ? boxes[i].upper.x : boxes[i].lower.x,
+                     (corner & 2) ? boxes[i].upper.y : boxes[i].lower.y,
+                     (corner & 4) ? boxes[i].upper.z : boxes[i].lower.z};
+      const Float4 t = m * Float4(p, 1.0f);
+      EXPECT_LE(actual[i].lower.x, t.x + 1e-3f);
+      EXPECT_GE(actual[i].upper.x, t.x - 1e-3f);
+      EXPECT_LE(actual[i].lower.y, t.y + 1e-3f);
+      EXPECT_GE(actual[i].upper.y, t.y - 1e-3f);
+      EXPECT_LE(actual[i].lower.z, t.z + 1e-3f);
+      EXPECT_GE(actual[i].upper.z, t.z - 1e-3f);
+    }
+  }
+}
+
+TEST(linalg, transform_bounding_boxes_by_matrices) {
+  std::mt19937 rng(8);
+  const auto boxes = random_bounding_boxes(&rng, 45);
+
+  std::vector<Matrix4x4> matrices(boxes.size());
+  for (auto& m : matrices) {
+    m = random_affine_matrix(&rng);
+  }
+
+  std::vector<BoundingBox> expected(boxes.size()), actual(boxes.size());
+  scalar::transform_bounding_boxes(matrices, boxes, absl::MakeSpan(expected));
+  transform_bounding_boxes(matrices, boxes, absl::MakeSpan(actual));
+
+  for (size_t i = 0; i < boxes.size(); ++i) {
+    expect_float3_near(expected[i].lower, actual[i].lower, 1e-3f);
+    expect_float3_near(expected[i].upper, actual[i].upper, 1e-3f);
+  }
+}
+}  // namespace core
+}  // namespace lance
@@ -0,0 +1,61 @@
+#include "linear_allocator.h"
+
+#include <algorithm>
+#include <new>
+
+#include "glog/logging.h"
+
+namespace lance {
+namespace core {
+LinearAllocator::LinearAllocator(size_t block_size) : block_size_(block_size) {}
+
+LinearAllocator::~LinearAllocator() {
+  for (const auto& block : blocks_) {
+    ::operator delete(block.data);
+  }
+}
+
+void* LinearAllocator::allocate_slow(size_t size, size_t alignment) {
+  DCHECK_EQ(0, alignment & (alignment - 1)) << "alignment must be a power of two";
+
+  // the blocks after the current one are free, large requests may still fit in a later one
+  while (block_index_ + 1 < blocks_.size()) {
+    use_block(block_index_ + 1);
+
+    const uintptr_t aligned = (cursor_ + alignment - 1) & ~uintptr_t(alignment - 1);
+    if (aligned + size <= limit_) {
+      cursor_ = aligned + size;
+      return reinterpret_cast<void*>(aligned);
+    }
+  }
+
+  Block block;
+  block.size = std::max(block_size_, size + alignment);
+  block.data = static_cast<uint8_t*>(::operator new(block.size));
+  blocks_.push_back(block);
+
+  ++system_allocations_;
+  capacity_ += block.size;
+
+  use_block(blocks_.size() - 1);
+
+  const uintptr_t aligned = (cursor_ + alignment - 1) & ~uintptr_t(alignment - 1);
+  cursor_ = aligned + size;
+  return reinterpret_cast<void*>(aligned);
+}
+
+void LinearAllocator::use_block(size_t index) {
+  block_index_ = index;
+  cursor_ = reinterpret_cast<uintptr_t>(blocks_[index].data);
+  limit_ = cursor_ + blocks_[index].size;
+}
+
+void LinearAllocator::reset() {
+  if (blocks_.empty()) {
+    return;
+  }
+
+  use_block(0);
+}
+}  // namespace core
+}  // namespace lance
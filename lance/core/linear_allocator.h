@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lance {
+namespace core {
+// bump allocator for transient data, e.g. whatever a frame records. individual allocations are
+// never freed, reset() rewinds to the first block in O(1) and keeps every block for reuse, so once
+// a frame's worth of blocks exists no further system allocations happen. not thread-safe.
+class LinearAllocator {
+ public:
+  static constexpr size_t kDefaultBlockSize = 64 * 1024;
+
+  explicit LinearAllocator(size_t block_size = kDefaultBlockSize);
+
+  ~LinearAllocator();
+
+  LinearAllocator(const LinearAllocator&) = delete;
+  LinearAllocator& operator=(const LinearAllocator&) = delete;
+
+  // `alignment` must be a power of two. zero sized requests get a valid pointer as well
+  void* allocate(size_t size, size_t alignment) {
+    const uintptr_t aligned = (cursor_ + alignment - 1) & ~uintptr_t(alignment - 1);
+    if (aligned + size <= limit_) {
+      cursor_ = aligned + size;
+      return reinterpret_cast<void*>(aligned);
+    }
+
+    return allocate_slow(size, alignment);
+  }
+
+  template <typename T>
+  T* allocate_array(size_t count) {
+    return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+  }
+
+  // everything allocated so far becomes invalid
+  void reset();
+
+  // blocks requested from the system allocator over the allocator's lifetime
+  uint64_t system_allocations() const { return system_allocations_; }
+
+  // bytes of all blocks held
+  size_t capacity() const { return capacity_; }
+
+ private:
+  struct Block {
+    uint8_t* data = nullptr;
+    size_t size = 0;
+  };
+
+  void* allocate_slow(size_t size, size_t alignment);
+
+  void use_block(size_t index);
+
+  size_t block_size_;
+  std::vector<Block> blocks_;
+  size_t block_index_ = 0;
+
+  // a cursor past the limit until the first block exists, so that every request reaches
+  // allocate_slow, zero sized ones included
+  uintptr_t cursor_ = 1;
+  uintptr_t limit_ = 0;
+
+  uint64_t system_allocations_ = 0;
+  size_t capacity_ = 0;
+};
+
+// std allocator adapter over a LinearAllocator, deallocate is a no-op. containers using it must
+// not outlive the allocator's next reset().
+template <typename T>
+class LinearStlAllocator {
+ public:
+  using value_type = T;
+
+  explicit LinearStlAllocator(LinearAllocator* allocator) : allocator_(allocator) {}
+
+  template <typename U>
+  LinearStlAllocator(const LinearStlAllocator<U>& other) : allocator_(other.allocator()) {}
+
+  T* allocate(size_t count) { return allocator_->allocate_array<T>(count); }
+
+  void deallocate(T* /*ptr*/, size_t /*count*/) {}
+
+  LinearAllocator* allocator() const { return allocator_; }
+
+  template <typename U>
+  bool operator==(const LinearStlAllocator<U>& other) const {
+    return allocator_ == other.allocator();
+  }
+
+  template <typename U>
+  bool operator!=(const LinearStlAllocator<U>& other) const {
+    return allocator_ != other.allocator();
+  }
+
+ private:
+  LinearAllocator* allocator_;
+};
+
+template <typename T>
+using FrameVector = std::vector<T, LinearStlAllocator<T>>;
+
+template <typename T>
+FrameVector<T> make_frame_vector(LinearAllocator* allocator) {
+  return FrameVector<T>(LinearStlAllocator<T>(allocator));
+}
+
+// `size` value-initialized elements
+template <typename T>
+FrameVector<T> make_frame_vector(LinearAllocator* allocator, size_t size) {
+  return FrameVector<T>(size, LinearStlAllocator<T>(allocator));
+}
+}  // namespace core
+}  // namespace lance
@@ -0,0 +1,81 @@
+#include "linear_allocator.h"
+
+#include "gtest/gtest.h"
+#include "lance/core/testing/allocation_counter.h"
+
+namespace lance {
+namespace core {
+TEST(linear_allocator, alignment) {
+  LinearAllocator allocator(256);
+
+  for (size_t alignment = 1; alignment <= 64; alignment *= 2) {
+    auto* ptr = allocator.allocate(3, alignment);
+    ASSERT_EQ(0, reinterpret_cast<uintptr_t>(ptr) % alignment);
+  }
+
+  // larger than a block
+  auto* large = allocator.allocate_array<double>(1000);
+  ASSERT_EQ(0, reinterpret_cast<uintptr_t>(large) % alignof(double));
+  large[999] = 1.0;
+}
+
+TEST(linear_allocator, zero_size) {
+  LinearAllocator allocator(256);
+
+  // a valid pointer before and after the first block exists
+  void* first = allocator.allocate(0, 8);
+  ASSERT_NE(nullptr, first);
+  ASSERT_EQ(0, reinterpret_cast<uintptr_t>(first) % 8);
+  ASSERT_NE(nullptr, allocator.allocate(0, 1));
+  ASSERT_EQ(1, allocator.system_allocations());
+}
+
+TEST(linear_allocator, reset_reuses_blocks) {
+  LinearAllocator allocator(1024);
+
+  void* first = allocator.allocate(16, 16);
+  for (int i = 0; i < 100; ++i) {
+    allocator.allocate(100, 8);
+  }
+  const uint64_t system_allocations = allocator.system_allocations();
+  ASSERT_GT(system_allocations, 1);
+
+  for (int frame = 0; frame < 10; ++frame) {
+    allocator.reset();
+    ASSERT_EQ(first, allocator.allocate(16, 16));
+    for (int i = 0; i < 100; ++i) {
+      allocator.allocate(100, 8);
+    }
+  }
+
+  ASSERT_EQ(system_allocations, allocator.system_allocations());
+}
+
+TEST(linear_allocator, frame_vector_steady_state) {
+  LinearAllocator allocator;
+
+  auto record = [&allocator](size_t frame) {
+    auto clear_values = make_frame_vector<float>(&allocator, 4);
+    auto views = make_frame_vector<void*>(&allocator);
+    for (size_t i = 0; i < 64 + frame % 7; ++i) {
+      views.push_back(&clear_values[i % 4]);
+    }
+
+    auto nested = make_frame_vector<FrameVector<int>>(&allocator);
+    nested.emplace_back(3, 1, LinearStlAllocator<int>(&allocator));
+    return views.size() + nested[0].size();
+  };
+
+  // warm up the blocks
+  record(0);
+  allocator.reset();
+
+  const uint64_t before = heap_allocations();
+  for (size_t frame = 1; frame < 100; ++frame) {
+    ASSERT_EQ(64 + frame % 7 + 3, record(frame));
+    allocator.reset();
+  }
+  ASSERT_EQ(before, heap_allocations());
+}
+}  // namespace core
+}  // namespace lance
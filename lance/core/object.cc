@@ -1,30 +1,94 @@
 #include "object.h"
 
 #include <cstdlib>
+#include <cstring>
+
+#include "glog/logging.h"
+
+#if defined(_WIN64)
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#endif
 
 namespace lance {
 namespace core {
 std::string_view Object::type_name() const { return "Object"; }
 
-RefCountPtr<Blob> Blob::create(const void* data, size_t size) {
-  class BlobFromData : public Inherit<BlobFromData, Blob> {
-   public:
-    BlobFromData(void* data, size_t size) : data_(data), size_(size) {}
+namespace {
+class BlobFromData : public Inherit<BlobFromData, Blob> {
+ public:
+  BlobFromData(void* data, size_t size, Blob::Deleter deleter)
+      : data_(data), size_(size), deleter_(std::move(deleter)) {}
+
+  ~BlobFromData() override {
+    if (deleter_) {
+      deleter_(data_, size_);
+    }
+  }
+
+  const void* data() const override { return data_; }
+  size_t size() const override { return size_; }
 
-    ~BlobFromData() { ::free(data_); }
+ private:
+  void* data_ = nullptr;
+  size_t size_ = 0;
+  Blob::Deleter deleter_;
+};
 
-    const void* data() const override { return data_; }
-    size_t size() const override { return size_; }
+class BlobSlice : public Inherit<BlobSlice, Blob> {
+ public:
+  BlobSlice(RefCountPtr<Blob> parent, const void* data, size_t size)
+      : parent_(parent), data_(data), size_(size) {}
 
-   private:
-    void* data_ = nullptr;
-    size_t size_ = 0;
-  };
+  const void* data() const override { return data_; }
+  size_t size() const override { return size_; }
 
+  Blob* parent() const { return parent_.get(); }
+
+ private:
+  RefCountPtr<Blob> parent_;
+  const void* data_ = nullptr;
+  size_t size_ = 0;
+};
+}  // namespace
+
+RefCountPtr<Blob> Blob::create(const void* data, size_t size) {
   void* addr = std::malloc(size);
-  memcpy(addr, data, size);
+  if (size > 0) {
+    memcpy(addr, data, size);
+  }
+
+  return adopt(addr, size, [](void* data, size_t) { ::free(data); });
+}
+
+RefCountPtr<Blob> Blob::adopt(void* data, size_t size, Deleter deleter) {
+  return make_refcounted<BlobFromData>(data, size, std::move(deleter));
+}
+
+RefCountPtr<Blob> Blob::adopt_mapping(void* addr, size_t size) {
+  return adopt(addr, size, [](void* addr, size_t size) {
+#if defined(_WIN64)
+    UnmapViewOfFile(addr);
+#else
+    munmap(addr, size);
+#endif
+  });
+}
+
+RefCountPtr<Blob> Blob::slice(size_t offset, size_t size) const {
+  CHECK(offset <= this->size() && size <= this->size() - offset)
+      << "offset: " << offset << ", size: " << size << ", blob size: " << this->size();
+
+  const void* data = static_cast<const uint8_t*>(this->data()) + offset;
+
+  // slices of slices reference the original blob, so chains do not build up
+  Blob* parent = const_cast<Blob*>(this);
+  if (is_type_of<BlobSlice>()) {
+    parent = static_cast<const BlobSlice*>(this)->parent();
+  }
 
-  return make_refcounted<BlobFromData>(addr, size);
+  return make_refcounted<BlobSlice>(RefCountPtr<Blob>(parent), data, size);
 }
 }  // namespace core
 }  // namespace lance
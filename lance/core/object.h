@@ -1,6 +1,8 @@
 #pragma once
 
-#include <typeindex>
+#include <functional>
+#include <type_traits>
+#include <typeinfo>
 
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
@@ -9,48 +11,100 @@
 namespace lance {
 namespace core {
 
-struct TypeMetadata {
-  const TypeMetadata* base = nullptr;
+using TypeId = const void*;
 
-  std::type_index id{typeid(nullptr)};
+namespace detail {
+// one tag per type, its address is a link-time constant used as the type id
+template <typename T>
+struct TypeTag {
+  static constexpr char tag = 0;
+};
+}  // namespace detail
 
-  bool is_type(std::type_index type) const {
-    const TypeMetadata* ptr = this;
-    while (ptr) {
-      if (ptr->id == type) {
-        return true;
-      }
+template <typename T>
+constexpr TypeId type_id_of() {
+  return &detail::TypeTag<T>::tag;
+}
 
-      ptr = ptr->base;
-    }
+// ids of a type and of all its ancestors indexed by depth, Object is at depth 0. an is-a check is
+// a single compare at the depth of the tested type.
+struct TypeMetadata {
+  static constexpr size_t kMaxDepth = 16;
+
+  size_t depth = 0;
+  TypeId ancestors[kMaxDepth] = {};
 
-    return false;
+  constexpr TypeId id() const { return ancestors[depth]; }
+
+  constexpr bool is_type(TypeId type, size_t type_depth) const {
+    return type_depth <= depth && ancestors[type_depth] == type;
   }
 
   template <typename T>
-  bool is_type_of() const {
-    return is_type(typeid(T));
+  constexpr bool is_type_of() const {
+    return is_type(type_id_of<T>(), T::static_type_medadata()->depth);
+  }
+
+  // metadata of `type` deriving from `base`
+  static constexpr TypeMetadata derive(const TypeMetadata& base, TypeId type) {
+    TypeMetadata metadata;
+    metadata.depth = base.depth + 1;
+    for (size_t i = 0; i <= base.depth; ++i) {
+      metadata.ancestors[i] = base.ancestors[i];
+    }
+    metadata.ancestors[metadata.depth] = type;
+
+    return metadata;
   }
 };
 
+template <typename T, typename Base>
+class Inherit;
+
+namespace detail {
+// true if T has its own metadata, i.e. derives from Inherit<T, ...> rather than only its base
+template <typename T, typename = void>
+struct has_own_type_metadata : std::false_type {};
+
+template <typename T>
+struct has_own_type_metadata<T, std::void_t<typename T::BaseType>>
+    : std::is_base_of<Inherit<T, typename T::BaseType>, T> {};
+}  // namespace detail
+
 class Object : public RefCounted {
  public:
   virtual ~Object() = default;
 
-  virtual const TypeMetadata* type_metadata() const = 0;
+  virtual const TypeMetadata* type_metadata() const { return static_type_medadata(); }
+
+  static constexpr const TypeMetadata* static_type_medadata() { return &kTypeMetadata; }
 
   virtual std::string_view type_name() const;
 
   // for simplify
   template <typename T>
   bool is_type_of() const {
+    static_assert(std::is_same_v<T, Object> || detail::has_own_type_metadata<T>::value,
+                  "T must derive from Inherit<T, ...>");
+
     return type_metadata()->is_type_of<T>();
   }
 
+  // nullptr if the object is not a T
+  template <typename T>
+  const T* as() const {
+    return is_type_of<T>() ? static_cast<const T*>(this) : nullptr;
+  }
+
+  template <typename T>
+  T* as() {
+    return is_type_of<T>() ? static_cast<T*>(this) : nullptr;
+  }
+
   template <typename T>
   absl::StatusOr<const T*> cast_to() const {
     if (is_type_of<T>()) {
-      return reinterpret_cast<const T*>(this);
+      return static_cast<const T*>(this);
     }
 
     return absl::InvalidArgumentError(absl::StrFormat("unexcepted type, expect: %s, got: %s",
@@ -60,12 +114,15 @@ class Object : public RefCounted {
   template <typename T>
   absl::StatusOr<T*> cast_to() {
     if (is_type_of<T>()) {
-      return reinterpret_cast<T*>(this);
+      return static_cast<T*>(this);
     }
 
     return absl::InvalidArgumentError(absl::StrFormat("unexcepted type, got: %s, expect: %s",
                                                       this->type_name(), typeid(T).name()));
   }
+
+ private:
+  static constexpr TypeMetadata kTypeMetadata = {0, {type_id_of<Object>()}};
 };
 
 template <typename T, typename Base>
@@ -77,57 +134,34 @@ class Inherit : public Base {
 
   const TypeMetadata* type_metadata() const override { return static_type_medadata(); }
 
-  static const TypeMetadata* static_type_medadata();
-};
-
-namespace detail {
-template <typename T>
-constexpr size_t type_chain_depth() {
-  if constexpr (std::is_same_v<T, Object>) {
-    return 1;
-  } else {
-    return type_chain_depth<typename T::BaseType>() + 1;
-  }
-}
-
-template <typename T>
-constexpr void type_metadata_set_id(TypeMetadata* v) {
-  v->id = typeid(T);
-
-  if constexpr (!std::is_same_v<T, Object>) {
-    type_metadata_set_id<typename T::BaseType>(v + 1);
-  }
-}
-
-}  // namespace detail
-
-template <typename T, typename Base>
-inline const TypeMetadata* Inherit<T, Base>::static_type_medadata() {
-  static const TypeMetadata* chain = []() -> const TypeMetadata* {
-    constexpr size_t num_depth = detail::type_chain_depth<T>();
-
-    static TypeMetadata list[num_depth];
-
-    detail::type_metadata_set_id<T>(list);
-
-    // initialize type chain list
-    list[0].base = nullptr;
-    for (size_t i = 0; i < num_depth - 1; ++i) {
-      list[i].base = &list[i + 1];
-    }
+  static constexpr const TypeMetadata* static_type_medadata() { return &kTypeMetadata; }
 
-    return list;
-  }();
+ private:
+  static_assert(Base::static_type_medadata()->depth + 1 < TypeMetadata::kMaxDepth,
+                "type hierarchy is too deep");
 
-  return chain;
-}
+  static constexpr TypeMetadata kTypeMetadata =
+      TypeMetadata::derive(*Base::static_type_medadata(), type_id_of<T>());
+};
 
 class Blob : public Inherit<Blob, Object> {
  public:
+  using Deleter = std::function<void(void* data, size_t size)>;
+
+  // copy `size` bytes of `data`
   static RefCountPtr<Blob> create(const void* data, size_t size);
 
+  // take ownership of `data` without copying, `deleter` runs once the blob is destroyed
+  static RefCountPtr<Blob> adopt(void* data, size_t size, Deleter deleter);
+
+  // take ownership of a memory mapped region, unmapped once the blob is destroyed
+  static RefCountPtr<Blob> adopt_mapping(void* addr, size_t size);
+
   virtual const void* data() const = 0;
   virtual size_t size() const = 0;
+
+  // view [offset, offset + size) of this blob without copying, the view keeps this blob alive
+  RefCountPtr<Blob> slice(size_t offset, size_t size) const;
 };
 }  // namespace core
 }  // namespace lance
@@ -0,0 +1,91 @@
+#include "object.h"
+
+#include <cstring>
+
+#include "gtest/gtest.h"
+
+namespace lance {
+namespace core {
+namespace {
+class ObjectTestBase : public Inherit<ObjectTestBase, Object> {};
+
+class ObjectTestDerived : public Inherit<ObjectTestDerived, ObjectTestBase> {};
+
+class ObjectTestSibling : public Inherit<ObjectTestSibling, ObjectTestBase> {};
+}  // namespace
+
+TEST(object, type_metadata) {
+  constexpr const TypeMetadata* derived = ObjectTestDerived::static_type_medadata();
+  static_assert(derived->depth == 2);
+  static_assert(derived->id() == type_id_of<ObjectTestDerived>());
+  static_assert(derived->is_type_of<Object>());
+  static_assert(derived->is_type_of<ObjectTestBase>());
+  // comparing the addresses of different statics is not a constant expression everywhere, e.g.
+  // with -fsanitize=undefined
+  ASSERT_FALSE(derived->is_type_of<ObjectTestSibling>());
+  ASSERT_FALSE(ObjectTestBase::static_type_medadata()->is_type_of<ObjectTestDerived>());
+
+  auto object = make_refcounted<ObjectTestDerived>();
+  const Object* base = object.get();
+
+  ASSERT_TRUE(base->is_type_of<ObjectTestBase>());
+  ASSERT_EQ(object.get(), base->as<ObjectTestDerived>());
+  ASSERT_EQ(nullptr, base->as<ObjectTestSibling>());
+  ASSERT_TRUE(base->cast_to<ObjectTestBase>().ok());
+  ASSERT_FALSE(base->cast_to<ObjectTestSibling>().ok());
+}
+
+TEST(object, blob_adopt) {
+  static char data[] = "adopted";
+  bool deleted = false;
+
+  {
+    auto blob = Blob::adopt(data, sizeof(data), [&](void* ptr, size_t size) {
+      ASSERT_EQ(data, ptr);
+      ASSERT_EQ(sizeof(data), size);
+      deleted = true;
+    });
+
+    ASSERT_EQ(data, blob->data());
+    ASSERT_FALSE(deleted);
+  }
+
+  ASSERT_TRUE(deleted);
+}
+
+TEST(object, blob_slice) {
+  bool deleted = false;
+  static char data[] = "0123456789";
+
+  {
+    RefCountPtr<Blob> slice;
+    {
+      auto blob = Blob::adopt(data, 10, [&](void*, size_t) { deleted = true; });
+      slice = blob->slice(2, 6);
+    }
+
+    // the slice keeps its parent alive
+    ASSERT_FALSE(deleted);
+    ASSERT_EQ(6, slice->size());
+    ASSERT_EQ(0, std::memcmp(slice->data(), "234567", 6));
+
+    auto nested = slice->slice(1, 3);
+    ASSERT_EQ(0, std::memcmp(nested->data(), "345", 3));
+
+    auto empty = slice->slice(6, 0);
+    ASSERT_EQ(0, empty->size());
+  }
+
+  ASSERT_TRUE(deleted);
+}
+
+TEST(object, blob_create_copies) {
+  char data[] = "copied";
+  auto blob = Blob::create(data, sizeof(data));
+  data[0] = 'x';
+
+  ASSERT_NE(data, blob->data());
+  ASSERT_STREQ("copied", static_cast<const char*>(blob->data()));
+}
+}  // namespace core
+}  // namespace lance
@@ -0,0 +1,244 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "absl/strings/str_format.h"
+
+namespace lance {
+namespace core {
+namespace {
+enum class EventKind : uint32_t {
+  kZone,
+  kCounter,
+};
+
+// fields are relaxed atomics so that a dump may read an event while its thread overwrites it,
+// torn events are detected and dropped afterwards
+struct Event {
+  std::atomic<const char*> name{nullptr};
+  std::atomic_uint64_t timestamp_ns{0};
+  // duration of a zone, value of a counter
+  std::atomic_int64_t value{0};
+  std::atomic<EventKind> kind{EventKind::kZone};
+};
+
+struct EventCopy {
+  const char* name;
+  uint64_t timestamp_ns;
+  int64_t value;
+  EventKind kind;
+};
+
+std::atomic_uint64_t next_profiler_id{1};
+
+void append_json_string(std::string* out, const char* str) {
+  out->push_back('"');
+  for (; *str; ++str) {
+    const char c = *str;
+    if (c == '"' || c == '\\') {
+      out->push_back('\\');
+      out->push_back(c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      absl::StrAppendFormat(out, "\\u%04x", c);
+    } else {
+      out->push_back(c);
+    }
+  }
+  out->push_back('"');
+}
+}  // namespace
+
+// ring of the newest events of one thread. only the owning thread writes, like a seqlock the
+// `claimed_` count is bumped before a slot is overwritten and `written_` after.
+class Profiler::ThreadBuffer {
+ public:
+  ThreadBuffer(uint32_t tid, size_t capacity)
+      : tid_(tid),
+        thread_id_(std::this_thread::get_id()),
+        capacity_(capacity),
+        events_(new Event[capacity]) {}
+
+  uint32_t tid() const { return tid_; }
+
+  std::thread::id thread_id() const { return thread_id_; }
+
+  void record(EventKind kind, const char* name, uint64_t timestamp_ns, int64_t value) {
+    const uint64_t index = written_.load(std::memory_order_relaxed);
+
+    claimed_.store(index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    Event& event = events_[index % capacity_];
+    event.name.store(name, std::memory_order_relaxed);
+    event.timestamp_ns.store(timestamp_ns, std::memory_order_relaxed);
+    event.value.store(value, std::memory_order_relaxed);
+    event.kind.store(kind, std::memory_order_relaxed);
+
+    written_.store(index + 1, std::memory_order_release);
+  }
+
+  std::vector<EventCopy> snapshot() const {
+    const uint64_t written = written_.load(std::memory_order_acquire);
+    const uint64_t first = written > capacity_ ? written - capacity_ : 0;
+
+    std::vector<EventCopy> events;
+    events.reserve(written - first);
+    for (uint64_t index = first; index < written; ++index) {
+      const Event& event = events_[index % capacity_];
+      events.push_back(EventCopy{event.name.load(std::memory_order_relaxed),
+                                 event.timestamp_ns.load(std::memory_order_relaxed),
+                                 event.value.load(std::memory_order_relaxed),
+                                 event.kind.load(std::memory_order_relaxed)});
+    }
+
+    // drop the events whose slots were reused while copying
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t claimed = claimed_.load(std::memory_order_relaxed);
+    if (claimed > first + capacity_) {
+      const size_t torn = std::min<size_t>(claimed - first - capacity_, events.size());
+      events.erase(events.begin(), events.begin() + torn);
+    }
+
+    return events;
+  }
+
+  // guarded by the profiler's mutex
+  std::string name;
+
+ private:
+  const uint32_t tid_;
+  const std::thread::id thread_id_;
+  const size_t capacity_;
+  const std::unique_ptr<Event[]> events_;
+
+  std::atomic_uint64_t claimed_{0};
+  std::atomic_uint64_t written_{0};
+};
+
+Profiler::Profiler(size_t events_per_thread)
+    : id_(next_profiler_id.fetch_add(1)),
+      events_per_thread_(std::max<size_t>(events_per_thread, 1)) {}
+
+Profiler::~Profiler() = default;
+
+Profiler* Profiler::global() {
+  // leaked, zones may close during static destruction
+  static Profiler* profiler = new Profiler();
+  return profiler;
+}
+
+uint64_t Profiler::now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void Profiler::record_zone(const char* name, uint64_t begin_ns, uint64_t end_ns) {
+  thread_buffer()->record(EventKind::kZone, name, begin_ns,
+                          static_cast<int64_t>(end_ns - begin_ns));
+}
+
+void Profiler::record_counter(const char* name, int64_t value) {
+  thread_buffer()->record(EventKind::kCounter, name, now(), value);
+}
+
+void Profiler::set_thread_name(const std::string& name) {
+  ThreadBuffer* buffer = thread_buffer();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  buffer->name = name;
+}
+
+Profiler::ThreadBuffer* Profiler::thread_buffer() {
+  // the buffer of the last profiler this thread recorded to
+  thread_local uint64_t cached_id = 0;
+  thread_local ThreadBuffer* cached_buffer = nullptr;
+  if (cached_id == id_) {
+    return cached_buffer;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  ThreadBuffer* buffer = nullptr;
+  for (const auto& candidate : buffers_) {
+    if (candidate->thread_id() == std::this_thread::get_id()) {
+      buffer = candidate.get();
+      break;
+    }
+  }
+  if (!buffer) {
+    buffers_.push_back(std::make_unique<ThreadBuffer>(static_cast<uint32_t>(buffers_.size() + 1),
+                                                      events_per_thread_));
+    buffer = buffers_.back().get();
+  }
+
+  cached_id = id_;
+  cached_buffer = buffer;
+  return buffer;
+}
+
+std::string Profiler::chrome_trace() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  auto begin_event = [&]() {
+    if (!first) {
+      out.push_back(',');
+    }
+    first = false;
+  };
+
+  for (const auto& buffer : buffers_) {
+    if (!buffer->name.empty()) {
+      begin_event();
+      absl::StrAppendFormat(&out, "{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_name\",",
+                            buffer->tid());
+      out += "\"args\":{\"name\":";
+      append_json_string(&out, buffer->name.c_str());
+      out += "}}";
+    }
+
+    for (const EventCopy& event : buffer->snapshot()) {
+      begin_event();
+      out += "{\"name\":";
+      append_json_string(&out, event.name);
+
+      // timestamps are in microseconds
+      const double timestamp_us = static_cast<double>(event.timestamp_ns) / 1000.0;
+      absl::StrAppendFormat(&out, ",\"pid\":1,\"tid\":%d,\"ts\":%.3f", buffer->tid(),
+                            timestamp_us);
+      if (event.kind == EventKind::kZone) {
+        absl::StrAppendFormat(&out, ",\"ph\":\"X\",\"dur\":%.3f}",
+                              static_cast<double>(event.value) / 1000.0);
+      } else {
+        absl::StrAppendFormat(&out, ",\"ph\":\"C\",\"args\":{\"value\":%d}}", event.value);
+      }
+    }
+  }
+
+  out += "]}";
+  return out;
+}
+
+absl::Status Profiler::write_chrome_trace(const std::string& path) const {
+  const std::string trace = chrome_trace();
+
+  FILE* file = std::fopen(path.c_str(), "wb");
+  if (!file) {
+    return absl::NotFoundError(absl::StrFormat("failed to open file, path: %s", path));
+  }
+
+  const size_t written = std::fwrite(trace.data(), 1, trace.size(), file);
+  const bool closed = std::fclose(file) == 0;
+  if (written != trace.size() || !closed) {
+    return absl::UnknownError(absl::StrFormat("failed to write file, path: %s", path));
+  }
+
+  return absl::OkStatus();
+}
+}  // namespace core
+}  // namespace lance
@@ -0,0 +1,112 @@
+#include "profiler.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace lance {
+namespace core {
+namespace {
+size_t count_of(const std::string& str, const std::string& pattern) {
+  size_t count = 0;
+  for (size_t pos = str.find(pattern); pos != std::string::npos;
+       pos = str.find(pattern, pos + pattern.size())) {
+    ++count;
+  }
+  return count;
+}
+}  // namespace
+
+TEST(profiler, disabled_records_nothing) {
+  Profiler profiler;
+  { ScopedZone zone("idle", &profiler); }
+
+  ASSERT_EQ("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[]}", profiler.chrome_trace());
+}
+
+TEST(profiler, zones_and_counters) {
+  Profiler profiler;
+  profiler.set_enabled(true);
+  profiler.set_thread_name("main \"thread\"");
+
+  {
+    ScopedZone outer("frame", &profiler);
+    ScopedZone inner("record", &profiler);
+  }
+  profiler.record_counter("draw_calls", 42);
+
+  const std::string trace = profiler.chrome_trace();
+  ASSERT_EQ(1, count_of(trace, "\"name\":\"frame\""));
+  ASSERT_EQ(1, count_of(trace, "\"name\":\"record\""));
+  ASSERT_EQ(2, count_of(trace, "\"ph\":\"X\""));
+  ASSERT_EQ(1, count_of(trace, "\"ph\":\"C\",\"args\":{\"value\":42}"));
+  ASSERT_EQ(1, count_of(trace, "\"args\":{\"name\":\"main \\\"thread\\\"\"}"));
+}
+
+TEST(profiler, keeps_newest_events) {
+  Profiler profiler(4);
+  profiler.set_enabled(true);
+
+  for (int64_t i = 0; i < 10; ++i) {
+    profiler.record_counter("value", i);
+  }
+
+  const std::string trace = profiler.chrome_trace();
+  ASSERT_EQ(4, count_of(trace, "\"ph\":\"C\""));
+  ASSERT_EQ(0, count_of(trace, "\"value\":5}"));
+  ASSERT_EQ(1, count_of(trace, "\"value\":6}"));
+  ASSERT_EQ(1, count_of(trace, "\"value\":9}"));
+}
+
+TEST(profiler, dump_while_recording) {
+  Profiler profiler(256);
+  profiler.set_enabled(true);
+
+  std::atomic_bool stop{false};
+  std::atomic_int wrapped{0};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&]() {
+      for (int count = 0; !stop.load(); ++count) {
+        ScopedZone zone("work", &profiler);
+        if (count == 1000) {
+          wrapped.fetch_add(1);
+        }
+      }
+    });
+  }
+  while (wrapped.load() < 4) {
+    std::this_thread::yield();
+  }
+
+  // every dump only holds whole events, at most one ring per thread
+  for (int i = 0; i < 50; ++i) {
+    const std::string trace = profiler.chrome_trace();
+    ASSERT_LE(count_of(trace, "\"name\":\"work\""), 4 * 256);
+    ASSERT_EQ(count_of(trace, "{\"name\":"), count_of(trace, "\"name\":\"work\""));
+  }
+
+  stop = true;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_EQ(4 * 256, count_of(profiler.chrome_trace(), "\"name\":\"work\""));
+}
+
+TEST(profiler, macros) {
+  Profiler::global()->set_enabled(true);
+  {
+    LANCE_PROFILE_ZONE("profiler_test_zone");
+    LANCE_PROFILE_COUNTER("profiler_test_counter", 7);
+  }
+  Profiler::global()->set_enabled(false);
+
+  const std::string trace = Profiler::global()->chrome_trace();
+  ASSERT_EQ(1, count_of(trace, "\"name\":\"profiler_test_zone\""));
+  ASSERT_EQ(1, count_of(trace, "\"name\":\"profiler_test_counter\""));
+}
+}  // namespace core
+}  // namespace lance
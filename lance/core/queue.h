@@ -0,0 +1,213 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace lance {
+namespace core {
+// indices written by different threads live on their own cache lines
+constexpr size_t kCacheLineSize = 64;
+
+namespace detail {
+inline size_t round_up_to_power_of_two(size_t value) {
+  size_t result = 1;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+
+// uninitialized storage for one element
+template <typename T>
+struct QueueSlot {
+  alignas(T) unsigned char storage[sizeof(T)];
+
+  T* get() { return std::launder(reinterpret_cast<T*>(storage)); }
+};
+}  // namespace detail
+
+// bounded lock-free ring buffer for exactly one producer and one consumer thread. the capacity is
+// rounded up to a power of two.
+template <typename T>
+class SpscQueue {
+ public:
+  explicit SpscQueue(size_t capacity)
+      : capacity_(detail::round_up_to_power_of_two(std::max<size_t>(capacity, 2))),
+        mask_(capacity_ - 1),
+        slots_(new detail::QueueSlot<T>[capacity_]) {}
+
+  ~SpscQueue() {
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    for (size_t head = head_.load(std::memory_order_relaxed); head != tail; ++head) {
+      slots_[head & mask_].get()->~T();
+    }
+  }
+
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  size_t capacity() const { return capacity_; }
+
+  // producer only, false if the queue is full
+  template <typename U>
+  bool try_push(U&& value) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ == capacity_) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail - cached_head_ == capacity_) {
+        return false;
+      }
+    }
+
+    new (slots_[tail & mask_].storage) T(std::forward<U>(value));
+    tail_.store(tail + 1, std::memory_order_release);
+
+    return true;
+  }
+
+  // consumer only, false if the queue is empty
+  bool try_pop(T* value) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head == cached_tail_) {
+        return false;
+      }
+    }
+
+    T* slot = slots_[head & mask_].get();
+    *value = std::move(*slot);
+    slot->~T();
+    head_.store(head + 1, std::memory_order_release);
+
+    return true;
+  }
+
+  // a snapshot, exact only on the producer or consumer thread while the other one is idle
+  size_t size_approx() const {
+    return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+  }
+
+ private:
+  const size_t capacity_;
+  const size_t mask_;
+  const std::unique_ptr<detail::QueueSlot<T>[]> slots_;
+
+  // consumer side, with its last seen tail
+  alignas(kCacheLineSize) std::atomic_size_t head_{0};
+  size_t cached_tail_ = 0;
+
+  // producer side, with its last seen head
+  alignas(kCacheLineSize) std::atomic_size_t tail_{0};
+  size_t cached_head_ = 0;
+};
+
+// bounded lock-free ring buffer for any number of producers and consumers, after dmitry vyukov's
+// design. every slot carries a sequence number telling whether it is ready for the push or the pop
+// of a given lap, so that a thread only contends on the index it claims. the capacity is rounded
+// up to a power of two.
+template <typename T>
+class MpmcQueue {
+ public:
+  explicit MpmcQueue(size_t capacity)
+      : capacity_(detail::round_up_to_power_of_two(std::max<size_t>(capacity, 2))),
+        mask_(capacity_ - 1),
+        cells_(new Cell[capacity_]) {
+    for (size_t i = 0; i < capacity_; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  ~MpmcQueue() {
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    for (size_t head = head_.load(std::memory_order_relaxed); head != tail; ++head) {
+      cells_[head & mask_].slot.get()->~T();
+    }
+  }
+
+  MpmcQueue(const MpmcQueue&) = delete;
+  MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+  size_t capacity() const { return capacity_; }
+
+  // false if the queue is full
+  template <typename U>
+  bool try_push(U&& value) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    Cell* cell = nullptr;
+    while (true) {
+      cell = &cells_[tail & mask_];
+      const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(tail);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        // the slot still holds the value of the previous lap
+        return false;
+      } else {
+        tail = tail_.load(std::memory_order_relaxed);
+      }
+    }
+
+    new (cell->slot.storage) T(std::forward<U>(value));
+    cell->sequence.store(tail + 1, std::memory_order_release);
+
+    return true;
+  }
+
+  // false if the queue is empty
+  bool try_pop(T* value) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    Cell* cell = nullptr;
+    while (true) {
+      cell = &cells_[head & mask_];
+      const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(head + 1);
+      if (diff == 0) {
+        if (head_.compare_exchange_weak(head, head + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        head = head_.load(std::memory_order_relaxed);
+      }
+    }
+
+    T* slot = cell->slot.get();
+    *value = std::move(*slot);
+    slot->~T();
+    cell->sequence.store(head + capacity_, std::memory_order_release);
+
+    return true;
+  }
+
+  // a snapshot, may be stale by the time it returns
+  size_t size_approx() const {
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    const size_t head = head_.load(std::memory_order_acquire);
+    return tail > head ? tail - head : 0;
+  }
+
+ private:
+  struct Cell {
+    std::atomic_size_t sequence;
+    detail::QueueSlot<T> slot;
+  };
+
+  const size_t capacity_;
+  const size_t mask_;
+  const std::unique_ptr<Cell[]> cells_;
+
+  alignas(kCacheLineSize) std::atomic_size_t head_{0};
+  alignas(kCacheLineSize) std::atomic_size_t tail_{0};
+};
+}  // namespace core
+}  // namespace lance
@@ -0,0 +1,104 @@
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "queue.h"
+
+namespace lance {
+namespace core {
+namespace {
+// the baseline, a mutex around a std::deque with the same bound
+template <typename T>
+class MutexQueue {
+ public:
+  explicit MutexQueue(size_t capacity) : capacity_(capacity) {}
+
+  bool try_push(T value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queue_.size() == capacity_) {
+      return false;
+    }
+    queue_.push_back(value);
+    return true;
+  }
+
+  bool try_pop(T* value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queue_.empty()) {
+      return false;
+    }
+    *value = queue_.front();
+    queue_.pop_front();
+    return true;
+  }
+
+ private:
+  const size_t capacity_;
+  std::mutex mutex_;
+  std::deque<T> queue_;
+};
+
+constexpr size_t kCapacity = 1024;
+constexpr uint64_t kItems = 1 << 18;
+
+// hand kItems over from the producers to the consumers, spread evenly
+template <typename Queue>
+void transfer(Queue* queue, uint32_t producers, uint32_t consumers) {
+  std::vector<std::thread> threads;
+  for (uint32_t p = 0; p < producers; ++p) {
+    threads.emplace_back([queue, producers]() {
+      for (uint64_t i = 0; i < kItems / producers; ++i) {
+        while (!queue->try_push(i)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (uint32_t c = 0; c < consumers; ++c) {
+    threads.emplace_back([queue, consumers]() {
+      uint64_t value = 0;
+      for (uint64_t i = 0; i < kItems / consumers;) {
+        if (queue->try_pop(&value)) {
+          benchmark::DoNotOptimize(value);
+          ++i;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+template <typename Queue>
+void BM_queue(benchmark::State& state) {
+  const auto producers = static_cast<uint32_t>(state.range(0));
+  const auto consumers = static_cast<uint32_t>(state.range(1));
+
+  Queue queue(kCapacity);
+  for (auto _ : state) {
+    transfer(&queue, producers, consumers);
+  }
+
+  state.SetItemsProcessed(state.iterations() * kItems);
+}
+
+BENCHMARK_TEMPLATE(BM_queue, SpscQueue<uint64_t>)->Args({1, 1})->UseRealTime();
+BENCHMARK_TEMPLATE(BM_queue, MpmcQueue<uint64_t>)
+    ->Args({1, 1})
+    ->Args({2, 2})
+    ->Args({4, 4})
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_queue, MutexQueue<uint64_t>)
+    ->Args({1, 1})
+    ->Args({2, 2})
+    ->Args({4, 4})
+    ->UseRealTime();
+}  // namespace
+}  // namespace core
+}  // namespace lance
@@ -0,0 +1,148 @@
+#include "queue.h"
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace lance {
+namespace core {
+template <typename Queue>
+void check_fifo() {
+  Queue queue(5);
+  ASSERT_EQ(8, queue.capacity());
+
+  int value = 0;
+  ASSERT_FALSE(queue.try_pop(&value));
+
+  // wrap around a few laps
+  for (int lap = 0; lap < 3; ++lap) {
+    for (int i = 0; i < 8; ++i) {
+      ASSERT_TRUE(queue.try_push(lap * 8 + i));
+    }
+    ASSERT_FALSE(queue.try_push(-1));
+    ASSERT_EQ(8, queue.size_approx());
+
+    for (int i = 0; i < 8; ++i) {
+      ASSERT_TRUE(queue.try_pop(&value));
+      ASSERT_EQ(lap * 8 + i, value);
+    }
+    ASSERT_FALSE(queue.try_pop(&value));
+  }
+}
+
+TEST(queue, spsc_fifo) { check_fifo<SpscQueue<int>>(); }
+
+TEST(queue, mpmc_fifo) { check_fifo<MpmcQueue<int>>(); }
+
+template <typename Queue>
+void check_non_trivial() {
+  auto tracked = std::make_shared<int>(0);
+  {
+    Queue queue(4);
+    ASSERT_TRUE(queue.try_push(tracked));
+    ASSERT_TRUE(queue.try_push(tracked));
+
+    std::shared_ptr<int> value;
+    ASSERT_TRUE(queue.try_pop(&value));
+    ASSERT_EQ(tracked, value);
+    value.reset();
+    ASSERT_EQ(2, tracked.use_count());
+  }
+
+  // the queue destroyed what it still held
+  ASSERT_EQ(1, tracked.use_count());
+}
+
+TEST(queue, spsc_non_trivial) { check_non_trivial<SpscQueue<std::shared_ptr<int>>>(); }
+
+TEST(queue, mpmc_non_trivial) { check_non_trivial<MpmcQueue<std::shared_ptr<int>>>(); }
+
+TEST(queue, spsc_stress) {
+  constexpr uint64_t kCount = 1 << 20;
+  SpscQueue<uint64_t> queue(64);
+
+  std::thread producer([&queue]() {
+    for (uint64_t i = 0; i < kCount; ++i) {
+      while (!queue.try_push(i)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  // the single consumer sees every value in order
+  uint64_t expected = 0;
+  while (expected < kCount) {
+    uint64_t value = 0;
+    if (queue.try_pop(&value)) {
+      ASSERT_EQ(expected, value);
+      ++expected;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+
+  producer.join();
+  ASSERT_EQ(0, queue.size_approx());
+}
+
+TEST(queue, mpmc_stress) {
+  constexpr uint32_t kProducers = 4;
+  constexpr uint32_t kConsumers = 4;
+  constexpr uint32_t kPerProducer = 1 << 17;
+  MpmcQueue<uint32_t> queue(128);
+
+  std::vector<std::thread> threads;
+  for (uint32_t p = 0; p < kProducers; ++p) {
+    threads.emplace_back([&queue, p]() {
+      for (uint32_t i = 0; i < kPerProducer; ++i) {
+        while (!queue.try_push(p * kPerProducer + i)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  // every value is popped exactly once, and each producer's values come out in order
+  std::atomic_uint32_t remaining{kProducers * kPerProducer};
+  std::vector<std::vector<uint8_t>> seen(kConsumers,
+                                         std::vector<uint8_t>(kProducers * kPerProducer, 0));
+  std::atomic_bool ordered{true};
+  for (uint32_t c = 0; c < kConsumers; ++c) {
+    threads.emplace_back([&, c]() {
+      std::vector<int64_t> last(kProducers, -1);
+      while (remaining.load(std::memory_order_relaxed) > 0) {
+        uint32_t value = 0;
+        if (!queue.try_pop(&value)) {
+          std::this_thread::yield();
+          continue;
+        }
+
+        seen[c][value] = 1;
+        const uint32_t producer = value / kPerProducer;
+        if (static_cast<int64_t>(value) <= last[producer]) {
+          ordered = false;
+        }
+        last[producer] = value;
+        remaining.fetch_sub(1, std::memory_order_relaxed);
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_TRUE(ordered.load());
+  for (uint32_t value = 0; value < kProducers * kPerProducer; ++value) {
+    uint32_t count = 0;
+    for (uint32_t c = 0; c < kConsumers; ++c) {
+      count += seen[c][value];
+    }
+    ASSERT_EQ(1, count) << "value: " << value;
+  }
+}
+}  // namespace core
+}  // namespace lance
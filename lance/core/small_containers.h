@@ -0,0 +1,92 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+
+#include "absl/container/inlined_vector.h"
+
+namespace lance {
+namespace core {
+// vector keeping its first N elements inline, for the short lists of pipeline setup and command
+// recording which would otherwise allocate on every call
+template <typename T, size_t N = 8>
+using SmallVector = absl::InlinedVector<T, N>;
+
+// map over a sorted SmallVector of pairs, for a handful of entries with small keys. lookups are a
+// binary search over contiguous memory, no hashing and no allocation up to N entries. iteration
+// is in key order. inserting or erasing invalidates iterators and references.
+template <typename K, typename V, size_t N = 8>
+class SmallFlatMap {
+ public:
+  using key_type = K;
+  using mapped_type = V;
+  using value_type = std::pair<K, V>;
+  using iterator = typename SmallVector<value_type, N>::iterator;
+  using const_iterator = typename SmallVector<value_type, N>::const_iterator;
+
+  iterator begin() { return entries_.begin(); }
+  iterator end() { return entries_.end(); }
+  const_iterator begin() const { return entries_.begin(); }
+  const_iterator end() const { return entries_.end(); }
+
+  size_t size() const { return entries_.size(); }
+
+  bool empty() const { return entries_.empty(); }
+
+  void clear() { entries_.clear(); }
+
+  iterator find(const K& key) {
+    auto it = lower_bound(key);
+    return it != entries_.end() && !(key < it->first) ? it : entries_.end();
+  }
+
+  const_iterator find(const K& key) const {
+    auto it = lower_bound(key);
+    return it != entries_.end() && !(key < it->first) ? it : entries_.end();
+  }
+
+  bool contains(const K& key) const { return find(key) != end(); }
+
+  // inserts a value-initialized entry if `key` is missing
+  V& operator[](const K& key) { return try_emplace(key).first->second; }
+
+  // returns the entry of `key` and whether it was inserted, an existing entry is left untouched
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const K& key, Args&&... args) {
+    auto it = lower_bound(key);
+    if (it != entries_.end() && !(key < it->first)) {
+      return {it, false};
+    }
+
+    it = entries_.emplace(it, std::piecewise_construct, std::forward_as_tuple(key),
+                          std::forward_as_tuple(std::forward<Args>(args)...));
+    return {it, true};
+  }
+
+  // number of entries erased
+  size_t erase(const K& key) {
+    auto it = find(key);
+    if (it == entries_.end()) {
+      return 0;
+    }
+
+    entries_.erase(it);
+    return 1;
+  }
+
+ private:
+  iterator lower_bound(const K& key) {
+    return std::lower_bound(entries_.begin(), entries_.end(), key,
+                            [](const value_type& entry, const K& k) { return entry.first < k; });
+  }
+
+  const_iterator lower_bound(const K& key) const {
+    return std::lower_bound(entries_.begin(), entries_.end(), key,
+                            [](const value_type& entry, const K& k) { return entry.first < k; });
+  }
+
+  SmallVector<value_type, N> entries_;
+};
+}  // namespace core
+}  // namespace lance
@@ -0,0 +1,92 @@
+#include "small_containers.h"
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace lance {
+namespace core {
+TEST(small_containers, vector_stays_inline) {
+  SmallVector<int, 4> values;
+  for (int i = 0; i < 4; ++i) {
+    values.push_back(i);
+  }
+  const int* inline_data = values.data();
+  ASSERT_EQ(4, values.size());
+
+  // growing past N moves to the heap
+  values.push_back(4);
+  ASSERT_NE(inline_data, values.data());
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_EQ(i, values[i]);
+  }
+}
+
+TEST(small_containers, flat_map_is_sorted) {
+  SmallFlatMap<int, std::string, 4> map;
+  ASSERT_TRUE(map.empty());
+
+  map[3] = "c";
+  map[1] = "a";
+  ASSERT_TRUE(map.try_emplace(2, "b").second);
+  ASSERT_FALSE(map.try_emplace(2, "x").second);
+  ASSERT_EQ("b", map.find(2)->second);
+
+  int expected = 1;
+  for (const auto& pair : map) {
+    ASSERT_EQ(expected++, pair.first);
+  }
+
+  ASSERT_TRUE(map.contains(3));
+  ASSERT_FALSE(map.contains(4));
+  ASSERT_TRUE(map.find(0) == map.end());
+
+  ASSERT_EQ(1, map.erase(1));
+  ASSERT_EQ(0, map.erase(1));
+  ASSERT_EQ(2, map.size());
+  ASSERT_EQ(2, map.begin()->first);
+
+  map.clear();
+  ASSERT_TRUE(map.empty());
+}
+
+TEST(small_containers, flat_map_matches_std_map) {
+  SmallFlatMap<uint32_t, uint32_t> map;
+  std::map<uint32_t, uint32_t> reference;
+
+  uint32_t state = 7;
+  for (int i = 0; i < 1000; ++i) {
+    state = state * 1664525u + 1013904223u;
+    const uint32_t key = (state >> 16) % 32;
+    if (state & 1) {
+      map[key] += i;
+      reference[key] += i;
+    } else {
+      ASSERT_EQ(reference.erase(key), map.erase(key));
+    }
+    ASSERT_EQ(reference.size(), map.size());
+  }
+
+  auto it = map.begin();
+  for (const auto& pair : reference) {
+    ASSERT_EQ(pair.first, it->first);
+    ASSERT_EQ(pair.second, it->second);
+    ++it;
+  }
+}
+
+TEST(small_containers, flat_map_move_only_values) {
+  SmallFlatMap<int, std::unique_ptr<int>> map;
+  for (int i = 9; i >= 0; --i) {
+    map[i] = std::make_unique<int>(i * i);
+  }
+
+  ASSERT_EQ(10, map.size());
+  for (const auto& pair : map) {
+    ASSERT_EQ(pair.first * pair.first, *pair.second);
+  }
+}
+}  // namespace core
+}  // namespace lance
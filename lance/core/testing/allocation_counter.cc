@@ -0,0 +1,88 @@
+#include "allocation_counter.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace {
+std::atomic_uint64_t allocations{0};
+
+void* allocate(size_t size, size_t alignment) noexcept {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+
+  size = size ? size : 1;
+  if (alignment <= alignof(std::max_align_t)) {
+    return std::malloc(size);
+  }
+
+  // aligned_alloc wants a multiple of the alignment
+  return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+void* allocate_or_throw(size_t size, size_t alignment) {
+  if (void* ptr = allocate(size, alignment)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+}  // namespace
+
+namespace lance {
+namespace core {
+uint64_t heap_allocations() { return allocations.load(std::memory_order_relaxed); }
+}  // namespace core
+}  // namespace lance
+
+void* operator new(size_t size) { return allocate_or_throw(size, 0); }
+
+void* operator new[](size_t size) { return allocate_or_throw(size, 0); }
+
+void* operator new(size_t size, std::align_val_t alignment) {
+  return allocate_or_throw(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+  return allocate_or_throw(size, static_cast<size_t>(alignment));
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return allocate(size, 0); }
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return allocate(size, 0); }
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  return allocate(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  return allocate(size, static_cast<size_t>(alignment));
+}
+
+// malloc and aligned_alloc both pair with free
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+  std::free(ptr);
+}
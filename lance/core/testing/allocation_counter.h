@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+namespace lance {
+namespace core {
+// global heap allocations of the binary so far. linking allocation_counter replaces every form of
+// the global operator new, aligned and nothrow ones included, to count them.
+uint64_t heap_allocations();
+}  // namespace core
+}  // namespace lance
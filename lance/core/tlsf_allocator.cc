@@ -0,0 +1,226 @@
+#include "tlsf_allocator.h"
+
+#include <algorithm>
+
+#include "glog/logging.h"
+
+namespace lance {
+namespace core {
+namespace {
+uint32_t floor_log2(uint64_t v) { return 63 - __builtin_clzll(v); }
+}  // namespace
+
+TlsfAllocator::TlsfAllocator(uint64_t capacity) : capacity_(capacity) {
+  for (auto& heads : free_heads_) {
+    std::fill(std::begin(heads), std::end(heads), kInvalidBlock);
+  }
+
+  if (capacity_ > 0) {
+    const uint32_t index = new_block();
+    blocks_[index].size = capacity_;
+    blocks_[index].free = true;
+    insert_free(index);
+  }
+}
+
+void TlsfAllocator::mapping(uint64_t size, uint32_t* fl, uint32_t* sl) {
+  if (size < kSmallSize) {
+    *fl = 0;
+    *sl = static_cast<uint32_t>(size / (kSmallSize / kSecondLevelCount));
+    return;
+  }
+
+  const uint32_t log2 = floor_log2(size);
+  *fl = log2 - kSmallSizeBits + 1;
+  *sl = static_cast<uint32_t>(size >> (log2 - kSecondLevelBits)) ^ kSecondLevelCount;
+}
+
+uint32_t TlsfAllocator::new_block() {
+  if (!unused_blocks_.empty()) {
+    const uint32_t index = unused_blocks_.back();
+    unused_blocks_.pop_back();
+    blocks_[index] = Block();
+    return index;
+  }
+
+  blocks_.emplace_back();
+  return static_cast<uint32_t>(blocks_.size() - 1);
+}
+
+void TlsfAllocator::release_block(uint32_t index) {
+  blocks_[index] = Block();
+  unused_blocks_.push_back(index);
+}
+
+void TlsfAllocator::insert_free(uint32_t index) {
+  uint32_t fl, sl;
+  mapping(blocks_[index].size, &fl, &sl);
+
+  uint32_t& head = free_heads_[fl][sl];
+  blocks_[index].prev_free = kInvalidBlock;
+  blocks_[index].next_free = head;
+  if (head != kInvalidBlock) {
+    blocks_[head].prev_free = index;
+  }
+  head = index;
+
+  first_level_map_ |= uint64_t(1) << fl;
+  second_level_maps_[fl] |= 1u << sl;
+}
+
+void TlsfAllocator::remove_free(uint32_t index) {
+  uint32_t fl, sl;
+  mapping(blocks_[index].size, &fl, &sl);
+
+  const Block& block = blocks_[index];
+  if (block.prev_free != kInvalidBlock) {
+    blocks_[block.prev_free].next_free = block.next_free;
+  }
+  if (block.next_free != kInvalidBlock) {
+    blocks_[block.next_free].prev_free = block.prev_free;
+  }
+
+  uint32_t& head = free_heads_[fl][sl];
+  if (head == index) {
+    head = block.next_free;
+    if (head == kInvalidBlock) {
+      second_level_maps_[fl] &= ~(1u << sl);
+      if (second_level_maps_[fl] == 0) {
+        first_level_map_ &= ~(uint64_t(1) << fl);
+      }
+    }
+  }
+}
+
+uint32_t TlsfAllocator::find_free(uint64_t size) const {
+  // round up to the next bin, any block in it or above is large enough
+  uint64_t rounded = size;
+  if (size < kSmallSize) {
+    rounded += kSmallSize / kSecondLevelCount - 1;
+  } else {
+    rounded += (uint64_t(1) << (floor_log2(size) - kSecondLevelBits)) - 1;
+  }
+
+  uint32_t fl, sl;
+  mapping(rounded, &fl, &sl);
+
+  uint32_t sl_map = second_level_maps_[fl] & (~0u << sl);
+  if (sl_map == 0) {
+    const uint64_t fl_map = fl + 1 < 64 ? first_level_map_ & (~uint64_t(0) << (fl + 1)) : 0;
+    if (fl_map == 0) {
+      return kInvalidBlock;
+    }
+    fl = __builtin_ctzll(fl_map);
+    sl_map = second_level_maps_[fl];
+  }
+
+  return free_heads_[fl][__builtin_ctz(sl_map)];
+}
+
+uint32_t TlsfAllocator::split(uint32_t index, uint64_t size) {
+  const uint32_t tail = new_block();
+  Block& block = blocks_[index];
+
+  blocks_[tail].offset = block.offset + size;
+  blocks_[tail].size = block.size - size;
+  blocks_[tail].prev_physical = index;
+  blocks_[tail].next_physical = block.next_physical;
+  if (block.next_physical != kInvalidBlock) {
+    blocks_[block.next_physical].prev_physical = tail;
+  }
+
+  block.size = size;
+  block.next_physical = tail;
+  return tail;
+}
+
+void TlsfAllocator::merge(uint32_t index, uint32_t next) {
+  Block& block = blocks_[index];
+  block.size += blocks_[next].size;
+  block.next_physical = blocks_[next].next_physical;
+  if (block.next_physical != kInvalidBlock) {
+    blocks_[block.next_physical].prev_physical = index;
+  }
+
+  release_block(next);
+}
+
+TlsfAllocator::Allocation TlsfAllocator::allocate(uint64_t size, uint64_t alignment) {
+  DCHECK(alignment != 0 && (alignment & (alignment - 1)) == 0) << "alignment: " << alignment;
+
+  if (size == 0 || size > capacity_ || alignment > capacity_) {
+    return {};
+  }
+
+  uint32_t index = find_free(size + alignment - 1);
+  if (index == kInvalidBlock) {
+    return {};
+  }
+  remove_free(index);
+
+  const uint64_t offset = blocks_[index].offset;
+  const uint64_t padding = ((offset + alignment - 1) & ~(alignment - 1)) - offset;
+  if (padding > 0) {
+    // the previous block is in use, otherwise it had been merged with this one
+    const uint32_t tail = split(index, padding);
+    blocks_[index].free = true;
+    insert_free(index);
+    index = tail;
+  }
+
+  if (blocks_[index].size - size >= kMinSplitSize) {
+    const uint32_t tail = split(index, size);
+    blocks_[tail].free = true;
+    insert_free(tail);
+  }
+
+  blocks_[index].free = false;
+  used_bytes_ += blocks_[index].size;
+  ++allocation_count_;
+
+  return {blocks_[index].offset, size, index};
+}
+
+void TlsfAllocator::free(const Allocation& allocation) {
+  CHECK(allocation.valid());
+  uint32_t index = allocation.block;
+  CHECK(!blocks_[index].free) << "double free at offset " << allocation.offset;
+
+  used_bytes_ -= blocks_[index].size;
+  --allocation_count_;
+  blocks_[index].free = true;
+
+  const uint32_t prev = blocks_[index].prev_physical;
+  if (prev != kInvalidBlock && blocks_[prev].free) {
+    remove_free(prev);
+    merge(prev, index);
+    index = prev;
+  }
+
+  const uint32_t next = blocks_[index].next_physical;
+  if (next != kInvalidBlock && blocks_[next].free) {
+    remove_free(next);
+    merge(index, next);
+  }
+
+  insert_free(index);
+}
+
+TlsfAllocator::Stats TlsfAllocator::stats() const {
+  Stats stats;
+  stats.capacity = capacity_;
+  stats.used_bytes = used_bytes_;
+  stats.free_bytes = capacity_ - used_bytes_;
+  stats.allocation_count = allocation_count_;
+
+  for (const auto& block : blocks_) {
+    if (block.free) {
+      ++stats.free_range_count;
+      stats.largest_free_range = std::max(stats.largest_free_range, block.size);
+    }
+  }
+
+  return stats;
+}
+}  // namespace core
+}  // namespace lance
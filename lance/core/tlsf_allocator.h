@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace lance {
+namespace core {
+// two-level segregated fit allocator over offsets in [0, capacity). it hands out ranges of memory
+// it does not own, e.g. of a VkDeviceMemory block. allocate and free are O(1): free ranges are
+// kept in lists binned by size, two bitmaps find the first non-empty list that fits, and freed
+// ranges merge with their free neighbours right away. not thread-safe.
+class TlsfAllocator {
+ public:
+  static constexpr uint32_t kInvalidBlock = UINT32_MAX;
+
+  struct Allocation {
+    uint64_t offset = 0;
+    uint64_t size = 0;
+    // internal, identifies the range when it is freed
+    uint32_t block = kInvalidBlock;
+
+    bool valid() const { return block != kInvalidBlock; }
+  };
+
+  struct Stats {
+    uint64_t capacity = 0;
+    // includes the padding of alignment and of remainders too small to split off
+    uint64_t used_bytes = 0;
+    uint64_t free_bytes = 0;
+    uint64_t largest_free_range = 0;
+    uint32_t allocation_count = 0;
+    uint32_t free_range_count = 0;
+
+    // 0 when the free memory is one range, close to 1 when it is scattered in small ones
+    double fragmentation() const {
+      return free_bytes == 0 ? 0.0
+                             : 1.0 - static_cast<double>(largest_free_range) / free_bytes;
+    }
+  };
+
+  explicit TlsfAllocator(uint64_t capacity);
+
+  // `alignment` must be a power of two. the result is invalid if no free range fits.
+  Allocation allocate(uint64_t size, uint64_t alignment = 1);
+
+  void free(const Allocation& allocation);
+
+  uint64_t capacity() const { return capacity_; }
+
+  // nothing allocated
+  bool empty() const { return allocation_count_ == 0; }
+
+  Stats stats() const;
+
+ private:
+  static constexpr uint32_t kSecondLevelBits = 5;
+  static constexpr uint32_t kSecondLevelCount = 1 << kSecondLevelBits;
+  // sizes below are binned linearly in first level 0
+  static constexpr uint32_t kSmallSizeBits = 8;
+  static constexpr uint64_t kSmallSize = uint64_t(1) << kSmallSizeBits;
+  static constexpr uint32_t kFirstLevelCount = 64 - kSmallSizeBits + 1;
+  // remainders smaller than this stay with the allocation
+  static constexpr uint64_t kMinSplitSize = 64;
+
+  struct Block {
+    uint64_t offset = 0;
+    uint64_t size = 0;
+    uint32_t prev_physical = kInvalidBlock;
+    uint32_t next_physical = kInvalidBlock;
+    uint32_t prev_free = kInvalidBlock;
+    uint32_t next_free = kInvalidBlock;
+    bool free = false;
+  };
+
+  static void mapping(uint64_t size, uint32_t* fl, uint32_t* sl);
+
+  uint32_t new_block();
+  void release_block(uint32_t index);
+
+  void insert_free(uint32_t index);
+  void remove_free(uint32_t index);
+
+  // first free block of at least `size` bytes, or kInvalidBlock
+  uint32_t find_free(uint64_t size) const;
+
+  // cuts `index` after `size` bytes and returns the tail, which is in no free list yet
+  uint32_t split(uint32_t index, uint64_t size);
+
+  // merges `next` into its physical predecessor `index`
+  void merge(uint32_t index, uint32_t next);
+
+  const uint64_t capacity_;
+
+  std::vector<Block> blocks_;
+  std::vector<uint32_t> unused_blocks_;
+
+  uint64_t first_level_map_ = 0;
+  uint32_t second_level_maps_[kFirstLevelCount] = {};
+  uint32_t free_heads_[kFirstLevelCount][kSecondLevelCount];
+
+  uint64_t used_bytes_ = 0;
+  uint32_t allocation_count_ = 0;
+};
+}  // namespace core
+}  // namespace lance
@@ -0,0 +1,113 @@
+#include "tlsf_allocator.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace lance {
+namespace core {
+TEST(tlsf_allocator, allocate_and_merge) {
+  TlsfAllocator allocator(1 << 20);
+
+  auto a = allocator.allocate(1000);
+  auto b = allocator.allocate(4096, 4096);
+  auto c = allocator.allocate(300000, 256);
+  ASSERT_TRUE(a.valid());
+  ASSERT_TRUE(b.valid());
+  ASSERT_TRUE(c.valid());
+  ASSERT_EQ(0, b.offset % 4096);
+  ASSERT_EQ(0, c.offset % 256);
+  ASSERT_LE(a.offset + a.size, b.offset);
+  ASSERT_EQ(3, allocator.stats().allocation_count);
+
+  allocator.free(b);
+  allocator.free(a);
+  allocator.free(c);
+
+  // everything merged back into one range
+  const auto stats = allocator.stats();
+  ASSERT_TRUE(allocator.empty());
+  ASSERT_EQ(0, stats.used_bytes);
+  ASSERT_EQ(1, stats.free_range_count);
+  ASSERT_EQ(1 << 20, stats.largest_free_range);
+  ASSERT_EQ(0.0, stats.fragmentation());
+}
+
+TEST(tlsf_allocator, exhaustion) {
+  TlsfAllocator allocator(1 << 16);
+
+  ASSERT_FALSE(allocator.allocate(0).valid());
+  ASSERT_FALSE(allocator.allocate((1 << 16) + 1).valid());
+
+  auto all = allocator.allocate(1 << 16);
+  ASSERT_TRUE(all.valid());
+  ASSERT_EQ(0, all.offset);
+  ASSERT_FALSE(allocator.allocate(1).valid());
+
+  allocator.free(all);
+  ASSERT_TRUE(allocator.allocate(1 << 15, 1 << 15).valid());
+}
+
+TEST(tlsf_allocator, fragmentation) {
+  TlsfAllocator allocator(64 * 1024);
+
+  std::vector<TlsfAllocator::Allocation> allocations;
+  for (int i = 0; i < 64; ++i) {
+    allocations.push_back(allocator.allocate(1024));
+    ASSERT_TRUE(allocations.back().valid());
+  }
+  // free every other one, 32 separate holes of 1 KiB
+  for (int i = 0; i < 64; i += 2) {
+    allocator.free(allocations[i]);
+  }
+
+  const auto stats = allocator.stats();
+  ASSERT_EQ(32, stats.free_range_count);
+  ASSERT_EQ(32 * 1024, stats.free_bytes);
+  ASSERT_EQ(1024, stats.largest_free_range);
+  ASSERT_NEAR(1.0 - 1.0 / 32, stats.fragmentation(), 1e-9);
+  ASSERT_FALSE(allocator.allocate(2048).valid());
+}
+
+TEST(tlsf_allocator, random_no_overlap) {
+  constexpr uint64_t kCapacity = 16 << 20;
+  TlsfAllocator allocator(kCapacity);
+  std::mt19937 rng(42);
+
+  std::vector<TlsfAllocator::Allocation> live;
+  for (int i = 0; i < 20000; ++i) {
+    if (!live.empty() && rng() % 3 == 0) {
+      const size_t j = rng() % live.size();
+      allocator.free(live[j]);
+      live[j] = live.back();
+      live.pop_back();
+      continue;
+    }
+
+    const uint64_t size = 1 + rng() % (64 * 1024);
+    const uint64_t alignment = uint64_t(1) << (rng() % 13);
+    auto allocation = allocator.allocate(size, alignment);
+    if (!allocation.valid()) {
+      continue;
+    }
+    ASSERT_EQ(0, allocation.offset % alignment);
+    ASSERT_LE(allocation.offset + allocation.size, kCapacity);
+    live.push_back(allocation);
+  }
+
+  std::sort(live.begin(), live.end(),
+            [](const auto& a, const auto& b) { return a.offset < b.offset; });
+  for (size_t i = 1; i < live.size(); ++i) {
+    ASSERT_LE(live[i - 1].offset + live[i - 1].size, live[i].offset);
+  }
+
+  for (const auto& allocation : live) {
+    allocator.free(allocation);
+  }
+  ASSERT_EQ(1, allocator.stats().free_range_count);
+  ASSERT_EQ(kCapacity, allocator.stats().largest_free_range);
+}
+}  // namespace core
+}  // namespace lance
@@ -1,27 +1,93 @@
 #pragma once
 
 #include <atomic>
+#include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <new>
 #include <stdexcept>
+#include <thread>
 #include <type_traits>
+#include <utility>
+
+#include "lance/core/allocator.h"
 
 namespace lance {
 namespace core {
-class RefCounted {
+struct AtomicRefCountPolicy {
+  using Counter = std::atomic_uint_fast64_t;
+
+  static void increment(Counter& count) { count.fetch_add(1, std::memory_order_relaxed); }
+
+  // true if this was the last reference
+  static bool decrement(Counter& count) {
+    return count.fetch_sub(1, std::memory_order_acq_rel) == 1;
+  }
+
+  static uint64_t load(const Counter& count) { return count.load(std::memory_order_relaxed); }
+};
+
+// for objects which never leave the thread that created them, debug builds check the thread
+struct NonAtomicRefCountPolicy {
+  struct Counter {
+    uint64_t value = 0;
+#if !defined(NDEBUG)
+    std::thread::id owner = std::this_thread::get_id();
+#endif
+  };
+
+  static void increment(Counter& count) {
+    assert(count.owner == std::this_thread::get_id());
+    ++count.value;
+  }
+
+  static bool decrement(Counter& count) {
+    assert(count.owner == std::this_thread::get_id());
+    return --count.value == 0;
+  }
+
+  static uint64_t load(const Counter& count) { return count.value; }
+};
+
+// intrusive reference count. add_ref/release are not virtual, only destroying the object goes
+// through the vtable.
+template <typename Policy>
+class RefCountedBase {
  public:
-  virtual ~RefCounted() = default;
+  using RefCountPolicy = Policy;
 
-  virtual void add_ref() const = 0;
-  virtual void release() const = 0;
-  virtual void delete_this() const = 0;
-  virtual uint64_t reference_count() const = 0;
+  virtual ~RefCountedBase() = default;
+
+  void add_ref() const { Policy::increment(count_); }
+
+  void release() const {
+    if (Policy::decrement(count_)) {
+      delete_this();
+    }
+  }
+
+  uint64_t reference_count() const { return Policy::load(count_); }
+
+  // called once the last reference is released, overridden by make_refcounted to return the
+  // memory to its allocator
+  virtual void delete_this() const { delete this; }
+
+ private:
+  mutable typename Policy::Counter count_{};
 };
 
+using RefCounted = RefCountedBase<AtomicRefCountPolicy>;
+
+using ThreadConfinedRefCounted = RefCountedBase<NonAtomicRefCountPolicy>;
+
+template <typename T>
+constexpr bool is_ref_counted_v = std::is_base_of_v<RefCounted, T> ||
+                                  std::is_base_of_v<ThreadConfinedRefCounted, T>;
+
 template <typename T>
 class RefCountPtr {
  public:
-  static_assert(std::is_base_of_v<RefCounted, T>);
+  static_assert(is_ref_counted_v<T>);
 
   RefCountPtr() = default;
 
@@ -105,28 +171,47 @@ class RefCountPtr {
   T* ptr_ = nullptr;
 };
 
+// allocate the object from `allocator`, its memory goes back to the same allocator once the last
+// reference is released
 template <typename T, typename... Args>
-inline RefCountPtr<T> make_refcounted(Args&&... args) {
-  static_assert(std::is_base_of_v<RefCounted, T>);
+inline RefCountPtr<T> make_refcounted_with(Allocator* allocator, Args&&... args) {
+  static_assert(is_ref_counted_v<T>);
 
   class Impl : public T {
    public:
     using T::T;
 
-    void add_ref() const final { count_.fetch_add(1, std::memory_order_relaxed); }
-    void release() const final {
-      if (count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
-        delete_this();
-      }
+    void set_allocator(Allocator* allocator) { allocator_ = allocator; }
+
+    void delete_this() const final {
+      Allocator* allocator = allocator_;
+      Impl* self = const_cast<Impl*>(this);
+
+      self->~Impl();
+      allocator->deallocate(self, sizeof(Impl), alignof(Impl));
     }
-    void delete_this() const final { delete this; }
-    uint64_t reference_count() const final { return count_.load(); }
 
    private:
-    mutable std::atomic_uint_fast64_t count_{0};
+    Allocator* allocator_ = nullptr;
   };
 
-  return RefCountPtr<Impl>(new Impl(std::forward<Args>(args)...));
+  void* memory = allocator->allocate(sizeof(Impl), alignof(Impl));
+
+  Impl* impl = nullptr;
+  try {
+    impl = new (memory) Impl(std::forward<Args>(args)...);
+  } catch (...) {
+    allocator->deallocate(memory, sizeof(Impl), alignof(Impl));
+    throw;
+  }
+  impl->set_allocator(allocator);
+
+  return RefCountPtr<Impl>(impl);
+}
+
+template <typename T, typename... Args>
+inline RefCountPtr<T> make_refcounted(Args&&... args) {
+  return make_refcounted_with<T>(pool_allocator(), std::forward<Args>(args)...);
 }
 
 template <typename Fn>
@@ -0,0 +1,95 @@
+#include <atomic>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "util.h"
+
+namespace lance {
+namespace core {
+namespace {
+// the previous design, where every add_ref/release is a virtual call
+class VirtualRefCounted {
+ public:
+  virtual ~VirtualRefCounted() = default;
+
+  virtual void add_ref() const = 0;
+  virtual void release() const = 0;
+};
+
+class UtilRefCountedVirtual : public VirtualRefCounted {
+ public:
+  void add_ref() const override { count_.fetch_add(1, std::memory_order_relaxed); }
+  void release() const override {
+    if (count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete this;
+    }
+  }
+
+ private:
+  mutable std::atomic_uint_fast64_t count_{0};
+};
+
+// same shape as the object in util_test
+class UtilRefCountedTest : public RefCounted {};
+
+class UtilThreadConfinedTest : public ThreadConfinedRefCounted {};
+
+// minimal intrusive pointer over the virtual interface, RefCountPtr only accepts the new bases
+class VirtualPtr {
+ public:
+  explicit VirtualPtr(VirtualRefCounted* ptr) : ptr_(ptr) { ptr_->add_ref(); }
+  VirtualPtr(const VirtualPtr& other) : ptr_(other.ptr_) { ptr_->add_ref(); }
+  ~VirtualPtr() { ptr_->release(); }
+
+ private:
+  VirtualRefCounted* ptr_;
+};
+
+// copy and drop a reference, the way lambdas and builders pass objects around
+template <typename Ptr>
+void copy_refs(benchmark::State& state, const Ptr& ptr) {
+  std::vector<Ptr> copies;
+  copies.reserve(64);
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < 64; ++i) {
+      copies.push_back(ptr);
+    }
+    benchmark::DoNotOptimize(copies.data());
+    copies.clear();
+  }
+
+  state.SetItemsProcessed(state.iterations() * 64);
+}
+
+void BM_ref_copy_virtual(benchmark::State& state) {
+  // obscure the dynamic type so the calls can not be devirtualized
+  VirtualRefCounted* object = new UtilRefCountedVirtual();
+  benchmark::DoNotOptimize(object);
+
+  copy_refs(state, VirtualPtr(object));
+}
+
+void BM_ref_copy_atomic(benchmark::State& state) {
+  copy_refs(state, make_refcounted<UtilRefCountedTest>());
+}
+
+void BM_ref_copy_non_atomic(benchmark::State& state) {
+  copy_refs(state, make_refcounted<UtilThreadConfinedTest>());
+}
+
+BENCHMARK(BM_ref_copy_virtual);
+BENCHMARK(BM_ref_copy_atomic);
+BENCHMARK(BM_ref_copy_non_atomic);
+
+// contended counter, every thread copies refs of one shared object
+void BM_ref_copy_atomic_shared(benchmark::State& state) {
+  static RefCountPtr<UtilRefCountedTest> shared = make_refcounted<UtilRefCountedTest>();
+
+  copy_refs(state, shared);
+}
+
+BENCHMARK(BM_ref_copy_atomic_shared)->ThreadRange(1, 8);
+}  // namespace
+}  // namespace core
+}  // namespace lance
@@ -10,10 +10,38 @@ class UtilRefCountedTest : public RefCounted {
   ~UtilRefCountedTest() override { LOG(INFO) << "~UtilRefCountedTest"; }
 };
 
+class UtilThreadConfinedTest : public ThreadConfinedRefCounted {
+ public:
+  explicit UtilThreadConfinedTest(bool* destroyed) : destroyed_(destroyed) {}
+
+  ~UtilThreadConfinedTest() override { *destroyed_ = true; }
+
+ private:
+  bool* destroyed_;
+};
+
 TEST(util, ref_counted) {
   auto t = make_refcounted<UtilRefCountedTest>();
 
   ASSERT_EQ(1, t->reference_count());
 }
+
+TEST(util, thread_confined_ref_counted) {
+  bool destroyed = false;
+  {
+    auto t = make_refcounted<UtilThreadConfinedTest>(&destroyed);
+    ASSERT_EQ(1, t->reference_count());
+
+    {
+      auto copy = t;
+      ASSERT_EQ(2, t->reference_count());
+    }
+
+    ASSERT_EQ(1, t->reference_count());
+    ASSERT_FALSE(destroyed);
+  }
+
+  ASSERT_TRUE(destroyed);
+}
 }  // namespace core
 }  // namespace lance
@@ -1,7 +1,10 @@
 #include "app.h"
 
+#include <cstdlib>
+
 #include "glfw/glfw3.h"
 #include "glog/logging.h"
+#include "lance/core/profiler.h"
 #include "lance/core/util.h"
 #include "lance/rendering/vk_api.h"
 
@@ -61,11 +64,20 @@ int main(int argc, char* argv[]) {
   startup_context.surface_ = lance::core::make_refcounted<lance::rendering::Surface>(
       startup_context.instance_, vk_surface);
 
+  // LANCE_TRACE_FILE=<path> records a chrome trace of the run, written on exit
+  const char* trace_file = std::getenv("LANCE_TRACE_FILE");
+  if (trace_file) {
+    lance::core::Profiler::global()->set_enabled(true);
+    lance::core::Profiler::global()->set_thread_name("main");
+  }
+
   LANCE_THROW_IF_FAILED(app->startup(&startup_context));
 
   // main loop
   auto tp0 = std::chrono::steady_clock::now();
   while (!glfwWindowShouldClose(window)) {
+    LANCE_PROFILE_ZONE("frame");
+
     glfwPollEvents();
 
     auto tp = std::chrono::steady_clock::now();
@@ -76,5 +88,9 @@ int main(int argc, char* argv[]) {
     tp0 = tp;
   }
 
+  if (trace_file) {
+    LANCE_THROW_IF_FAILED(lance::core::Profiler::global()->write_chrome_trace(trace_file));
+  }
+
   return 0;
 }
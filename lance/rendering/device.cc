@@ -1,9 +1,18 @@
 #include "device.h"
 
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "glog/logging.h"
+#include "lance/core/profiler.h"
+#include "lance/core/small_containers.h"
 #include "lance/core/util.h"
+#include "memory_allocator.h"
+#include "pipeline_cache.h"
 #include "shader_compiler.h"
 #include "vk_api.h"
 
@@ -75,7 +84,8 @@ absl::StatusOr<core::RefCountPtr<Device>> Instance::create_device(
   return absl::UnknownError("failed to create device");
 }
 
-absl::StatusOr<core::RefCountPtr<Device>> Instance::create_device_for_graphics() {
+absl::StatusOr<core::RefCountPtr<Device>> Instance::create_device_for_graphics(
+    std::string_view pipeline_cache_path) {
   LANCE_ASSIGN_OR_RETURN(physical_devices, enumerate_physical_devices());
 
   std::sort(physical_devices.begin(), physical_devices.end(),
@@ -92,6 +102,7 @@ absl::StatusOr<core::RefCountPtr<Device>> Instance::create_device_for_graphics()
             });
 
   VkPhysicalDevice target_device = VK_NULL_HANDLE;
+  std::vector<VkQueueFamilyProperties> target_queue_family_props;
   uint32_t graphics_queue_famil_index = UINT32_MAX;
   for (auto physical_device : physical_devices) {
     LANCE_ASSIGN_OR_RETURN(
@@ -107,28 +118,73 @@ absl::StatusOr<core::RefCountPtr<Device>> Instance::create_device_for_graphics()
 
     if (graphics_queue_famil_index != UINT32_MAX) {
       target_device = physical_device;
+      target_queue_family_props = std::move(queue_family_props);
       break;
     }
   }
 
+  if (target_device == VK_NULL_HANDLE) {
+    return absl::NotFoundError("no physical device with a graphics queue");
+  }
+
+  // dedicated families run compute and transfers alongside rasterization
+  std::vector<DeviceQueueFamily> queue_families = {
+      {graphics_queue_famil_index, 0, QueueKind::kGraphics}};
+  const auto find_dedicated_family = [&](VkQueueFlags required, VkQueueFlags excluded) {
+    for (uint32_t idx = 0; idx < target_queue_family_props.size(); ++idx) {
+      const VkQueueFlags flags = target_queue_family_props[idx].queueFlags;
+      if ((flags & required) == required && (flags & excluded) == 0) {
+        return idx;
+      }
+    }
+    return UINT32_MAX;
+  };
+
+  const uint32_t compute_queue_family_index =
+      find_dedicated_family(VK_QUEUE_COMPUTE_BIT, VK_QUEUE_GRAPHICS_BIT);
+  if (compute_queue_family_index != UINT32_MAX) {
+    queue_families.push_back({compute_queue_family_index, 0, QueueKind::kAsyncCompute});
+  }
+
+  const uint32_t transfer_queue_family_index =
+      find_dedicated_family(VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT);
+  if (transfer_queue_family_index != UINT32_MAX) {
+    queue_families.push_back({transfer_queue_family_index, 0, QueueKind::kTransfer});
+  }
+
+  // a few queues per family, so that independent work of one kind does not serialize
+  constexpr uint32_t kMaxQueuesPerFamily = 2;
+  const float queue_priorities[kMaxQueuesPerFamily] = {1, 1};
+
+  std::vector<VkDeviceQueueCreateInfo> queue_create_infos;
+  for (auto &queue_family : queue_families) {
+    queue_family.queue_count = std::min(
+        kMaxQueuesPerFamily, target_queue_family_props[queue_family.family_index].queueCount);
+
+    VkDeviceQueueCreateInfo queue_create_info = {};
+    queue_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queue_create_info.queueFamilyIndex = queue_family.family_index;
+    queue_create_info.queueCount = queue_family.queue_count;
+    queue_create_info.pQueuePriorities = queue_priorities;
+    queue_create_infos.push_back(queue_create_info);
+  }
+
   const char *extensions[] = {
       VK_KHR_SWAPCHAIN_EXTENSION_NAME,
   };
 
-  const float queue_priorities[] = {1};
-
-  VkDeviceQueueCreateInfo queue_create_info = {};
-  queue_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-  queue_create_info.queueFamilyIndex = graphics_queue_famil_index;
-  queue_create_info.queueCount = 1;
-  queue_create_info.pQueuePriorities = queue_priorities;
+  // every queue counts its submissions on a timeline semaphore
+  VkPhysicalDeviceTimelineSemaphoreFeatures timeline_semaphore_features = {};
+  timeline_semaphore_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+  timeline_semaphore_features.timelineSemaphore = VK_TRUE;
 
   VkDeviceCreateInfo device_create_info = {};
   device_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+  device_create_info.pNext = &timeline_semaphore_features;
   device_create_info.enabledExtensionCount = std::size(extensions);
   device_create_info.ppEnabledExtensionNames = extensions;
-  device_create_info.queueCreateInfoCount = 1;
-  device_create_info.pQueueCreateInfos = &queue_create_info;
+  device_create_info.queueCreateInfoCount = queue_create_infos.size();
+  device_create_info.pQueueCreateInfos = queue_create_infos.data();
 
   VkDevice logic_device = VK_NULL_HANDLE;
   VkResult ret_code =
@@ -138,8 +194,14 @@ absl::StatusOr<core::RefCountPtr<Device>> Instance::create_device_for_graphics()
         absl::StrFormat("failed to create logic device, ret_code: %s", VkResult_name(ret_code)));
   }
 
-  return core::make_refcounted<Device>(this, target_device, logic_device,
-                                       absl::MakeConstSpan(&graphics_queue_famil_index, 1));
+  auto device = core::make_refcounted<Device>(this, target_device, logic_device, queue_families);
+  if (!pipeline_cache_path.empty()) {
+    // a missing or stale file only means pipelines are compiled from scratch this run
+    LANCE_ASSIGN_OR_RETURN(loaded, device->pipeline_cache()->load(pipeline_cache_path));
+    VLOG(1) << "pipeline cache " << pipeline_cache_path << (loaded ? " loaded" : " not loaded");
+  }
+
+  return device;
 }
 
 Surface::~Surface() {
@@ -148,20 +210,258 @@ Surface::~Surface() {
   }
 }
 
+Queue::Queue(Device *device, QueueKind kind, uint32_t family_index, uint32_t index)
+    : device_(device), kind_(kind), family_index_(family_index), index_(index) {
+  VkApi::get()->vkGetDeviceQueue(device_->vk_device(), family_index_, index_, &vk_queue_);
+
+  VkSemaphoreTypeCreateInfo semaphore_type_create_info = {};
+  semaphore_type_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+  semaphore_type_create_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+  semaphore_type_create_info.initialValue = 0;
+
+  VkSemaphoreCreateInfo semaphore_create_info = {};
+  semaphore_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+  semaphore_create_info.pNext = &semaphore_type_create_info;
+  const VkResult ret_code = VkApi::get()->vkCreateSemaphore(
+      device_->vk_device(), &semaphore_create_info, nullptr, &vk_timeline_semaphore_);
+  CHECK_EQ(VK_SUCCESS, ret_code) << "failed to create timeline semaphore, ret_code: "
+                                 << VkResult_name(ret_code);
+}
+
+Queue::~Queue() {
+  // Device::~Device ran the callbacks
+  CHECK(callbacks_.empty());
+
+  VkApi::get()->vkDestroySemaphore(device_->vk_device(), vk_timeline_semaphore_, nullptr);
+}
+
+uint64_t Queue::last_submitted() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  return submitted_;
+}
+
+absl::StatusOr<uint64_t> Queue::update() {
+  uint64_t value = 0;
+  VK_RETURN_IF_FAILED(VkApi::get()->vkGetSemaphoreCounterValue(device_->vk_device(),
+                                                               vk_timeline_semaphore_, &value));
+
+  uint64_t completed = completed_.load(std::memory_order_relaxed);
+  while (completed < value &&
+         !completed_.compare_exchange_weak(completed, value, std::memory_order_relaxed)) {
+  }
+
+  // run the callbacks without the lock, they may submit
+  core::SmallVector<std::function<void()>, 4> callbacks;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto end = callbacks_.upper_bound(value);
+    for (auto it = callbacks_.begin(); it != end; ++it) {
+      callbacks.push_back(std::move(it->second));
+    }
+    callbacks_.erase(callbacks_.begin(), end);
+  }
+  for (auto &callback : callbacks) {
+    callback();
+  }
+
+  return value;
+}
+
+absl::StatusOr<SubmitToken> Queue::submit(const SubmitInfo &info) {
+  LANCE_PROFILE_ZONE("Queue::submit");
+
+  core::SmallVector<VkSemaphore, 4> wait_semaphores;
+  core::SmallVector<uint64_t, 4> wait_values;
+  core::SmallVector<VkPipelineStageFlags, 4> wait_stages;
+  for (const auto &semaphore : info.wait_semaphores) {
+    wait_semaphores.push_back(semaphore.vk_semaphore);
+    wait_values.push_back(semaphore.value);
+    wait_stages.push_back(semaphore.stage_mask);
+  }
+
+  // the queue's timeline is signaled last
+  core::SmallVector<VkSemaphore, 4> signal_semaphores;
+  core::SmallVector<uint64_t, 4> signal_values;
+  for (const auto &semaphore : info.signal_semaphores) {
+    signal_semaphores.push_back(semaphore.vk_semaphore);
+    signal_values.push_back(semaphore.value);
+  }
+  signal_semaphores.push_back(vk_timeline_semaphore_);
+  signal_values.push_back(0);
+
+  VkTimelineSemaphoreSubmitInfo timeline_submit_info = {};
+  timeline_submit_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+  timeline_submit_info.waitSemaphoreValueCount = wait_values.size();
+  timeline_submit_info.pWaitSemaphoreValues = wait_values.data();
+  timeline_submit_info.signalSemaphoreValueCount = signal_values.size();
+  timeline_submit_info.pSignalSemaphoreValues = signal_values.data();
+
+  VkSubmitInfo submit_info = {};
+  submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submit_info.pNext = &timeline_submit_info;
+  submit_info.waitSemaphoreCount = wait_semaphores.size();
+  submit_info.pWaitSemaphores = wait_semaphores.data();
+  submit_info.pWaitDstStageMask = wait_stages.data();
+  submit_info.commandBufferCount = info.command_buffers.size();
+  submit_info.pCommandBuffers = info.command_buffers.data();
+  submit_info.signalSemaphoreCount = signal_semaphores.size();
+  submit_info.pSignalSemaphores = signal_semaphores.data();
+
+  SubmitToken token;
+  token.queue_family_index = family_index_;
+  token.queue_index = index_;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    token.value = submitted_ + 1;
+    signal_values.back() = token.value;
+    VK_RETURN_IF_FAILED(VkApi::get()->vkQueueSubmit(vk_queue_, 1, &submit_info, VK_NULL_HANDLE));
+    submitted_ = token.value;
+  }
+
+  LANCE_RETURN_IF_FAILED(update().status());
+
+  return token;
+}
+
+absl::StatusOr<bool> Queue::is_complete(uint64_t value) {
+  if (value <= completed_.load(std::memory_order_relaxed)) {
+    return true;
+  }
+
+  LANCE_ASSIGN_OR_RETURN(completed, update());
+  return value <= completed;
+}
+
+absl::Status Queue::wait(uint64_t value, uint64_t timeout_ns) {
+  LANCE_ASSIGN_OR_RETURN(complete, is_complete(value));
+  if (complete) {
+    return absl::OkStatus();
+  }
+
+  LANCE_PROFILE_ZONE("Queue::wait");
+
+  VkSemaphoreWaitInfo wait_info = {};
+  wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+  wait_info.semaphoreCount = 1;
+  wait_info.pSemaphores = &vk_timeline_semaphore_;
+  wait_info.pValues = &value;
+  const VkResult ret_code =
+      VkApi::get()->vkWaitSemaphores(device_->vk_device(), &wait_info, timeout_ns);
+  if (ret_code == VK_TIMEOUT) {
+    return absl::DeadlineExceededError(
+        absl::StrFormat("submission %d on queue %d of family %d did not complete in %dns", value,
+                        index_, family_index_, timeout_ns));
+  }
+  VK_RETURN_IF_FAILED(ret_code);
+
+  return update().status();
+}
+
+absl::Status Queue::on_complete(uint64_t value, std::function<void()> callback) {
+  LANCE_ASSIGN_OR_RETURN(complete, is_complete(value));
+  if (!complete) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // update() stores `completed_` before it collects callbacks under the lock, checking again
+    // here never strands one
+    if (value > completed_.load(std::memory_order_relaxed)) {
+      callbacks_.emplace(value, std::move(callback));
+      return absl::OkStatus();
+    }
+  }
+
+  callback();
+  return absl::OkStatus();
+}
+
+absl::Status Queue::poll() { return update().status(); }
+
+void Queue::run_callbacks() {
+  // callbacks may add callbacks
+  while (true) {
+    std::multimap<uint64_t, std::function<void()>> callbacks;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      callbacks.swap(callbacks_);
+    }
+    if (callbacks.empty()) {
+      return;
+    }
+
+    for (auto &[value, callback] : callbacks) {
+      callback();
+    }
+  }
+}
+
 Device::Device(core::RefCountPtr<Instance> instance, VkPhysicalDevice vk_physical_device,
-               VkDevice vk_device, absl::Span<const uint32_t> queue_family_indices)
+               VkDevice vk_device, absl::Span<const DeviceQueueFamily> queue_families)
     : instance_(instance),
       vk_physical_device_(vk_physical_device),
       vk_device_(vk_device),
-      queue_family_indices_(queue_family_indices.begin(), queue_family_indices.end()) {
+      memory_allocator_(std::make_unique<MemoryAllocator>(this, vk_physical_device)),
+      pipeline_cache_(std::make_unique<PipelineCache>(this, vk_physical_device)) {
+  CHECK(!queue_families.empty());
+
+  for (const auto &queue_family : queue_families) {
+    queue_family_indices_.push_back(queue_family.family_index);
+
+    for (uint32_t i = 0; i < queue_family.queue_count; ++i) {
+      queues_.push_back(
+          std::make_unique<Queue>(this, queue_family.kind, queue_family.family_index, i));
+      queues_by_kind_[static_cast<int>(queue_family.kind)].push_back(queues_.back().get());
+    }
+  }
+
+  // async compute falls back to graphics queues, transfer to async compute or graphics ones
+  auto &graphics = queues_by_kind_[static_cast<int>(QueueKind::kGraphics)];
+  auto &compute = queues_by_kind_[static_cast<int>(QueueKind::kAsyncCompute)];
+  auto &transfer = queues_by_kind_[static_cast<int>(QueueKind::kTransfer)];
+  if (graphics.empty()) {
+    graphics.push_back(queues_.front().get());
+  }
+  if (compute.empty()) {
+    compute = graphics;
+  }
+  if (transfer.empty()) {
+    transfer = compute;
+  }
+
   VkPhysicalDeviceProperties properties;
   VkApi::get()->vkGetPhysicalDeviceProperties(vk_physical_device, &properties);
 
-  LOG(INFO) << "queue_family_indices: [" << absl::StrJoin(queue_family_indices, ",")
-            << "], device_name: " << properties.deviceName;
+  LOG(INFO) << "queue_family_indices: [" << absl::StrJoin(queue_family_indices_, ",")
+            << "], queues: " << queues_.size() << ", device_name: " << properties.deviceName;
 }
 
 Device::~Device() {
+  if (vk_device_) {
+    VkApi::get()->vkDeviceWaitIdle(vk_device_);
+  }
+
+  // nothing is in flight anymore. the callbacks run while every queue is alive, since they may
+  // submit or defer destruction.
+  for (auto &queue : queues_) {
+    queue->run_callbacks();
+  }
+
+  // the deferred objects hold no references to the device, so this drains everything. destroying
+  // one may defer another.
+  while (!deferred_.empty()) {
+    auto destroy = std::move(deferred_.front().destroy);
+    deferred_.pop_front();
+    destroy();
+  }
+
+  queues_.clear();
+
+  // frees its memory blocks
+  memory_allocator_.reset();
+
+  // saves it if it was loaded from a file
+  pipeline_cache_.reset();
+
   if (vk_device_) {
     VkApi::get()->vkDestroyDevice(vk_device_, nullptr);
   }
@@ -213,29 +513,146 @@ absl::StatusOr<uint32_t> Device::find_queue_family_index(VkQueueFlags flags) con
 
 absl::Status Device::submit(uint32_t queue_family_index,
                             absl::Span<const VkCommandBuffer> vk_command_buffers) {
-  VkFenceCreateInfo fence_create_info = {};
-  fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+  LANCE_PROFILE_ZONE("Device::submit");
 
-  VkFence vk_fence{VK_NULL_HANDLE};
-  VK_RETURN_IF_FAILED(
-      VkApi::get()->vkCreateFence(vk_device_, &fence_create_info, nullptr, &vk_fence));
+  SubmitInfo info;
+  info.command_buffers = vk_command_buffers;
+  LANCE_ASSIGN_OR_RETURN(token, submit_async(queue_family_index, info));
 
-  LANCE_ON_SCOPE_EXIT([&]() { VkApi::get()->vkDestroyFence(vk_device_, vk_fence, nullptr); });
+  return wait(token);
+}
 
-  VkQueue vk_queue{VK_NULL_HANDLE};
-  VkApi::get()->vkGetDeviceQueue(vk_device_, queue_family_index, 0, &vk_queue);
+Queue *Device::queue(QueueKind kind, uint32_t index) const {
+  const auto &queues = queues_by_kind_[static_cast<int>(kind)];
 
-  VkSubmitInfo submit_info = {};
-  submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-  submit_info.commandBufferCount = vk_command_buffers.size();
-  submit_info.pCommandBuffers = vk_command_buffers.data();
-  VK_RETURN_IF_FAILED(VkApi::get()->vkQueueSubmit(vk_queue, 1, &submit_info, vk_fence));
+  return queues[index % queues.size()];
+}
+
+absl::StatusOr<Queue *> Device::find_queue(uint32_t queue_family_index, uint32_t index) const {
+  for (const auto &queue : queues_) {
+    if (queue->family_index() == queue_family_index && queue->index() == index) {
+      return queue.get();
+    }
+  }
+
+  return absl::NotFoundError(absl::StrFormat("no queue %d of family %d on the device", index,
+                                             queue_family_index));
+}
+
+absl::StatusOr<SubmitToken> Device::submit_async(uint32_t queue_family_index,
+                                                 const SubmitInfo &info) {
+  LANCE_ASSIGN_OR_RETURN(queue, find_queue(queue_family_index));
+
+  return queue->submit(info);
+}
+
+absl::StatusOr<bool> Device::is_complete(SubmitToken token) {
+  if (token.value == 0) {
+    return true;
+  }
+
+  LANCE_ASSIGN_OR_RETURN(queue, find_queue(token.queue_family_index, token.queue_index));
+  return queue->is_complete(token.value);
+}
+
+absl::Status Device::wait(SubmitToken token, uint64_t timeout_ns) {
+  if (token.value == 0) {
+    return absl::OkStatus();
+  }
+
+  LANCE_ASSIGN_OR_RETURN(queue, find_queue(token.queue_family_index, token.queue_index));
+  return queue->wait(token.value, timeout_ns);
+}
+
+absl::Status Device::wait_idle() {
+  for (auto &queue : queues_) {
+    LANCE_RETURN_IF_FAILED(queue->wait(queue->last_submitted()));
+  }
+
+  collect_deferred();
+  return absl::OkStatus();
+}
 
-  VK_RETURN_IF_FAILED(VkApi::get()->vkWaitForFences(vk_device_, 1, &vk_fence, VK_TRUE, UINT64_MAX));
+absl::Status Device::on_complete(SubmitToken token, std::function<void()> callback) {
+  if (token.value == 0) {
+    callback();
+    return absl::OkStatus();
+  }
+
+  LANCE_ASSIGN_OR_RETURN(queue, find_queue(token.queue_family_index, token.queue_index));
+  return queue->on_complete(token.value, std::move(callback));
+}
 
+absl::Status Device::poll() {
+  for (auto &queue : queues_) {
+    LANCE_RETURN_IF_FAILED(queue->poll());
+  }
+
+  collect_deferred();
   return absl::OkStatus();
 }
 
+void Device::destroy_deferred(std::function<void()> destroy) {
+  DeferredDestruction deferred;
+  bool complete = true;
+  for (const auto &queue : queues_) {
+    const uint64_t submitted = queue->last_submitted();
+    deferred.submitted.push_back(submitted);
+    complete = complete && submitted <= queue->completed();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(deferred_mutex_);
+    // objects deferred before, e.g. a command buffer ahead of its pool, go first
+    if (!complete || !deferred_.empty()) {
+      deferred.destroy = std::move(destroy);
+      deferred_.push_back(std::move(deferred));
+      return;
+    }
+  }
+
+  destroy();
+}
+
+void Device::collect_deferred() {
+  // destroying may release objects that defer again, run it without the lock
+  core::SmallVector<std::function<void()>, 8> destroys;
+  {
+    std::lock_guard<std::mutex> lock(deferred_mutex_);
+    while (!deferred_.empty()) {
+      const auto &submitted = deferred_.front().submitted;
+      bool complete = true;
+      for (size_t i = 0; i < submitted.size(); ++i) {
+        complete = complete && submitted[i] <= queues_[i]->completed();
+      }
+      if (!complete) {
+        break;
+      }
+
+      destroys.push_back(std::move(deferred_.front().destroy));
+      deferred_.pop_front();
+    }
+  }
+
+  if (!destroys.empty()) {
+    VLOG(2) << "deferred destructions: " << destroys.size();
+  }
+  for (auto &destroy : destroys) {
+    destroy();
+  }
+}
+
+absl::StatusOr<SemaphoreSubmit> Device::wait_semaphore(SubmitToken token,
+                                                       VkPipelineStageFlags stage_mask) const {
+  LANCE_ASSIGN_OR_RETURN(queue, find_queue(token.queue_family_index, token.queue_index));
+
+  SemaphoreSubmit semaphore;
+  semaphore.vk_semaphore = queue->vk_timeline_semaphore();
+  semaphore.value = token.value;
+  semaphore.stage_mask = stage_mask;
+  return semaphore;
+}
+
 absl::StatusOr<uint32_t> Device::find_memory_type_index(uint32_t type_bits,
                                                         VkMemoryPropertyFlags flags) const {
   VkPhysicalDeviceMemoryProperties memory_properties;
@@ -252,14 +669,28 @@ absl::StatusOr<uint32_t> Device::find_memory_type_index(uint32_t type_bits,
 }
 
 absl::StatusOr<core::RefCountPtr<Buffer>> Device::create_buffer(
-    VkBufferUsageFlags usage, size_t size, VkMemoryPropertyFlags memory_property_flags) {
+    VkBufferUsageFlags usage, size_t size, VkMemoryPropertyFlags memory_property_flags,
+    absl::Span<const uint32_t> queue_family_indices) {
   VkBuffer vk_buffer{VK_NULL_HANDLE};
 
+  core::SmallVector<uint32_t, 4> distinct_queue_family_indices;
+  for (uint32_t queue_family_index : queue_family_indices) {
+    if (std::find(distinct_queue_family_indices.begin(), distinct_queue_family_indices.end(),
+                  queue_family_index) == distinct_queue_family_indices.end()) {
+      distinct_queue_family_indices.push_back(queue_family_index);
+    }
+  }
+
   VkBufferCreateInfo buffer_create_info = {};
   buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
   buffer_create_info.size = size;
   buffer_create_info.usage = usage;
   buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  if (distinct_queue_family_indices.size() > 1) {
+    buffer_create_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+    buffer_create_info.queueFamilyIndexCount = distinct_queue_family_indices.size();
+    buffer_create_info.pQueueFamilyIndices = distinct_queue_family_indices.data();
+  }
   VK_RETURN_IF_FAILED(
       VkApi::get()->vkCreateBuffer(vk_device_, &buffer_create_info, nullptr, &vk_buffer));
 
@@ -272,57 +703,143 @@ absl::StatusOr<core::RefCountPtr<Buffer>> Device::create_buffer(
   VkMemoryRequirements mem_req;
   VkApi::get()->vkGetBufferMemoryRequirements(vk_device_, vk_buffer, &mem_req);
 
-  LANCE_ASSIGN_OR_RETURN(memory_type_index,
-                         find_memory_type_index(mem_req.memoryTypeBits, memory_property_flags));
+  LANCE_ASSIGN_OR_RETURN(memory, memory_allocator_->allocate(mem_req, memory_property_flags,
+                                                            ResourceTiling::kLinear));
 
-  VkDeviceMemory vk_device_memory{VK_NULL_HANDLE};
-  VkMemoryAllocateInfo memory_allocate_info = {};
-  memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  memory_allocate_info.allocationSize = mem_req.size;
-  memory_allocate_info.memoryTypeIndex = memory_type_index;
-  VK_RETURN_IF_FAILED(VkApi::get()->vkAllocateMemory(vk_device_, &memory_allocate_info, nullptr,
-                                                     &vk_device_memory));
+  VK_RETURN_IF_FAILED(VkApi::get()->vkBindBufferMemory(
+      vk_device_, vk_buffer, memory->vk_device_memory(), memory->offset()));
 
-  LANCE_ON_SCOPE_EXIT([&]() {
-    if (vk_device_memory) {
-      VkApi::get()->vkFreeMemory(vk_device_, vk_device_memory, nullptr);
-    }
-  });
-
-  VK_RETURN_IF_FAILED(VkApi::get()->vkBindBufferMemory(vk_device_, vk_buffer, vk_device_memory, 0));
-
-  class BufferOwnMemory : public Buffer {
+  class AllocatedBuffer : public Buffer {
    public:
-    BufferOwnMemory(core::RefCountPtr<Device> device, VkBuffer vk_buffer,
-                    VkDeviceMemory device_memory)
-        : device_(device), vk_buffer_(vk_buffer), vk_device_memory_(device_memory) {}
+    AllocatedBuffer(core::RefCountPtr<Device> device, VkBuffer vk_buffer,
+                    core::RefCountPtr<MemoryAllocation> memory)
+        : device_(device), vk_buffer_(vk_buffer), memory_(memory) {}
 
-    ~BufferOwnMemory() {
+    ~AllocatedBuffer() {
       if (vk_buffer_) {
-        VkApi::get()->vkDestroyBuffer(device_->vk_device(), vk_buffer_, nullptr);
-      }
-      if (vk_device_memory_) {
-        VkApi::get()->vkFreeMemory(device_->vk_device(), vk_device_memory_, nullptr);
+        // the memory is released after the buffer is destroyed
+        device_->destroy_deferred(
+            [vk_device = device_->vk_device(), vk_buffer = vk_buffer_,
+             memory = MemoryAllocation::detach(std::move(memory_))]() {
+              VkApi::get()->vkDestroyBuffer(vk_device, vk_buffer, nullptr);
+              memory.free();
+            });
       }
     }
 
     Device *device() const override { return device_.get(); }
     VkBuffer vk_buffer() const override { return vk_buffer_; }
+    MemoryAllocation *memory() const override { return memory_.get(); }
 
    private:
     core::RefCountPtr<Device> device_;
     VkBuffer vk_buffer_{VK_NULL_HANDLE};
-    VkDeviceMemory vk_device_memory_{VK_NULL_HANDLE};
+    // released after the buffer is destroyed
+    core::RefCountPtr<MemoryAllocation> memory_;
   };
 
-  auto result = core::make_refcounted<BufferOwnMemory>(this, vk_buffer, vk_device_memory);
+  auto result = core::make_refcounted<AllocatedBuffer>(this, vk_buffer, memory);
 
   vk_buffer = VK_NULL_HANDLE;
-  vk_device_memory = VK_NULL_HANDLE;
 
   return result;
 }
 
+namespace {
+VkBufferMemoryBarrier make_buffer_barrier(VkBuffer vk_buffer, const OwnershipTransfer &transfer) {
+  VkBufferMemoryBarrier barrier = {};
+  barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+  barrier.srcAccessMask = transfer.src_access_mask;
+  barrier.dstAccessMask = transfer.dst_access_mask;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  if (transfer.src_queue_family_index != transfer.dst_queue_family_index) {
+    barrier.srcQueueFamilyIndex = transfer.src_queue_family_index;
+    barrier.dstQueueFamilyIndex = transfer.dst_queue_family_index;
+  }
+  barrier.buffer = vk_buffer;
+  barrier.offset = 0;
+  barrier.size = VK_WHOLE_SIZE;
+  return barrier;
+}
+
+VkImageMemoryBarrier make_image_barrier(VkImage vk_image, const VkImageSubresourceRange &range,
+                                        VkImageLayout old_layout, VkImageLayout new_layout,
+                                        const OwnershipTransfer &transfer) {
+  VkImageMemoryBarrier barrier = {};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.srcAccessMask = transfer.src_access_mask;
+  barrier.dstAccessMask = transfer.dst_access_mask;
+  barrier.oldLayout = old_layout;
+  barrier.newLayout = new_layout;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  if (transfer.src_queue_family_index != transfer.dst_queue_family_index) {
+    barrier.srcQueueFamilyIndex = transfer.src_queue_family_index;
+    barrier.dstQueueFamilyIndex = transfer.dst_queue_family_index;
+  }
+  barrier.image = vk_image;
+  barrier.subresourceRange = range;
+  return barrier;
+}
+}  // namespace
+
+void record_release(VkCommandBuffer vk_command_buffer, VkBuffer vk_buffer,
+                    const OwnershipTransfer &transfer) {
+  if (transfer.src_queue_family_index == transfer.dst_queue_family_index) {
+    return;
+  }
+
+  // the destination half of a release is ignored
+  VkBufferMemoryBarrier barrier = make_buffer_barrier(vk_buffer, transfer);
+  barrier.dstAccessMask = 0;
+  VkApi::get()->vkCmdPipelineBarrier(vk_command_buffer, transfer.src_stage_mask,
+                                     VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1,
+                                     &barrier, 0, nullptr);
+}
+
+void record_acquire(VkCommandBuffer vk_command_buffer, VkBuffer vk_buffer,
+                    const OwnershipTransfer &transfer) {
+  VkBufferMemoryBarrier barrier = make_buffer_barrier(vk_buffer, transfer);
+  VkPipelineStageFlags src_stage_mask = transfer.src_stage_mask;
+  if (transfer.src_queue_family_index != transfer.dst_queue_family_index) {
+    // the semaphore wait orders the acquire after the release
+    barrier.srcAccessMask = 0;
+    src_stage_mask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+  }
+  VkApi::get()->vkCmdPipelineBarrier(vk_command_buffer, src_stage_mask, transfer.dst_stage_mask,
+                                     0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
+void record_release(VkCommandBuffer vk_command_buffer, VkImage vk_image,
+                    const VkImageSubresourceRange &range, VkImageLayout old_layout,
+                    VkImageLayout new_layout, const OwnershipTransfer &transfer) {
+  if (transfer.src_queue_family_index == transfer.dst_queue_family_index) {
+    return;
+  }
+
+  VkImageMemoryBarrier barrier =
+      make_image_barrier(vk_image, range, old_layout, new_layout, transfer);
+  barrier.dstAccessMask = 0;
+  VkApi::get()->vkCmdPipelineBarrier(vk_command_buffer, transfer.src_stage_mask,
+                                     VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0,
+                                     nullptr, 1, &barrier);
+}
+
+void record_acquire(VkCommandBuffer vk_command_buffer, VkImage vk_image,
+                    const VkImageSubresourceRange &range, VkImageLayout old_layout,
+                    VkImageLayout new_layout, const OwnershipTransfer &transfer) {
+  VkImageMemoryBarrier barrier =
+      make_image_barrier(vk_image, range, old_layout, new_layout, transfer);
+  VkPipelineStageFlags src_stage_mask = transfer.src_stage_mask;
+  if (transfer.src_queue_family_index != transfer.dst_queue_family_index) {
+    barrier.srcAccessMask = 0;
+    src_stage_mask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+  }
+  VkApi::get()->vkCmdPipelineBarrier(vk_command_buffer, src_stage_mask, transfer.dst_stage_mask,
+                                     0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
 absl::StatusOr<core::RefCountPtr<DeviceMemory>> DeviceMemory::create(
     const core::RefCountPtr<Device> &device, uint32_t memory_type_index, size_t allocation_size) {
   VkDeviceMemory vk_device_memory{VK_NULL_HANDLE};
@@ -339,7 +856,10 @@ absl::StatusOr<core::RefCountPtr<DeviceMemory>> DeviceMemory::create(
 
 DeviceMemory::~DeviceMemory() {
   if (vk_device_memory_) {
-    VkApi::get()->vkFreeMemory(device_->vk_device(), vk_device_memory_, nullptr);
+    device_->destroy_deferred(
+        [vk_device = device_->vk_device(), vk_device_memory = vk_device_memory_]() {
+          VkApi::get()->vkFreeMemory(vk_device, vk_device_memory, nullptr);
+        });
   }
 }
 
@@ -375,11 +895,14 @@ VkMemoryRequirements Image::memory_requirements() const {
 
 ImageView::~ImageView() {
   if (vk_image_view_) {
-    VkApi::get()->vkDestroyImageView(device_->vk_device(), vk_image_view_, nullptr);
+    device_->destroy_deferred([vk_device = device_->vk_device(), vk_image_view = vk_image_view_]() {
+      VkApi::get()->vkDestroyImageView(vk_device, vk_image_view, nullptr);
+    });
   }
 }
 
 ShaderModule::~ShaderModule() {
+  // pipelines do not use their shader modules after creation, no need to defer
   if (vk_shader_module_) {
     VkApi::get()->vkDestroyShaderModule(device_->vk_device(), vk_shader_module_, nullptr);
   }
@@ -412,20 +935,27 @@ absl::StatusOr<core::Ref<DescriptorSetLayout>> DescriptorSetLayout::create_for_s
 
 DescriptorSetLayout::~DescriptorSetLayout() {
   if (vk_descriptor_set_layout_) {
-    VkApi::get()->vkDestroyDescriptorSetLayout(device_->vk_device(), vk_descriptor_set_layout_,
-                                               nullptr);
+    device_->destroy_deferred([vk_device = device_->vk_device(),
+                               vk_descriptor_set_layout = vk_descriptor_set_layout_]() {
+      VkApi::get()->vkDestroyDescriptorSetLayout(vk_device, vk_descriptor_set_layout, nullptr);
+    });
   }
 }
 
 PipelineLayout::~PipelineLayout() {
   if (vk_pipeline_layout_) {
-    VkApi::get()->vkDestroyPipelineLayout(device_->vk_device(), vk_pipeline_layout_, nullptr);
+    device_->destroy_deferred(
+        [vk_device = device_->vk_device(), vk_pipeline_layout = vk_pipeline_layout_]() {
+          VkApi::get()->vkDestroyPipelineLayout(vk_device, vk_pipeline_layout, nullptr);
+        });
   }
 }
 
 Pipeline::~Pipeline() {
   if (vk_pipeline_) {
-    VkApi::get()->vkDestroyPipeline(device_->vk_device(), vk_pipeline_, nullptr);
+    device_->destroy_deferred([vk_device = device_->vk_device(), vk_pipeline = vk_pipeline_]() {
+      VkApi::get()->vkDestroyPipeline(vk_device, vk_pipeline, nullptr);
+    });
   }
 }
 
@@ -439,12 +969,15 @@ absl::StatusOr<core::RefCountPtr<CommandPool>> CommandPool::create(
   VK_RETURN_IF_FAILED(VkApi::get()->vkCreateCommandPool(
       device->vk_device(), &command_pool_create_info, nullptr, &vk_command_pool));
 
-  return core::make_refcounted<CommandPool>(device, vk_command_pool);
+  return core::make_refcounted<CommandPool>(device, vk_command_pool, queue_family_index);
 }
 
 CommandPool::~CommandPool() {
   if (vk_command_pool_) {
-    VkApi::get()->vkDestroyCommandPool(device_->vk_device(), vk_command_pool_, nullptr);
+    device_->destroy_deferred(
+        [vk_device = device_->vk_device(), vk_command_pool = vk_command_pool_]() {
+          VkApi::get()->vkDestroyCommandPool(vk_device, vk_command_pool, nullptr);
+        });
   }
 }
 
@@ -463,16 +996,35 @@ absl::StatusOr<core::RefCountPtr<CommandBuffer>> CommandPool::allocate_command_b
   return core::make_refcounted<CommandBuffer>(this, vk_command_buffer);
 }
 
+absl::Status CommandPool::reset() {
+  VK_RETURN_IF_FAILED(VkApi::get()->vkResetCommandPool(device_->vk_device(), vk_command_pool_, 0));
+
+  return absl::OkStatus();
+}
+
 CommandBuffer::~CommandBuffer() {
   if (vk_command_buffer_) {
-    VkApi::get()->vkFreeCommandBuffers(command_pool_->device()->vk_device(),
-                                       command_pool_->vk_command_pool(), 1, &vk_command_buffer_);
+    // the pool defers its destruction behind the command buffer. the temporary resources
+    // referenced by its last recording defer their own destruction once released.
+    command_pool_->device()->destroy_deferred(
+        [vk_device = command_pool_->device()->vk_device(),
+         vk_command_pool = command_pool_->vk_command_pool(),
+         vk_command_buffer = vk_command_buffer_]() {
+          VkApi::get()->vkFreeCommandBuffers(vk_device, vk_command_pool, 1, &vk_command_buffer);
+        });
   }
 }
 
-absl::Status CommandBuffer::begin() {
+absl::Status CommandBuffer::begin(VkCommandBufferUsageFlags flags,
+                                  const VkCommandBufferInheritanceInfo *inheritance_info) {
+  // the pool was reset since the previous recording, or vulkan rejects beginning again. so that
+  // recording finished executing. clear() keeps the capacity for the next recording.
+  temporary_resources_.clear();
+
   VkCommandBufferBeginInfo command_buffer_begin_info = {};
   command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  command_buffer_begin_info.flags = flags;
+  command_buffer_begin_info.pInheritanceInfo = inheritance_info;
   VK_RETURN_IF_FAILED(
       VkApi::get()->vkBeginCommandBuffer(vk_command_buffer_, &command_buffer_begin_info));
 
@@ -486,26 +1038,35 @@ absl::Status CommandBuffer::end() {
 }
 
 absl::Status CommandBuffer::add_temporary_resource(core::RefCountPtr<core::Object> resource) {
-  temporary_resources_.push_back(resource);
+  temporary_resources_.push_back(std::move(resource));
 
   return absl::OkStatus();
 }
 
 Framebuffer::~Framebuffer() {
   if (vk_framebuffer_) {
-    VkApi::get()->vkDestroyFramebuffer(device_->vk_device(), vk_framebuffer_, nullptr);
+    device_->destroy_deferred(
+        [vk_device = device_->vk_device(), vk_framebuffer = vk_framebuffer_]() {
+          VkApi::get()->vkDestroyFramebuffer(vk_device, vk_framebuffer, nullptr);
+        });
   }
 }
 
 RenderPass::~RenderPass() {
   if (vk_render_pass_) {
-    VkApi::get()->vkDestroyRenderPass(device_->vk_device(), vk_render_pass_, nullptr);
+    device_->destroy_deferred(
+        [vk_device = device_->vk_device(), vk_render_pass = vk_render_pass_]() {
+          VkApi::get()->vkDestroyRenderPass(vk_device, vk_render_pass, nullptr);
+        });
   }
 }
 
 DescriptorPool::~DescriptorPool() {
   if (vk_descriptor_pool_) {
-    VkApi::get()->vkDestroyDescriptorPool(device_->vk_device(), vk_descriptor_pool_, nullptr);
+    device_->destroy_deferred(
+        [vk_device = device_->vk_device(), vk_descriptor_pool = vk_descriptor_pool_]() {
+          VkApi::get()->vkDestroyDescriptorPool(vk_device, vk_descriptor_pool, nullptr);
+        });
   }
 }
 
@@ -529,8 +1090,13 @@ absl::StatusOr<core::RefCountPtr<DescriptorSet>> DescriptorPool::allocate_descri
 
     ~DescriptorSetImpl() override {
       if (vk_descriptor_set_) {
-        VkApi::get()->vkFreeDescriptorSets(pool_->device()->vk_device(),
-                                           pool_->vk_descriptor_pool(), 1, &vk_descriptor_set_);
+        pool_->device()->destroy_deferred(
+            [vk_device = pool_->device()->vk_device(),
+             vk_descriptor_pool = pool_->vk_descriptor_pool(),
+             vk_descriptor_set = vk_descriptor_set_]() {
+              VkApi::get()->vkFreeDescriptorSets(vk_device, vk_descriptor_pool, 1,
+                                                 &vk_descriptor_set);
+            });
       }
     }
 
@@ -1,8 +1,17 @@
 #pragma once
 
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string_view>
+
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
 #include "lance/core/object.h"
+#include "lance/core/small_containers.h"
 #include "lance/core/util.h"
 #include "vulkan/vulkan_core.h"
 
@@ -13,6 +22,9 @@ class ShaderModule;
 class CommandBuffer;
 class Buffer;
 class DescriptorSet;
+class MemoryAllocation;
+class MemoryAllocator;
+class PipelineCache;
 
 class Instance : public core::Inherit<Instance, core::Object> {
  public:
@@ -33,7 +45,10 @@ class Instance : public core::Inherit<Instance, core::Object> {
 
   absl::StatusOr<core::RefCountPtr<Device>> create_device(absl::Span<const char*> extensions);
 
-  absl::StatusOr<core::RefCountPtr<Device>> create_device_for_graphics();
+  // seeds the device's pipeline cache from `pipeline_cache_path` if one is given, and the cache
+  // is saved back there when the device is destroyed
+  absl::StatusOr<core::RefCountPtr<Device>> create_device_for_graphics(
+      std::string_view pipeline_cache_path = {});
 
  private:
   VkInstance vk_instance_{VK_NULL_HANDLE};
@@ -53,38 +68,242 @@ class Surface : public core::Inherit<Surface, core::Object> {
   VkSurfaceKHR vk_surface_{VK_NULL_HANDLE};
 };
 
+// a semaphore a submission waits on or signals
+struct SemaphoreSubmit {
+  VkSemaphore vk_semaphore = VK_NULL_HANDLE;
+
+  // timeline semaphores only, ignored for binary ones
+  uint64_t value = 0;
+
+  // waits only, the stages that wait for the semaphore
+  VkPipelineStageFlags stage_mask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+};
+
+struct SubmitInfo {
+  absl::Span<const VkCommandBuffer> command_buffers;
+  absl::Span<const SemaphoreSubmit> wait_semaphores;
+  absl::Span<const SemaphoreSubmit> signal_semaphores;
+};
+
+// completion of a submission: every queue counts its submissions on a timeline semaphore, which
+// reaches `value` once the submission and all before it on the queue completed. the default
+// token is complete.
+struct SubmitToken {
+  uint32_t queue_family_index = UINT32_MAX;
+  uint32_t queue_index = 0;
+  uint64_t value = 0;
+};
+
+enum class QueueKind {
+  kGraphics,
+  // compute without graphics, overlaps with rasterization
+  kAsyncCompute,
+  // transfer only, overlaps with both
+  kTransfer,
+};
+
+// queues a device is created with from one family
+struct DeviceQueueFamily {
+  uint32_t family_index;
+  uint32_t queue_count;
+  QueueKind kind;
+};
+
+// one VkQueue of a device, owned by it. thread-safe, submissions are serialized.
+class Queue {
+ public:
+  Queue(Device* device, QueueKind kind, uint32_t family_index, uint32_t index);
+
+  ~Queue();
+
+  Queue(const Queue&) = delete;
+  Queue& operator=(const Queue&) = delete;
+
+  QueueKind kind() const { return kind_; }
+
+  uint32_t family_index() const { return family_index_; }
+
+  uint32_t index() const { return index_; }
+
+  VkQueue vk_queue() const { return vk_queue_; }
+
+  // counts the submissions, other queues wait on it through Device::wait_semaphore
+  VkSemaphore vk_timeline_semaphore() const { return vk_timeline_semaphore_; }
+
+  // returns once the work is queued
+  absl::StatusOr<SubmitToken> submit(const SubmitInfo& info);
+
+  // timeline value of the last submission
+  uint64_t last_submitted() const;
+
+  // highest timeline value known to be reached, without querying the semaphore
+  uint64_t completed() const { return completed_.load(std::memory_order_relaxed); }
+
+  absl::StatusOr<bool> is_complete(uint64_t value);
+
+  // DeadlineExceeded if `value` was not reached within `timeout_ns`
+  absl::Status wait(uint64_t value, uint64_t timeout_ns = UINT64_MAX);
+
+  // runs `callback` once `value` is reached, right away if it is. callbacks run on the thread
+  // that observes the completion in submit, poll, wait or is_complete, keep them short.
+  absl::Status on_complete(uint64_t value, std::function<void()> callback);
+
+  // runs the callbacks of completed submissions
+  absl::Status poll();
+
+ private:
+  friend class Device;
+
+  // reads the timeline's counter and runs the callbacks it completed
+  absl::StatusOr<uint64_t> update();
+
+  // runs every callback left, once the device is idle
+  void run_callbacks();
+
+  Device* const device_;
+  const QueueKind kind_;
+  const uint32_t family_index_;
+  const uint32_t index_;
+  VkQueue vk_queue_{VK_NULL_HANDLE};
+  VkSemaphore vk_timeline_semaphore_{VK_NULL_HANDLE};
+
+  // highest value known to be reached, saves querying the semaphore
+  std::atomic<uint64_t> completed_{0};
+
+  // guards vk_queue_ and everything below
+  mutable std::mutex mutex_;
+  uint64_t submitted_ = 0;
+  std::multimap<uint64_t, std::function<void()>> callbacks_;
+};
+
 class Device : public core::Inherit<Device, core::Object> {
  public:
   explicit Device(core::RefCountPtr<Instance> instance, VkPhysicalDevice vk_physical_device,
-                  VkDevice vk_device, absl::Span<const uint32_t> queue_family_indices);
+                  VkDevice vk_device, absl::Span<const DeviceQueueFamily> queue_families);
 
   ~Device();
 
   VkDevice vk_device() const { return vk_device_; }
 
+  VkPhysicalDevice vk_physical_device() const { return vk_physical_device_; }
+
   absl::StatusOr<core::RefCountPtr<ShaderModule>> create_shader_module(const core::Blob* blob);
 
   absl::StatusOr<core::RefCountPtr<ShaderModule>> create_shader_from_source(
       VkShaderStageFlagBits stage, const char* source);
 
+  // graphics family first, then async compute and transfer ones
   absl::StatusOr<uint32_t> find_queue_family_index(VkQueueFlags flags) const;
 
+  // `index` wraps around the queues of the kind. without a dedicated family async compute uses
+  // graphics queues, and transfer uses async compute or graphics ones.
+  Queue* queue(QueueKind kind, uint32_t index = 0) const;
+
+  absl::StatusOr<Queue*> find_queue(uint32_t queue_family_index, uint32_t index = 0) const;
+
+  // blocks until the command buffers completed, on the first queue of the family
   absl::Status submit(uint32_t queue_family_index,
                       absl::Span<const VkCommandBuffer> vk_command_buffers);
 
+  // Queue::submit on the first queue of the family
+  absl::StatusOr<SubmitToken> submit_async(uint32_t queue_family_index, const SubmitInfo& info);
+
+  absl::StatusOr<bool> is_complete(SubmitToken token);
+
+  // DeadlineExceeded if `token` did not complete within `timeout_ns`
+  absl::Status wait(SubmitToken token, uint64_t timeout_ns = UINT64_MAX);
+
+  // waits for everything submitted so far to every queue
+  absl::Status wait_idle();
+
+  absl::Status on_complete(SubmitToken token, std::function<void()> callback);
+
+  // runs the callbacks of completed submissions on every queue, then destroys what was
+  // deferred behind them
+  absl::Status poll();
+
+  // runs `destroy` once every submission made so far, on any queue, completed. right away if
+  // they all did. wrappers release their handles through it, so that dropping an object the gpu
+  // may still use never stalls. `destroy` must capture raw handles rather than references to
+  // the device, or the device could never be released and drain it.
+  void destroy_deferred(std::function<void()> destroy);
+
+  // makes a submission, possibly on another queue, wait for `token` before `stage_mask`
+  absl::StatusOr<SemaphoreSubmit> wait_semaphore(
+      SubmitToken token,
+      VkPipelineStageFlags stage_mask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT) const;
+
   absl::StatusOr<uint32_t> find_memory_type_index(uint32_t type_bits,
                                                   VkMemoryPropertyFlags flags) const;
 
+  // sub-allocated from memory_allocator(). the buffer is shared concurrently if
+  // `queue_family_indices` names more than one family, otherwise it is exclusive and moving it
+  // to another family takes an ownership transfer.
   absl::StatusOr<core::RefCountPtr<Buffer>> create_buffer(
-      VkBufferUsageFlags usage, size_t size, VkMemoryPropertyFlags memory_property_flags);
+      VkBufferUsageFlags usage, size_t size, VkMemoryPropertyFlags memory_property_flags,
+      absl::Span<const uint32_t> queue_family_indices = {});
+
+  MemoryAllocator* memory_allocator() const { return memory_allocator_.get(); }
+
+  // pass to every pipeline creation
+  PipelineCache* pipeline_cache() const { return pipeline_cache_.get(); }
 
  private:
   core::RefCountPtr<Instance> instance_;
   VkPhysicalDevice vk_physical_device_{VK_NULL_HANDLE};
   VkDevice vk_device_{VK_NULL_HANDLE};
   std::vector<uint32_t> queue_family_indices_;
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  // indexed by QueueKind, after the fallbacks
+  std::vector<Queue*> queues_by_kind_[3];
+
+  std::unique_ptr<MemoryAllocator> memory_allocator_;
+  std::unique_ptr<PipelineCache> pipeline_cache_;
+
+  struct DeferredDestruction {
+    // Queue::last_submitted() of every queue in queues_ when it was deferred
+    core::SmallVector<uint64_t, 4> submitted;
+    std::function<void()> destroy;
+  };
+
+  // destroys the deferred objects whose submissions completed, oldest first
+  void collect_deferred();
+
+  std::mutex deferred_mutex_;
+  std::deque<DeferredDestruction> deferred_;
+};
+
+// queue family ownership transfer of an exclusive resource. the release half is recorded on the
+// source family, the acquire half with the same arguments on the destination family, in a
+// submission that waits for the release's one.
+struct OwnershipTransfer {
+  uint32_t src_queue_family_index;
+  uint32_t dst_queue_family_index;
+
+  // of the last use on the source family
+  VkPipelineStageFlags src_stage_mask;
+  VkAccessFlags src_access_mask;
+
+  // of the first use on the destination family
+  VkPipelineStageFlags dst_stage_mask;
+  VkAccessFlags dst_access_mask;
 };
 
+// a plain barrier on the acquire side when both families are the same
+void record_release(VkCommandBuffer vk_command_buffer, VkBuffer vk_buffer,
+                    const OwnershipTransfer& transfer);
+void record_acquire(VkCommandBuffer vk_command_buffer, VkBuffer vk_buffer,
+                    const OwnershipTransfer& transfer);
+
+// the layout transition happens once, between the release and the acquire
+void record_release(VkCommandBuffer vk_command_buffer, VkImage vk_image,
+                    const VkImageSubresourceRange& range, VkImageLayout old_layout,
+                    VkImageLayout new_layout, const OwnershipTransfer& transfer);
+void record_acquire(VkCommandBuffer vk_command_buffer, VkImage vk_image,
+                    const VkImageSubresourceRange& range, VkImageLayout old_layout,
+                    VkImageLayout new_layout, const OwnershipTransfer& transfer);
+
 class DeviceMemory : public core::Inherit<DeviceMemory, core::Object> {
  public:
   static absl::StatusOr<core::RefCountPtr<DeviceMemory>> create(
@@ -114,6 +333,9 @@ class Buffer : public core::Inherit<Buffer, core::Object> {
 
   virtual VkBuffer vk_buffer() const = 0;
 
+  // memory the buffer is bound to
+  virtual MemoryAllocation* memory() const = 0;
+
   VkMemoryRequirements memory_requirements() const;
 };
 
@@ -212,8 +434,11 @@ class CommandPool : public core::Inherit<CommandPool, core::Object> {
   static absl::StatusOr<core::RefCountPtr<CommandPool>> create(
       const core::RefCountPtr<Device>& device, uint32_t queue_family_index);
 
-  CommandPool(core::RefCountPtr<Device> device, VkCommandPool vk_command_pool)
-      : device_(device), vk_command_pool_(vk_command_pool) {}
+  CommandPool(core::RefCountPtr<Device> device, VkCommandPool vk_command_pool,
+              uint32_t queue_family_index)
+      : device_(device),
+        vk_command_pool_(vk_command_pool),
+        queue_family_index_(queue_family_index) {}
 
   ~CommandPool();
 
@@ -221,12 +446,19 @@ class CommandPool : public core::Inherit<CommandPool, core::Object> {
 
   VkCommandPool vk_command_pool() const { return vk_command_pool_; }
 
+  // its command buffers are submitted to queues of this family only
+  uint32_t queue_family_index() const { return queue_family_index_; }
+
   absl::StatusOr<core::RefCountPtr<CommandBuffer>> allocate_command_buffer(
       VkCommandBufferLevel level);
 
+  // recycles the memory of all its command buffers, none of them may be pending execution
+  absl::Status reset();
+
  private:
   core::RefCountPtr<Device> device_;
   VkCommandPool vk_command_pool_{VK_NULL_HANDLE};
+  uint32_t queue_family_index_;
 };
 
 class CommandBuffer : public core::Inherit<CommandBuffer, core::Object> {
@@ -236,11 +468,20 @@ class CommandBuffer : public core::Inherit<CommandBuffer, core::Object> {
 
   ~CommandBuffer();
 
+  const core::RefCountPtr<CommandPool>& command_pool() const { return command_pool_; }
+
   VkCommandBuffer vk_command_buffer() const { return vk_command_buffer_; }
 
-  absl::Status begin();
+  absl::Status begin() { return begin(0, nullptr); }
+
+  // secondary command buffers need `inheritance_info`
+  absl::Status begin(VkCommandBufferUsageFlags flags,
+                     const VkCommandBufferInheritanceInfo* inheritance_info);
   absl::Status end();
 
+  // keeps `resource` alive until the command buffer is recorded again or destroyed. destroying
+  // does not wait for a pending submission, objects the gpu may still use defer their own release
+  // through Device::destroy_deferred, as the vulkan wrappers do.
   absl::Status add_temporary_resource(core::RefCountPtr<core::Object> resource);
 
  private:
@@ -2,6 +2,7 @@
 
 #include "glog/logging.h"
 #include "gtest/gtest.h"
+#include "memory_allocator.h"
 #include "vk_api.h"
 
 namespace lance {
@@ -23,5 +24,121 @@ TEST(instance, 3d) {
 
   auto device = instance->create_device_for_graphics().value();
 }
+
+TEST(device, buffers_share_memory_blocks) {
+  auto instance = Instance::create_for_3d().value();
+  auto device = instance->create_device_for_graphics().value();
+
+  std::vector<core::RefCountPtr<Buffer>> buffers;
+  for (int i = 0; i < 16; ++i) {
+    buffers.push_back(device
+                          ->create_buffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 4096,
+                                          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+                          .value());
+  }
+  ASSERT_EQ(buffers[0]->memory()->vk_device_memory(), buffers[1]->memory()->vk_device_memory());
+  ASSERT_NE(buffers[0]->memory()->offset(), buffers[1]->memory()->offset());
+  ASSERT_NE(nullptr, buffers[1]->memory()->map().value());
+
+  auto stats = device->memory_allocator()->stats();
+  ASSERT_EQ(1, stats.block_count);
+  ASSERT_EQ(16, stats.allocation_count);
+  ASSERT_GE(stats.used_bytes, 16 * 4096);
+
+  buffers.clear();
+  stats = device->memory_allocator()->stats();
+  ASSERT_EQ(0, stats.allocation_count);
+  ASSERT_EQ(0, stats.used_bytes);
+}
+
+TEST(device, submit_async) {
+  auto instance = Instance::create_for_3d().value();
+  auto device = instance->create_device_for_graphics().value();
+  const uint32_t queue_family_index =
+      device->find_queue_family_index(VK_QUEUE_GRAPHICS_BIT).value();
+
+  ASSERT_TRUE(device->is_complete(SubmitToken()).value());
+
+  // no command buffers, the submission only advances the queue's timeline
+  auto first = device->submit_async(queue_family_index, SubmitInfo()).value();
+  auto second = device->submit_async(queue_family_index, SubmitInfo()).value();
+  ASSERT_EQ(first.value + 1, second.value);
+
+  int completed = 0;
+  ASSERT_TRUE(device->on_complete(second, [&completed]() { ++completed; }).ok());
+  ASSERT_TRUE(device->wait(second).ok());
+  ASSERT_EQ(1, completed);
+  ASSERT_TRUE(device->is_complete(first).value());
+
+  // already complete, runs right away
+  ASSERT_TRUE(device->on_complete(first, [&completed]() { ++completed; }).ok());
+  ASSERT_EQ(2, completed);
+
+  ASSERT_TRUE(device->wait_idle().ok());
+}
+
+TEST(device, deferred_destruction) {
+  auto instance = Instance::create_for_3d().value();
+  auto device = instance->create_device_for_graphics().value();
+  const uint32_t queue_family_index =
+      device->find_queue_family_index(VK_QUEUE_GRAPHICS_BIT).value();
+
+  // nothing in flight, destroyed right away
+  auto buffer = device
+                    ->create_buffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 1024,
+                                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+                    .value();
+  buffer.reset(nullptr);
+  ASSERT_EQ(0, device->memory_allocator()->stats().allocation_count);
+
+  buffer = device
+               ->create_buffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 1024,
+                               VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+               .value();
+  auto token = device->submit_async(queue_family_index, SubmitInfo()).value();
+  buffer.reset(nullptr);
+
+  // released behind the submission
+  ASSERT_TRUE(device->wait(token).ok());
+  ASSERT_TRUE(device->poll().ok());
+  ASSERT_EQ(0, device->memory_allocator()->stats().allocation_count);
+
+  // deferred objects hold no references to the device, releasing it drains them
+  buffer = device
+               ->create_buffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 1024,
+                               VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+               .value();
+  auto command_pool = CommandPool::create(device, queue_family_index).value();
+  auto command_buffer =
+      command_pool->allocate_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY).value();
+  ASSERT_TRUE(device->submit_async(queue_family_index, SubmitInfo()).ok());
+  buffer.reset(nullptr);
+  command_buffer.reset(nullptr);
+  command_pool.reset(nullptr);
+  ASSERT_EQ(1, device->reference_count());
+}
+
+TEST(device, cross_queue_wait) {
+  auto instance = Instance::create_for_3d().value();
+  auto device = instance->create_device_for_graphics().value();
+
+  // falls back to another kind's queue when the device has no dedicated family
+  Queue* transfer = device->queue(QueueKind::kTransfer);
+  Queue* graphics = device->queue(QueueKind::kGraphics);
+  ASSERT_NE(nullptr, transfer);
+  ASSERT_NE(nullptr, graphics);
+  ASSERT_NE(nullptr, device->queue(QueueKind::kAsyncCompute));
+
+  auto upload = transfer->submit(SubmitInfo()).value();
+  ASSERT_EQ(transfer->family_index(), upload.queue_family_index);
+
+  // the graphics submission completes after the one it waits for
+  const SemaphoreSubmit wait_semaphore = device->wait_semaphore(upload).value();
+  SubmitInfo info;
+  info.wait_semaphores = absl::MakeConstSpan(&wait_semaphore, 1);
+  auto draw = graphics->submit(info).value();
+  ASSERT_TRUE(device->wait(draw).ok());
+  ASSERT_TRUE(device->is_complete(upload).value());
+}
 }  // namespace rendering
 }  // namespace lance
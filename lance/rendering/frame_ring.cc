@@ -0,0 +1,116 @@
+#include "frame_ring.h"
+
+#include "glog/logging.h"
+#include "lance/core/profiler.h"
+
+namespace lance {
+namespace rendering {
+FrameContext::FrameContext(core::RefCountPtr<Device> device, Queue* queue,
+                           core::RefCountPtr<CommandPool> command_pool)
+    : device_(device), queue_(queue), command_pool_(command_pool) {}
+
+absl::StatusOr<CommandBuffer*> FrameContext::allocate_command_buffer(VkCommandBufferLevel level) {
+  auto& command_buffers = command_buffers_[level];
+  size_t& used = command_buffers_used_[level];
+
+  if (used == command_buffers.size()) {
+    LANCE_ASSIGN_OR_RETURN(command_buffer, command_pool_->allocate_command_buffer(level));
+    command_buffers.push_back(command_buffer);
+  }
+
+  return command_buffers[used++].get();
+}
+
+void FrameContext::add_temporary_resource(core::RefCountPtr<core::Object> resource) {
+  temporary_resources_.push_back(std::move(resource));
+}
+
+absl::StatusOr<SubmitToken> FrameContext::submit(const SubmitInfo& info) {
+  LANCE_ASSIGN_OR_RETURN(token, queue_->submit(info));
+
+  // submissions on one queue complete in order
+  last_submitted_ = token;
+  return token;
+}
+
+absl::Status FrameContext::recycle(uint64_t frame_number) {
+  if (last_submitted_.value != 0) {
+    LANCE_PROFILE_ZONE("FrameRing::wait");
+    LANCE_RETURN_IF_FAILED(queue_->wait(last_submitted_.value));
+  }
+
+  VLOG(2) << "recycle frame " << frame_number_ << " for frame " << frame_number
+          << ", primary command buffers: " << command_buffers_used_[0]
+          << ", secondary command buffers: " << command_buffers_used_[1]
+          << ", temporary resources: " << temporary_resources_.size();
+
+  // clear() keeps the capacity for the next frame
+  temporary_resources_.clear();
+  LANCE_RETURN_IF_FAILED(command_pool_->reset());
+  command_buffers_used_[0] = command_buffers_used_[1] = 0;
+
+  frame_number_ = frame_number;
+  last_submitted_ = SubmitToken();
+  return absl::OkStatus();
+}
+
+absl::StatusOr<core::RefCountPtr<FrameRing>> FrameRing::create(
+    const core::RefCountPtr<Device>& device, Queue* queue, const FrameRingOptions& options) {
+  if (options.frames_in_flight == 0) {
+    return absl::InvalidArgumentError("frames_in_flight must not be 0");
+  }
+
+  auto ring = core::make_refcounted<FrameRing>(device, queue);
+  LANCE_RETURN_IF_FAILED(ring->initialize(options.frames_in_flight));
+
+  return ring;
+}
+
+FrameRing::FrameRing(core::RefCountPtr<Device> device, Queue* queue)
+    : device_(device), queue_(queue) {}
+
+FrameRing::~FrameRing() {
+  auto status = wait_idle();
+  if (!status.ok()) {
+    LOG(ERROR) << "failed to wait for frames in flight: " << status;
+  }
+}
+
+absl::Status FrameRing::initialize(uint32_t frames_in_flight) {
+  for (uint32_t i = 0; i < frames_in_flight; ++i) {
+    LANCE_ASSIGN_OR_RETURN(command_pool, CommandPool::create(device_, queue_->family_index()));
+    frames_.push_back(std::make_unique<FrameContext>(device_, queue_, command_pool));
+  }
+
+  return absl::OkStatus();
+}
+
+absl::StatusOr<FrameContext*> FrameRing::begin_frame() {
+  CHECK(current_ == nullptr) << "frame " << current_->frame_number() << " was not ended";
+
+  FrameContext* frame = frames_[frame_count_ % frames_.size()].get();
+  LANCE_RETURN_IF_FAILED(frame->recycle(frame_count_));
+  // objects dropped during earlier frames are destroyed once the gpu is done with them
+  LANCE_RETURN_IF_FAILED(device_->poll());
+
+  ++frame_count_;
+  current_ = frame;
+  return frame;
+}
+
+void FrameRing::end_frame() {
+  CHECK(current_ != nullptr) << "no frame was begun";
+
+  current_ = nullptr;
+}
+
+absl::Status FrameRing::wait_idle() {
+  for (const auto& frame : frames_) {
+    LANCE_RETURN_IF_FAILED(device_->wait(frame->last_submitted()));
+  }
+
+  return absl::OkStatus();
+}
+
+}  // namespace rendering
+}  // namespace lance
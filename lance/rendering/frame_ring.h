@@ -0,0 +1,104 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "device.h"
+#include "lance/core/object.h"
+
+namespace lance {
+namespace rendering {
+struct FrameRingOptions {
+  // frames the cpu may record ahead of the gpu, the one recording included
+  uint32_t frames_in_flight = 2;
+};
+
+// per-frame state of a FrameRing. everything it hands out stays valid until the ring begins
+// the frame that reuses its slot, once the gpu is done with this one.
+class FrameContext {
+ public:
+  FrameContext(core::RefCountPtr<Device> device, Queue* queue,
+               core::RefCountPtr<CommandPool> command_pool);
+
+  FrameContext(const FrameContext&) = delete;
+  FrameContext& operator=(const FrameContext&) = delete;
+
+  // frames begun before this one on the ring
+  uint64_t frame_number() const { return frame_number_; }
+
+  // a command buffer of the frame's pool, recycled from an earlier frame in the slot when there
+  // is one. begin() it before recording.
+  absl::StatusOr<CommandBuffer*> allocate_command_buffer(
+      VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+  // keeps `resource` alive until the frame's submissions completed
+  void add_temporary_resource(core::RefCountPtr<core::Object> resource);
+
+  // submits on the ring's queue, the frame completes with its last submission
+  absl::StatusOr<SubmitToken> submit(const SubmitInfo& info);
+
+  // completion of the frame's submissions so far
+  SubmitToken last_submitted() const { return last_submitted_; }
+
+ private:
+  friend class FrameRing;
+
+  // waits for the previous frame in the slot, then recycles its pool and resources
+  absl::Status recycle(uint64_t frame_number);
+
+  core::RefCountPtr<Device> device_;
+  Queue* queue_;
+  core::RefCountPtr<CommandPool> command_pool_;
+
+  uint64_t frame_number_ = 0;
+  SubmitToken last_submitted_;
+
+  // allocated once, reused after every pool reset. indexed by VkCommandBufferLevel.
+  std::vector<core::RefCountPtr<CommandBuffer>> command_buffers_[2];
+  size_t command_buffers_used_[2] = {0, 0};
+
+  std::vector<core::RefCountPtr<core::Object>> temporary_resources_;
+};
+
+// a ring of frame contexts. begin_frame() blocks only when the gpu is frames_in_flight frames
+// behind, command buffers are recorded into pools that are reset as a whole instead of being
+// allocated and freed every frame. not thread-safe, frames are begun and ended by one thread.
+class FrameRing : public core::Inherit<FrameRing, core::Object> {
+ public:
+  static absl::StatusOr<core::RefCountPtr<FrameRing>> create(
+      const core::RefCountPtr<Device>& device, Queue* queue, const FrameRingOptions& options = {});
+
+  FrameRing(core::RefCountPtr<Device> device, Queue* queue);
+
+  // waits for the frames in flight
+  ~FrameRing() override;
+
+  // the context of the next frame, valid until end_frame()
+  absl::StatusOr<FrameContext*> begin_frame();
+
+  void end_frame();
+
+  // the frame between begin_frame() and end_frame(), nullptr outside of one
+  FrameContext* current_frame() const { return current_; }
+
+  // frames begun so far
+  uint64_t frame_count() const { return frame_count_; }
+
+  uint32_t frames_in_flight() const { return frames_.size(); }
+
+  absl::Status wait_idle();
+
+ private:
+  absl::Status initialize(uint32_t frames_in_flight);
+
+  core::RefCountPtr<Device> device_;
+  Queue* queue_;
+
+  std::vector<std::unique_ptr<FrameContext>> frames_;
+  FrameContext* current_ = nullptr;
+  uint64_t frame_count_ = 0;
+};
+
+}  // namespace rendering
+}  // namespace lance
@@ -0,0 +1,59 @@
+#include "frame_ring.h"
+
+#include "gtest/gtest.h"
+
+namespace lance {
+namespace rendering {
+namespace {
+class CountedResource : public core::Inherit<CountedResource, core::Object> {
+ public:
+  CountedResource(int* alive) : alive_(alive) { ++*alive_; }
+
+  ~CountedResource() override { --*alive_; }
+
+ private:
+  int* alive_;
+};
+}  // namespace
+
+TEST(frame_ring, recycles_command_buffers_and_resources) {
+  auto instance = Instance::create_for_3d().value();
+  auto device = instance->create_device_for_graphics().value();
+
+  FrameRingOptions options;
+  options.frames_in_flight = 2;
+  auto ring = FrameRing::create(device, device->queue(QueueKind::kGraphics), options).value();
+
+  int alive = 0;
+  CommandBuffer* first_command_buffer = nullptr;
+  for (uint64_t i = 0; i < 6; ++i) {
+    FrameContext* frame = ring->begin_frame().value();
+    ASSERT_EQ(i, frame->frame_number());
+
+    // the resources of the frame that used the slot before were released
+    ASSERT_LE(alive, 1);
+
+    auto command_buffer = frame->allocate_command_buffer().value();
+    if (i == 0) {
+      first_command_buffer = command_buffer;
+    } else if (i % 2 == 0) {
+      ASSERT_EQ(first_command_buffer, command_buffer);
+    }
+
+    ASSERT_TRUE(command_buffer->begin().ok());
+    ASSERT_TRUE(command_buffer->end().ok());
+    frame->add_temporary_resource(core::make_refcounted<CountedResource>(&alive));
+
+    const VkCommandBuffer vk_command_buffer = command_buffer->vk_command_buffer();
+    SubmitInfo info;
+    info.command_buffers = absl::MakeConstSpan(&vk_command_buffer, 1);
+    ASSERT_TRUE(frame->submit(info).ok());
+
+    ring->end_frame();
+  }
+
+  ASSERT_EQ(6, ring->frame_count());
+  ASSERT_TRUE(ring->wait_idle().ok());
+}
+}  // namespace rendering
+}  // namespace lance
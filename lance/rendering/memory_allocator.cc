@@ -0,0 +1,247 @@
+#include "memory_allocator.h"
+
+#include <algorithm>
+
+#include "absl/strings/str_format.h"
+#include "device.h"
+#include "glog/logging.h"
+#include "vk_api.h"
+
+namespace lance {
+namespace rendering {
+struct MemoryBlock {
+  MemoryBlock(VkDeviceMemory _vk_device_memory, uint32_t _pool_index, VkDeviceSize size)
+      : vk_device_memory(_vk_device_memory), pool_index(_pool_index), ranges(size) {}
+
+  VkDeviceMemory vk_device_memory;
+  uint32_t pool_index;
+  core::TlsfAllocator ranges;
+
+  // whole block, mapped on first use
+  void* mapped = nullptr;
+};
+
+MemoryAllocation::~MemoryAllocation() {
+  if (allocator_) {
+    allocator_->free(block_, vk_device_memory_, range_);
+  }
+}
+
+void MemoryAllocation::Detached::free() const {
+  if (allocator) {
+    allocator->free(block, vk_device_memory, range);
+  }
+}
+
+MemoryAllocation::Detached MemoryAllocation::detach(
+    core::RefCountPtr<MemoryAllocation> allocation) {
+  Detached detached;
+  if (!allocation.get()) {
+    return detached;
+  }
+  CHECK_EQ(1, allocation->reference_count()) << "memory detached while still referenced";
+
+  detached.allocator = allocation->allocator_;
+  detached.block = allocation->block_;
+  detached.vk_device_memory = allocation->vk_device_memory_;
+  detached.range = allocation->range_;
+
+  // the destructor leaves the memory alone
+  allocation->allocator_ = nullptr;
+  return detached;
+}
+
+absl::StatusOr<void*> MemoryAllocation::map() { return allocator_->map(this); }
+
+MemoryAllocator::MemoryAllocator(Device* device, VkPhysicalDevice vk_physical_device,
+                                 const MemoryAllocatorOptions& options)
+    : device_(device), options_(options) {
+  VkApi::get()->vkGetPhysicalDeviceMemoryProperties(vk_physical_device, &memory_properties_);
+
+  VkPhysicalDeviceProperties properties;
+  VkApi::get()->vkGetPhysicalDeviceProperties(vk_physical_device, &properties);
+  buffer_image_granularity_ = properties.limits.bufferImageGranularity;
+
+  pools_.resize(memory_properties_.memoryTypeCount * 2);
+}
+
+MemoryAllocator::~MemoryAllocator() {
+  CHECK_EQ(0, dedicated_count_) << "dedicated allocations outlive their allocator";
+
+  for (auto& pool : pools_) {
+    for (auto& block : pool) {
+      CHECK(block->ranges.empty()) << "allocations outlive their allocator";
+      VkApi::get()->vkFreeMemory(device_->vk_device(), block->vk_device_memory, nullptr);
+    }
+  }
+}
+
+absl::StatusOr<uint32_t> MemoryAllocator::find_memory_type_index(
+    uint32_t type_bits, VkMemoryPropertyFlags flags) const {
+  for (uint32_t i = 0; i < memory_properties_.memoryTypeCount; ++i) {
+    if (((1 << i) & type_bits) &&
+        ((memory_properties_.memoryTypes[i].propertyFlags & flags) == flags)) {
+      return i;
+    }
+  }
+
+  return absl::NotFoundError(absl::StrFormat("no suitable memory found, flags: %d", flags));
+}
+
+absl::StatusOr<VkDeviceMemory> MemoryAllocator::allocate_memory(uint32_t memory_type_index,
+                                                                VkDeviceSize size) {
+  VkMemoryAllocateInfo memory_allocate_info = {};
+  memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  memory_allocate_info.allocationSize = size;
+  memory_allocate_info.memoryTypeIndex = memory_type_index;
+
+  VkDeviceMemory vk_device_memory{VK_NULL_HANDLE};
+  VK_RETURN_IF_FAILED(VkApi::get()->vkAllocateMemory(device_->vk_device(), &memory_allocate_info,
+                                                     nullptr, &vk_device_memory));
+
+  return vk_device_memory;
+}
+
+absl::StatusOr<core::RefCountPtr<MemoryAllocation>> MemoryAllocator::allocate_dedicated(
+    uint32_t memory_type_index, VkDeviceSize size) {
+  LANCE_ASSIGN_OR_RETURN(vk_device_memory, allocate_memory(memory_type_index, size));
+
+  ++dedicated_count_;
+  dedicated_bytes_ += size;
+
+  core::TlsfAllocator::Allocation range;
+  range.size = size;
+  return core::make_refcounted<MemoryAllocation>(device_, this, nullptr, vk_device_memory,
+                                                 memory_type_index, range);
+}
+
+absl::StatusOr<core::RefCountPtr<MemoryAllocation>> MemoryAllocator::allocate(
+    const VkMemoryRequirements& requirements, VkMemoryPropertyFlags flags, ResourceTiling tiling) {
+  LANCE_ASSIGN_OR_RETURN(memory_type_index,
+                         find_memory_type_index(requirements.memoryTypeBits, flags));
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  const VkDeviceSize heap_size =
+      memory_properties_.memoryHeaps[memory_properties_.memoryTypes[memory_type_index].heapIndex]
+          .size;
+  const VkDeviceSize block_size = std::min(options_.block_size, heap_size / 8);
+  if (requirements.size >= options_.dedicated_threshold || requirements.size > block_size) {
+    return allocate_dedicated(memory_type_index, requirements.size);
+  }
+
+  // with a granularity of 1 linear and optimal resources may be neighbours
+  const bool separate_tiling = buffer_image_granularity_ > 1 && tiling == ResourceTiling::kOptimal;
+  const uint32_t pool_index = memory_type_index * 2 + (separate_tiling ? 1 : 0);
+  auto& pool = pools_[pool_index];
+
+  for (auto& block : pool) {
+    auto range = block->ranges.allocate(requirements.size, requirements.alignment);
+    if (range.valid()) {
+      return core::make_refcounted<MemoryAllocation>(device_, this, block.get(),
+                                                     block->vk_device_memory, memory_type_index,
+                                                     range);
+    }
+  }
+
+  auto vk_device_memory = allocate_memory(memory_type_index, block_size);
+  if (!vk_device_memory.ok()) {
+    // the heap may still fit the resource alone
+    LOG(WARNING) << "failed to allocate memory block, fall back to dedicated allocation: "
+                 << vk_device_memory.status();
+    return allocate_dedicated(memory_type_index, requirements.size);
+  }
+
+  VLOG(1) << "new memory block, memory_type_index: " << memory_type_index
+          << ", size: " << block_size << ", blocks in pool: " << pool.size() + 1;
+
+  auto& block = pool.emplace_back(
+      std::make_unique<MemoryBlock>(*vk_device_memory, pool_index, block_size));
+  auto range = block->ranges.allocate(requirements.size, requirements.alignment);
+  CHECK(range.valid());
+
+  return core::make_refcounted<MemoryAllocation>(device_, this, block.get(),
+                                                 block->vk_device_memory, memory_type_index, range);
+}
+
+void MemoryAllocator::free(MemoryBlock* block, VkDeviceMemory vk_device_memory,
+                           const core::TlsfAllocator::Allocation& range) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if (block == nullptr) {
+    // dedicated, implicitly unmapped
+    VkApi::get()->vkFreeMemory(device_->vk_device(), vk_device_memory, nullptr);
+    --dedicated_count_;
+    dedicated_bytes_ -= range.size;
+    return;
+  }
+
+  block->ranges.free(range);
+  if (!block->ranges.empty()) {
+    return;
+  }
+
+  // keep one empty block per pool, so that a resource recreated every frame does not allocate
+  // a block every frame
+  auto& pool = pools_[block->pool_index];
+  const bool has_other_empty_block =
+      std::any_of(pool.begin(), pool.end(),
+                  [block](const auto& b) { return b.get() != block && b->ranges.empty(); });
+  if (has_other_empty_block) {
+    VkApi::get()->vkFreeMemory(device_->vk_device(), block->vk_device_memory, nullptr);
+    pool.erase(std::find_if(pool.begin(), pool.end(),
+                            [block](const auto& b) { return b.get() == block; }));
+  }
+}
+
+absl::StatusOr<void*> MemoryAllocator::map(MemoryAllocation* allocation) {
+  const VkMemoryPropertyFlags property_flags =
+      memory_properties_.memoryTypes[allocation->memory_type_index()].propertyFlags;
+  if (!(property_flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)) {
+    return absl::FailedPreconditionError("memory is not host visible");
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  void** mapped = allocation->dedicated() ? &allocation->mapped_ : &allocation->block_->mapped;
+  if (*mapped == nullptr) {
+    VK_RETURN_IF_FAILED(VkApi::get()->vkMapMemory(
+        device_->vk_device(), allocation->vk_device_memory(), 0, VK_WHOLE_SIZE, 0, mapped));
+  }
+
+  // dedicated allocations start at offset 0
+  return static_cast<char*>(*mapped) + allocation->offset();
+}
+
+MemoryAllocatorStats MemoryAllocator::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  MemoryAllocatorStats stats;
+  stats.dedicated_count = dedicated_count_;
+  stats.allocation_count = dedicated_count_;
+  stats.allocated_bytes = dedicated_bytes_;
+  stats.used_bytes = dedicated_bytes_;
+
+  VkDeviceSize free_bytes = 0;
+  VkDeviceSize largest_free_range = 0;
+  for (const auto& pool : pools_) {
+    for (const auto& block : pool) {
+      const auto block_stats = block->ranges.stats();
+      ++stats.block_count;
+      stats.allocation_count += block_stats.allocation_count;
+      stats.allocated_bytes += block_stats.capacity;
+      stats.used_bytes += block_stats.used_bytes;
+      free_bytes += block_stats.free_bytes;
+      largest_free_range = std::max(largest_free_range, block_stats.largest_free_range);
+    }
+  }
+
+  if (free_bytes > 0) {
+    stats.fragmentation = 1.0 - static_cast<double>(largest_free_range) / free_bytes;
+  }
+
+  return stats;
+}
+
+}  // namespace rendering
+}  // namespace lance
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "device.h"
+#include "lance/core/object.h"
+#include "lance/core/tlsf_allocator.h"
+#include "vulkan/vulkan_core.h"
+
+namespace lance {
+namespace rendering {
+class MemoryAllocator;
+struct MemoryBlock;
+
+// buffers and linear images must not share a bufferImageGranularity page with optimal images.
+// the allocator keeps them in separate blocks instead of padding every allocation.
+enum class ResourceTiling {
+  kLinear,
+  kOptimal,
+};
+
+struct MemoryAllocatorOptions {
+  // size of the VkDeviceMemory blocks resources are sub-allocated from, capped at 1/8 of its heap
+  VkDeviceSize block_size = VkDeviceSize(64) << 20;
+
+  // resources at least this large get a VkDeviceMemory of their own
+  VkDeviceSize dedicated_threshold = VkDeviceSize(32) << 20;
+};
+
+struct MemoryAllocatorStats {
+  uint32_t block_count = 0;
+  uint32_t dedicated_count = 0;
+  // sub-allocations and dedicated allocations
+  uint32_t allocation_count = 0;
+
+  // reserved from the driver, blocks and dedicated allocations
+  VkDeviceSize allocated_bytes = 0;
+  // handed out to resources, alignment padding included
+  VkDeviceSize used_bytes = 0;
+
+  // 1 - largest free range / free bytes over all blocks, 0 when nothing is fragmented
+  double fragmentation = 0;
+};
+
+// memory a buffer or image is bound to, returned to its allocator once released
+class MemoryAllocation : public core::Inherit<MemoryAllocation, core::Object> {
+ public:
+  // the memory of a detached allocation, without the reference to the device. destruction
+  // deferred by the device frees it, the device drains those before destroying its allocator.
+  struct Detached {
+    MemoryAllocator* allocator = nullptr;
+    MemoryBlock* block = nullptr;
+    VkDeviceMemory vk_device_memory{VK_NULL_HANDLE};
+    core::TlsfAllocator::Allocation range;
+
+    // returns the memory to the allocator, does nothing for an empty allocation
+    void free() const;
+  };
+
+  // takes the memory out of `allocation`, which must be the last reference to it
+  static Detached detach(core::RefCountPtr<MemoryAllocation> allocation);
+
+  // made by MemoryAllocator::allocate
+  MemoryAllocation(core::RefCountPtr<Device> device, MemoryAllocator* allocator,
+                   MemoryBlock* block, VkDeviceMemory vk_device_memory, uint32_t memory_type_index,
+                   core::TlsfAllocator::Allocation range)
+      : device_(device),
+        allocator_(allocator),
+        block_(block),
+        vk_device_memory_(vk_device_memory),
+        memory_type_index_(memory_type_index),
+        range_(range) {}
+
+  ~MemoryAllocation() override;
+
+  VkDeviceMemory vk_device_memory() const { return vk_device_memory_; }
+
+  // of the allocation in vk_device_memory(), bind resources here
+  VkDeviceSize offset() const { return range_.offset; }
+
+  VkDeviceSize size() const { return range_.size; }
+
+  uint32_t memory_type_index() const { return memory_type_index_; }
+
+  // owns vk_device_memory() alone
+  bool dedicated() const { return block_ == nullptr; }
+
+  // host visible memory only. memory stays mapped until it is freed, mapping again is cheap.
+  absl::StatusOr<void*> map();
+
+ private:
+  friend class MemoryAllocator;
+
+  // keeps the allocator alive
+  core::RefCountPtr<Device> device_;
+  MemoryAllocator* allocator_;
+  MemoryBlock* block_;
+  VkDeviceMemory vk_device_memory_;
+  uint32_t memory_type_index_;
+  core::TlsfAllocator::Allocation range_;
+
+  // dedicated allocations only, blocks are mapped as a whole
+  void* mapped_{nullptr};
+};
+
+// sub-allocates resources from large VkDeviceMemory blocks per memory type, so that creating a
+// buffer or image does not cost a vkAllocateMemory and the driver's allocation count limit is
+// out of reach. thread-safe.
+class MemoryAllocator {
+ public:
+  MemoryAllocator(Device* device, VkPhysicalDevice vk_physical_device,
+                  const MemoryAllocatorOptions& options = {});
+
+  // every allocation must be released before
+  ~MemoryAllocator();
+
+  MemoryAllocator(const MemoryAllocator&) = delete;
+  MemoryAllocator& operator=(const MemoryAllocator&) = delete;
+
+  // `requirements` as queried for the resource
+  absl::StatusOr<core::RefCountPtr<MemoryAllocation>> allocate(
+      const VkMemoryRequirements& requirements, VkMemoryPropertyFlags flags,
+      ResourceTiling tiling);
+
+  MemoryAllocatorStats stats() const;
+
+ private:
+  friend class MemoryAllocation;
+  friend struct MemoryAllocation::Detached;
+
+  absl::StatusOr<uint32_t> find_memory_type_index(uint32_t type_bits,
+                                                  VkMemoryPropertyFlags flags) const;
+
+  absl::StatusOr<VkDeviceMemory> allocate_memory(uint32_t memory_type_index, VkDeviceSize size);
+
+  absl::StatusOr<core::RefCountPtr<MemoryAllocation>> allocate_dedicated(
+      uint32_t memory_type_index, VkDeviceSize size);
+
+  void free(MemoryBlock* block, VkDeviceMemory vk_device_memory,
+            const core::TlsfAllocator::Allocation& range);
+
+  absl::StatusOr<void*> map(MemoryAllocation* allocation);
+
+  Device* device_;
+  const MemoryAllocatorOptions options_;
+
+  VkPhysicalDeviceMemoryProperties memory_properties_;
+  VkDeviceSize buffer_image_granularity_;
+
+  mutable std::mutex mutex_;
+
+  // indexed by memory type * 2 + tiling
+  std::vector<std::vector<std::unique_ptr<MemoryBlock>>> pools_;
+
+  uint32_t dedicated_count_{0};
+  VkDeviceSize dedicated_bytes_{0};
+};
+
+}  // namespace rendering
+}  // namespace lance
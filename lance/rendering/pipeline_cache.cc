@@ -0,0 +1,182 @@
+#include "pipeline_cache.h"
+
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+#include "absl/strings/str_format.h"
+#include "device.h"
+#include "glog/logging.h"
+#include "lance/core/file_system.h"
+#include "lance/core/profiler.h"
+#include "vk_api.h"
+
+namespace lance {
+namespace rendering {
+namespace {
+constexpr uint32_t kFileMagic = 0x4643504c;  // "LPCF"
+constexpr uint32_t kFileVersion = 1;
+
+// precedes the data of vkGetPipelineCacheData, whose own header lacks the driver version
+struct FileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t vendor_id;
+  uint32_t device_id;
+  uint32_t driver_version;
+  uint8_t pipeline_cache_uuid[VK_UUID_SIZE];
+  uint64_t data_size;
+};
+
+FileHeader make_file_header(const VkPhysicalDeviceProperties& properties, uint64_t data_size) {
+  // no uninitialized padding ends up in the file
+  FileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  header.magic = kFileMagic;
+  header.version = kFileVersion;
+  header.vendor_id = properties.vendorID;
+  header.device_id = properties.deviceID;
+  header.driver_version = properties.driverVersion;
+  std::memcpy(header.pipeline_cache_uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+  header.data_size = data_size;
+  return header;
+}
+
+bool is_compatible(const FileHeader& header, const FileHeader& expected) {
+  return header.magic == expected.magic && header.version == expected.version &&
+         header.vendor_id == expected.vendor_id && header.device_id == expected.device_id &&
+         header.driver_version == expected.driver_version &&
+         std::memcmp(header.pipeline_cache_uuid, expected.pipeline_cache_uuid, VK_UUID_SIZE) == 0;
+}
+}  // namespace
+
+PipelineCache::PipelineCache(Device* device, VkPhysicalDevice vk_physical_device)
+    : device_(device) {
+  VkApi::get()->vkGetPhysicalDeviceProperties(vk_physical_device, &properties_);
+
+  VkPipelineCacheCreateInfo pipeline_cache_create_info = {};
+  pipeline_cache_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  const VkResult ret_code = VkApi::get()->vkCreatePipelineCache(
+      device_->vk_device(), &pipeline_cache_create_info, nullptr, &vk_pipeline_cache_);
+  CHECK_EQ(VK_SUCCESS, ret_code) << "failed to create pipeline cache, ret_code: "
+                                 << VkResult_name(ret_code);
+}
+
+PipelineCache::~PipelineCache() {
+  auto status = save();
+  if (!status.ok()) {
+    LOG(ERROR) << "failed to save pipeline cache: " << status;
+  }
+
+  VkApi::get()->vkDestroyPipelineCache(device_->vk_device(), vk_pipeline_cache_, nullptr);
+}
+
+absl::StatusOr<bool> PipelineCache::load(std::string_view path) {
+  LANCE_PROFILE_ZONE("PipelineCache::load");
+
+  path_ = std::string(path);
+
+  LANCE_ASSIGN_OR_RETURN(fs, core::create_local_file_system());
+  auto stream = fs->create_input_stream(path);
+  if (absl::IsNotFound(stream.status())) {
+    LOG(INFO) << "no pipeline cache yet, path: " << path;
+    return false;
+  }
+  LANCE_RETURN_IF_FAILED(stream.status());
+
+  const size_t size = (*stream)->size();
+  if (size < sizeof(FileHeader)) {
+    LOG(WARNING) << "pipeline cache truncated, skipped, path: " << path;
+    return false;
+  }
+  const FileHeader expected = make_file_header(properties_, size - sizeof(FileHeader));
+
+  LANCE_ASSIGN_OR_RETURN(blob, (*stream)->map(0, size));
+  const auto* bytes = static_cast<const uint8_t*>(blob->data());
+
+  FileHeader header;
+  std::memcpy(&header, bytes, sizeof(header));
+  if (!is_compatible(header, expected) || header.data_size != expected.data_size) {
+    LOG(WARNING) << "pipeline cache of another device or driver version, skipped, path: " << path;
+    return false;
+  }
+
+  VkPipelineCacheCreateInfo pipeline_cache_create_info = {};
+  pipeline_cache_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  pipeline_cache_create_info.initialDataSize = header.data_size;
+  pipeline_cache_create_info.pInitialData = bytes + sizeof(FileHeader);
+
+  VkPipelineCache loaded{VK_NULL_HANDLE};
+  VK_RETURN_IF_FAILED(VkApi::get()->vkCreatePipelineCache(
+      device_->vk_device(), &pipeline_cache_create_info, nullptr, &loaded));
+
+  // merging keeps pipelines created before the load
+  auto status = merge(absl::MakeConstSpan(&loaded, 1));
+  VkApi::get()->vkDestroyPipelineCache(device_->vk_device(), loaded, nullptr);
+  LANCE_RETURN_IF_FAILED(status);
+
+  LOG(INFO) << "pipeline cache loaded, path: " << path << ", bytes: " << header.data_size;
+  return true;
+}
+
+absl::Status PipelineCache::merge(absl::Span<const VkPipelineCache> vk_pipeline_caches) {
+  if (vk_pipeline_caches.empty()) {
+    return absl::OkStatus();
+  }
+
+  VK_RETURN_IF_FAILED(VkApi::get()->vkMergePipelineCaches(device_->vk_device(), vk_pipeline_cache_,
+                                                          vk_pipeline_caches.size(),
+                                                          vk_pipeline_caches.data()));
+
+  return absl::OkStatus();
+}
+
+absl::Status PipelineCache::save() {
+  if (path_.empty()) {
+    return absl::OkStatus();
+  }
+
+  LANCE_PROFILE_ZONE("PipelineCache::save");
+
+  // other threads may add pipelines between querying the size and copying
+  std::vector<uint8_t> data;
+  size_t data_size = 0;
+  for (VkResult ret_code = VK_INCOMPLETE; ret_code == VK_INCOMPLETE;) {
+    VK_RETURN_IF_FAILED(VkApi::get()->vkGetPipelineCacheData(
+        device_->vk_device(), vk_pipeline_cache_, &data_size, nullptr));
+
+    data.resize(sizeof(FileHeader) + data_size);
+    ret_code = VkApi::get()->vkGetPipelineCacheData(device_->vk_device(), vk_pipeline_cache_,
+                                                    &data_size, data.data() + sizeof(FileHeader));
+    if (ret_code != VK_SUCCESS && ret_code != VK_INCOMPLETE) {
+      return absl::UnknownError(absl::StrFormat("vkGetPipelineCacheData failed, ret: %s",
+                                                VkResult_name(ret_code)));
+    }
+  }
+
+  const FileHeader header = make_file_header(properties_, data_size);
+  std::memcpy(data.data(), &header, sizeof(header));
+  data.resize(sizeof(FileHeader) + data_size);
+
+  const std::string temp_path = path_ + ".tmp";
+  {
+    LANCE_ASSIGN_OR_RETURN(fs, core::create_local_file_system());
+    LANCE_ASSIGN_OR_RETURN(stream, fs->create_output_stream(temp_path));
+    LANCE_RETURN_IF_FAILED(stream->write(0, data.size(), data.data()));
+    LANCE_RETURN_IF_FAILED(stream->sync());
+  }
+
+  // replaces the old file at once, on windows as well
+  std::error_code error;
+  std::filesystem::rename(temp_path, path_, error);
+  if (error) {
+    return absl::InternalError(absl::StrFormat("failed to rename %s to %s: %s", temp_path, path_,
+                                               error.message()));
+  }
+
+  VLOG(1) << "pipeline cache saved, path: " << path_ << ", bytes: " << data_size;
+  return absl::OkStatus();
+}
+
+}  // namespace rendering
+}  // namespace lance
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "vulkan/vulkan_core.h"
+
+namespace lance {
+namespace rendering {
+class Device;
+
+// the device's VkPipelineCache, passed to every pipeline creation. vulkan synchronizes it
+// internally, so threads creating pipelines at once share it directly. load() seeds it from a
+// file written by an earlier run, which is kept only if the device, its driver version and its
+// pipeline cache uuid are the same.
+class PipelineCache {
+ public:
+  // starts empty
+  PipelineCache(Device* device, VkPhysicalDevice vk_physical_device);
+
+  // saves to the loaded path, if there is one. the device destroys it once released, call save()
+  // to persist it earlier, e.g. before an exit that skips destructors.
+  ~PipelineCache();
+
+  PipelineCache(const PipelineCache&) = delete;
+  PipelineCache& operator=(const PipelineCache&) = delete;
+
+  VkPipelineCache vk_pipeline_cache() const { return vk_pipeline_cache_; }
+
+  // merges the pipelines saved at `path`, which save() writes to from now on. returns whether the
+  // file was merged, a missing file or one of another device or driver is skipped.
+  absl::StatusOr<bool> load(std::string_view path);
+
+  // merges caches pipelines were created with elsewhere, e.g. externally synchronized ones of a
+  // single thread. they stay valid.
+  absl::Status merge(absl::Span<const VkPipelineCache> vk_pipeline_caches);
+
+  // writes a temporary file next to the loaded path and renames it over, so that a crash never
+  // leaves a partial cache behind. does nothing if nothing was loaded.
+  absl::Status save();
+
+  const std::string& path() const { return path_; }
+
+ private:
+  Device* device_;
+  VkPhysicalDeviceProperties properties_;
+  VkPipelineCache vk_pipeline_cache_{VK_NULL_HANDLE};
+
+  std::string path_;
+};
+
+}  // namespace rendering
+}  // namespace lance
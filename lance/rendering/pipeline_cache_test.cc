@@ -0,0 +1,106 @@
+#include "pipeline_cache.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#include "device.h"
+#include "gtest/gtest.h"
+
+namespace lance {
+namespace rendering {
+namespace {
+std::string read_file(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void write_file(const std::string& path, const std::string& content) {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file << content;
+}
+}  // namespace
+
+TEST(pipeline_cache, save_and_load) {
+  const std::string path = ::testing::TempDir() + "pipeline_cache.bin";
+  std::filesystem::remove(path);
+
+  auto instance = Instance::create_for_3d().value();
+  {
+    auto device = instance->create_device_for_graphics().value();
+    ASSERT_NE(nullptr, device->pipeline_cache()->vk_pipeline_cache());
+
+    // nothing to load on the first run
+    ASSERT_FALSE(device->pipeline_cache()->load(path).value());
+    ASSERT_EQ(path, device->pipeline_cache()->path());
+    ASSERT_TRUE(device->pipeline_cache()->save().ok());
+  }
+  ASSERT_TRUE(std::filesystem::exists(path));
+  ASSERT_FALSE(std::filesystem::exists(path + ".tmp"));
+
+  {
+    auto device = instance->create_device_for_graphics().value();
+    ASSERT_TRUE(device->pipeline_cache()->load(path).value());
+  }
+
+  // a header of another driver version or pipeline cache uuid is rejected, offsets as in
+  // FileHeader
+  const std::string saved = read_file(path);
+  for (size_t offset : {16, 20}) {
+    std::string other = saved;
+    other[offset] ^= 1;
+    write_file(path, other);
+
+    auto device = instance->create_device_for_graphics().value();
+    ASSERT_FALSE(device->pipeline_cache()->load(path).value()) << offset;
+  }
+
+  // so is a file of something else
+  write_file(path, "not a pipeline cache, but long enough to hold the header of one");
+  auto device = instance->create_device_for_graphics().value();
+  ASSERT_FALSE(device->pipeline_cache()->load(path).value());
+}
+
+TEST(pipeline_cache, saved_with_work_in_flight) {
+  const std::string path = ::testing::TempDir() + "pipeline_cache_in_flight.bin";
+  std::filesystem::remove(path);
+
+  auto instance = Instance::create_for_3d().value();
+  {
+    auto device = instance->create_device_for_graphics().value();
+    ASSERT_FALSE(device->pipeline_cache()->load(path).value());
+
+    // dropped without poll() or wait_idle(), the device is still destroyed and saves
+    auto buffer = device
+                      ->create_buffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 1024,
+                                      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+                      .value();
+    const uint32_t queue_family_index =
+        device->find_queue_family_index(VK_QUEUE_GRAPHICS_BIT).value();
+    ASSERT_TRUE(device->submit_async(queue_family_index, SubmitInfo()).ok());
+  }
+  ASSERT_TRUE(std::filesystem::exists(path));
+
+  auto device = instance->create_device_for_graphics().value();
+  ASSERT_TRUE(device->pipeline_cache()->load(path).value());
+}
+
+TEST(pipeline_cache, persisted_across_devices) {
+  const std::string path = ::testing::TempDir() + "pipeline_cache_device.bin";
+  std::filesystem::remove(path);
+
+  auto instance = Instance::create_for_3d().value();
+  {
+    // the first run finds nothing, and saves when the device goes away
+    auto device = instance->create_device_for_graphics(path).value();
+    ASSERT_EQ(path, device->pipeline_cache()->path());
+  }
+  ASSERT_TRUE(std::filesystem::exists(path));
+
+  // the next one starts from it
+  auto device = instance->create_device_for_graphics(path).value();
+  ASSERT_EQ(path, device->pipeline_cache()->path());
+  ASSERT_TRUE(device->pipeline_cache()->load(path).value());
+}
+}  // namespace rendering
+}  // namespace lance
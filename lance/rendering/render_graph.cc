@@ -1,8 +1,17 @@
 #include "render_graph.h"
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
 #include "glog/logging.h"
+#include "lance/core/linear_allocator.h"
+#include "lance/core/profiler.h"
+#include "lance/core/small_containers.h"
+#include "lance/rendering/memory_allocator.h"
+#include "lance/rendering/pipeline_cache.h"
 #include "lance/rendering/vk_api.h"
 
 namespace lance {
@@ -25,11 +34,19 @@ class RenderGraphTexture2D : public core::Inherit<RenderGraphTexture2D, RenderGr
       : id_(id), format_(format), extent_(extent) {}
 
   ~RenderGraphTexture2D() override {
-    if (vk_image_view_) {
-      VkApi::get()->vkDestroyImageView(device_->vk_device(), vk_image_view_, nullptr);
-    }
-    if (vk_image_) {
-      VkApi::get()->vkDestroyImage(device_->vk_device(), vk_image_, nullptr);
+    if (device_.get()) {
+      // the memory is released after the image is destroyed
+      device_->destroy_deferred([vk_device = device_->vk_device(), vk_image = vk_image_,
+                                 vk_image_view = vk_image_view_,
+                                 memory = MemoryAllocation::detach(std::move(memory_))]() {
+        if (vk_image_view) {
+          VkApi::get()->vkDestroyImageView(vk_device, vk_image_view, nullptr);
+        }
+        if (vk_image) {
+          VkApi::get()->vkDestroyImage(vk_device, vk_image, nullptr);
+        }
+        memory.free();
+      });
     }
   }
 
@@ -75,15 +92,13 @@ class RenderGraphTexture2D : public core::Inherit<RenderGraphTexture2D, RenderGr
     VkMemoryRequirements mem_reqs;
     VkApi::get()->vkGetImageMemoryRequirements(device->vk_device(), vk_image_, &mem_reqs);
 
-    LANCE_ASSIGN_OR_RETURN(memory_type_index,
-                           device->find_memory_type_index(mem_reqs.memoryTypeBits,
-                                                          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
-
-    LANCE_ASSIGN_OR_RETURN(memory, DeviceMemory::create(device_, memory_type_index, mem_reqs.size));
-    device_memory_ = memory;
+    LANCE_ASSIGN_OR_RETURN(
+        memory, device->memory_allocator()->allocate(mem_reqs, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                                     ResourceTiling::kOptimal));
+    memory_ = memory;
 
-    VK_RETURN_IF_FAILED(VkApi::get()->vkBindImageMemory(device->vk_device(), vk_image_,
-                                                        device_memory_->vk_device_memory(), 0));
+    VK_RETURN_IF_FAILED(VkApi::get()->vkBindImageMemory(
+        device->vk_device(), vk_image_, memory_->vk_device_memory(), memory_->offset()));
 
     VkImageViewCreateInfo image_view_create_info = {};
     image_view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -117,7 +132,7 @@ class RenderGraphTexture2D : public core::Inherit<RenderGraphTexture2D, RenderGr
   core::RefCountPtr<Device> device_;
 
   VkImage vk_image_{VK_NULL_HANDLE};
-  core::RefCountPtr<DeviceMemory> device_memory_;
+  core::RefCountPtr<MemoryAllocation> memory_;
   VkImageView vk_image_view_{VK_NULL_HANDLE};
 };
 
@@ -129,7 +144,15 @@ class Pass {
 
   virtual absl::Status compile(Device *device) = 0;
 
-  virtual absl::Status execute(CommandBuffer *command_buffer) = 0;
+  // transient data may come from `frame_allocator`, which is reset before the next execute
+  virtual absl::Status execute(CommandBuffer *command_buffer,
+                               core::LinearAllocator *frame_allocator) = 0;
+
+  // begins and records the secondary `command_buffer` on a job system thread. the primary command
+  // buffer begins `render_pass_begin_info` around it, unless its renderPass is VK_NULL_HANDLE.
+  virtual absl::Status execute_secondary(CommandBuffer *command_buffer,
+                                         core::LinearAllocator *frame_allocator,
+                                         VkRenderPassBeginInfo *render_pass_begin_info) = 0;
 };
 
 class ComputePass : public Pass {
@@ -141,7 +164,31 @@ class ComputePass : public Pass {
 
   absl::Status compile(Device *device) override { return absl::OkStatus(); }
 
-  absl::Status execute(CommandBuffer *command_buffer) override {
+  absl::Status execute(CommandBuffer *command_buffer,
+                       core::LinearAllocator *frame_allocator) override {
+    LANCE_PROFILE_ZONE("ComputePass::execute");
+
+    return record(command_buffer);
+  }
+
+  absl::Status execute_secondary(CommandBuffer *command_buffer,
+                                 core::LinearAllocator *frame_allocator,
+                                 VkRenderPassBeginInfo *render_pass_begin_info) override {
+    LANCE_PROFILE_ZONE("ComputePass::execute_secondary");
+
+    render_pass_begin_info->renderPass = VK_NULL_HANDLE;
+
+    VkCommandBufferInheritanceInfo inheritance_info = {};
+    inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    LANCE_RETURN_IF_FAILED(command_buffer->begin(0, &inheritance_info));
+    LANCE_RETURN_IF_FAILED(record(command_buffer));
+    return command_buffer->end();
+  }
+
+  std::string_view name() const override { return "ComputePass"; }
+
+ private:
+  absl::Status record(CommandBuffer *command_buffer) {
     VkApi::get()->vkCmdBindPipeline(command_buffer->vk_command_buffer(),
                                     VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_->vk_pipeline());
 
@@ -165,9 +212,6 @@ class ComputePass : public Pass {
     return execute_fn_(&ctx);
   }
 
-  std::string_view name() const override { return "ComputePass"; }
-
- private:
   const std::function<absl::Status(Context *)> execute_fn_;
   core::RefCountPtr<PipelineLayout> pipeline_layout_;
   core::RefCountPtr<Pipeline> pipeline_;
@@ -210,7 +254,7 @@ class PassBuilderImpl : public ComputePassBuilder {
   }
 
   absl::StatusOr<core::RefCountPtr<PipelineLayout>> create_pipeline_layout() const {
-    std::vector<VkDescriptorSetLayout> set_layouts;
+    core::SmallVector<VkDescriptorSetLayout> set_layouts;
     set_layouts.resize(descriptor_set_layouts_.size(), VK_NULL_HANDLE);
     for (const auto &pair : descriptor_set_layouts_) {
       if (pair.first >= descriptor_set_layouts_.size()) {
@@ -251,7 +295,8 @@ class PassBuilderImpl : public ComputePassBuilder {
 
     VkPipeline vk_pipeline;
     VK_RETURN_IF_FAILED(VkApi::get()->vkCreateComputePipelines(
-        device_->vk_device(), VK_NULL_HANDLE, 1, &pipeline_create_info, nullptr, &vk_pipeline));
+        device_->vk_device(), device_->pipeline_cache()->vk_pipeline_cache(), 1,
+        &pipeline_create_info, nullptr, &vk_pipeline));
 
     return core::make_refcounted<Pipeline>(device_, vk_pipeline, pipeline_layout);
   }
@@ -271,11 +316,11 @@ class PassBuilderImpl : public ComputePassBuilder {
 
  private:
   core::RefCountPtr<Device> device_;
-  std::unordered_map<VkShaderStageFlagBits, core::RefCountPtr<ShaderModule>> shader_modules_;
+  core::SmallFlatMap<VkShaderStageFlagBits, core::RefCountPtr<ShaderModule>> shader_modules_;
 
-  std::unordered_map<uint32_t, core::RefCountPtr<DescriptorSetLayout>> descriptor_set_layouts_;
+  core::SmallFlatMap<uint32_t, core::RefCountPtr<DescriptorSetLayout>> descriptor_set_layouts_;
 
-  std::unordered_map<uint32_t, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding>>
+  core::SmallFlatMap<uint32_t, core::SmallFlatMap<uint32_t, VkDescriptorSetLayoutBinding>>
       buffer_descriptors_;
 
   VkCullModeFlags cull_mode_ = VK_CULL_MODE_NONE;
@@ -324,11 +369,12 @@ class GraphicsPassBuilderImpl : public GraphicsPassBuilder {
     auto st = image->add_usage(VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
     CHECK(st.ok()) << "err_msg: " << st.ToString();
 
-    color_attachments[location].image = image;
-    color_attachments[location].description = builder;
+    auto &attachment = color_attachments[location];
+    attachment.image = image;
+    attachment.description = builder;
 
     if (render_area) {
-      color_attachments[location].render_area = std::make_unique<VkRect2D>(*render_area);
+      attachment.render_area = std::make_unique<VkRect2D>(*render_area);
     }
 
     LOG(INFO) << "[GraphicsBuilder::add_color_attachment] resource_id: " << image->id();
@@ -427,7 +473,7 @@ class GraphicsPassBuilderImpl : public GraphicsPassBuilder {
   }
 
   absl::StatusOr<core::RefCountPtr<PipelineLayout>> create_pipeline_layout() const {
-    std::vector<VkDescriptorSetLayout> set_layouts;
+    core::SmallVector<VkDescriptorSetLayout> set_layouts;
     set_layouts.resize(descriptor_set_layouts.size(), VK_NULL_HANDLE);
     for (const auto &pair : descriptor_set_layouts) {
       CHECK_EQ(set_layouts[pair.first], VK_NULL_HANDLE);
@@ -450,9 +496,9 @@ class GraphicsPassBuilderImpl : public GraphicsPassBuilder {
     return core::make_refcounted<PipelineLayout>(device, vk_pipeline_layout);
   }
 
-  absl::StatusOr<std::vector<VkPipelineColorBlendAttachmentState>>
+  absl::StatusOr<core::SmallVector<VkPipelineColorBlendAttachmentState>>
   create_color_blend_attachment_states() const {
-    std::vector<VkPipelineColorBlendAttachmentState> states;
+    core::SmallVector<VkPipelineColorBlendAttachmentState> states;
     for (const auto &color : color_attachments) {
       VkPipelineColorBlendAttachmentState state = {};
       state.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
@@ -470,7 +516,7 @@ class GraphicsPassBuilderImpl : public GraphicsPassBuilder {
       const core::RefCountPtr<RenderPass> &render_pass, uint32_t subpass) const {
     VLOG(10) << "[create_pipeline]";
 
-    std::vector<VkPipelineShaderStageCreateInfo> shader_stage_create_infos = {};
+    core::SmallVector<VkPipelineShaderStageCreateInfo> shader_stage_create_infos;
     for (const auto &pair : shader_modules) {
       VkPipelineShaderStageCreateInfo shader_stage_create_info = {};
       shader_stage_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -480,7 +526,7 @@ class GraphicsPassBuilderImpl : public GraphicsPassBuilder {
       shader_stage_create_infos.push_back(shader_stage_create_info);
     }
 
-    std::vector<VkDynamicState> dynamic_states;
+    core::SmallVector<VkDynamicState> dynamic_states;
 
     VkGraphicsPipelineCreateInfo graphics_pipeline_create_info = {};
     graphics_pipeline_create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
@@ -513,7 +559,7 @@ class GraphicsPassBuilderImpl : public GraphicsPassBuilder {
     VkPipelineViewportStateCreateInfo viewport_state = {};
     viewport_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
 
-    std::vector<VkViewport> viewports;
+    core::SmallVector<VkViewport, 1> viewports;
     if (viewport) {
       viewports.push_back(*viewport);
     } else {
@@ -522,7 +568,7 @@ class GraphicsPassBuilderImpl : public GraphicsPassBuilder {
     viewport_state.viewportCount = viewports.empty() ? 1 : viewports.size();
     viewport_state.pViewports = viewports.data();
 
-    std::vector<VkRect2D> scissors;
+    core::SmallVector<VkRect2D, 1> scissors;
     if (scissor) {
       scissors.push_back(*scissor);
     } else {
@@ -602,9 +648,9 @@ class GraphicsPassBuilderImpl : public GraphicsPassBuilder {
     graphics_pipeline_create_info.basePipelineIndex = -1;
 
     VkPipeline vk_pipeline{VK_NULL_HANDLE};
-    VK_RETURN_IF_FAILED(VkApi::get()->vkCreateGraphicsPipelines(device->vk_device(), VK_NULL_HANDLE,
-                                                                1, &graphics_pipeline_create_info,
-                                                                nullptr, &vk_pipeline));
+    VK_RETURN_IF_FAILED(VkApi::get()->vkCreateGraphicsPipelines(
+        device->vk_device(), device->pipeline_cache()->vk_pipeline_cache(), 1,
+        &graphics_pipeline_create_info, nullptr, &vk_pipeline));
 
     VLOG(10) << "[create_pipeline] complete";
 
@@ -628,8 +674,8 @@ class GraphicsPassBuilderImpl : public GraphicsPassBuilder {
 
   const core::RefCountPtr<Device> device;
 
-  std::vector<VkVertexInputBindingDescription> vertex_input_bindings;
-  std::vector<VkVertexInputAttributeDescription> vertex_input_attributes;
+  core::SmallVector<VkVertexInputBindingDescription> vertex_input_bindings;
+  core::SmallVector<VkVertexInputAttributeDescription> vertex_input_attributes;
 
   VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 
@@ -640,7 +686,7 @@ class GraphicsPassBuilderImpl : public GraphicsPassBuilder {
 
     std::unique_ptr<VkRect2D> render_area;
   };
-  std::unordered_map<int32_t, ColorAttachment> color_attachments;
+  core::SmallFlatMap<int32_t, ColorAttachment> color_attachments;
 
   struct DepthStencilAttachment {
     int32_t id = -1;
@@ -662,9 +708,9 @@ class GraphicsPassBuilderImpl : public GraphicsPassBuilder {
 
   std::array<float, 4> blend_constants = {1, 1, 1, 1};
 
-  std::unordered_map<uint32_t, core::RefCountPtr<DescriptorSetLayout>> descriptor_set_layouts;
-  std::vector<VkPushConstantRange> push_constants;
-  std::unordered_map<VkShaderStageFlagBits, core::RefCountPtr<ShaderModule>> shader_modules;
+  core::SmallFlatMap<uint32_t, core::RefCountPtr<DescriptorSetLayout>> descriptor_set_layouts;
+  core::SmallVector<VkPushConstantRange> push_constants;
+  core::SmallFlatMap<VkShaderStageFlagBits, core::RefCountPtr<ShaderModule>> shader_modules;
 };
 
 class GraphicsPass : public Pass {
@@ -674,6 +720,8 @@ class GraphicsPass : public Pass {
       : builder_(std::move(builder)), execute_fn_(std::move(execute_fn)) {}
 
   absl::Status compile(Device *device) override {
+    LANCE_PROFILE_ZONE("GraphicsPass::compile");
+
     device_.reset(device);
 
     LANCE_RETURN_IF_FAILED(create_render_pass());
@@ -689,7 +737,49 @@ class GraphicsPass : public Pass {
     return absl::OkStatus();
   }
 
-  absl::Status execute(CommandBuffer *command_buffer) override {
+  absl::Status execute(CommandBuffer *command_buffer,
+                       core::LinearAllocator *frame_allocator) override {
+    LANCE_PROFILE_ZONE("GraphicsPass::execute");
+
+    VkRenderPassBeginInfo render_pass_begin_info;
+    LANCE_RETURN_IF_FAILED(
+        create_framebuffer(command_buffer, frame_allocator, &render_pass_begin_info));
+
+    VkApi::get()->vkCmdBeginRenderPass(command_buffer->vk_command_buffer(), &render_pass_begin_info,
+                                       VK_SUBPASS_CONTENTS_INLINE);
+
+    LANCE_RETURN_IF_FAILED(record(command_buffer));
+
+    VkApi::get()->vkCmdEndRenderPass(command_buffer->vk_command_buffer());
+
+    return absl::OkStatus();
+  }
+
+  absl::Status execute_secondary(CommandBuffer *command_buffer,
+                                 core::LinearAllocator *frame_allocator,
+                                 VkRenderPassBeginInfo *render_pass_begin_info) override {
+    LANCE_PROFILE_ZONE("GraphicsPass::execute_secondary");
+
+    // the secondary command buffer keeps the framebuffer alive
+    LANCE_RETURN_IF_FAILED(
+        create_framebuffer(command_buffer, frame_allocator, render_pass_begin_info));
+
+    VkCommandBufferInheritanceInfo inheritance_info = {};
+    inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance_info.renderPass = render_pass_begin_info->renderPass;
+    inheritance_info.subpass = 0;
+    inheritance_info.framebuffer = render_pass_begin_info->framebuffer;
+    LANCE_RETURN_IF_FAILED(
+        command_buffer->begin(VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT, &inheritance_info));
+    LANCE_RETURN_IF_FAILED(record(command_buffer));
+    return command_buffer->end();
+  }
+
+  std::string_view name() const override { return "GraphicsPass"; }
+
+ private:
+  // the commands inside the render pass
+  absl::Status record(CommandBuffer *command_buffer) {
     class GraphicsContext : public Context {
      public:
       GraphicsContext(GraphicsPass *pass, CommandBuffer *command_buffer)
@@ -708,21 +798,12 @@ class GraphicsPass : public Pass {
 
     GraphicsContext ctx(this, command_buffer);
 
-    LANCE_RETURN_IF_FAILED(begin_render_pass(command_buffer));
-
     VkApi::get()->vkCmdBindPipeline(command_buffer->vk_command_buffer(),
                                     VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_->vk_pipeline());
 
-    LANCE_RETURN_IF_FAILED(execute_fn_(&ctx));
-
-    VkApi::get()->vkCmdEndRenderPass(command_buffer->vk_command_buffer());
-
-    return absl::OkStatus();
+    return execute_fn_(&ctx);
   }
 
-  std::string_view name() const override { return "GraphicsPass"; }
-
- private:
   absl::Status create_render_pass() {
     attachment_count_ = builder_->color_attachments.size();
     if (builder_->depth_stencil_attachment) {
@@ -732,7 +813,7 @@ class GraphicsPass : public Pass {
     // create render pass
     //
     // prepare attachment descriptions
-    std::vector<VkAttachmentDescription> attachment_descriptions;
+    core::SmallVector<VkAttachmentDescription> attachment_descriptions;
     attachment_descriptions.resize(attachment_count_);
 
     for (const auto &pair : builder_->color_attachments) {
@@ -743,7 +824,7 @@ class GraphicsPass : public Pass {
     }
 
     // prepare color attachment references
-    std::vector<VkAttachmentReference> color_attachment_references;
+    core::SmallVector<VkAttachmentReference> color_attachment_references;
 
     for (const auto &pair : builder_->color_attachments) {
       VkAttachmentReference t;
@@ -768,7 +849,7 @@ class GraphicsPass : public Pass {
     }
     subpass_description.preserveAttachmentCount = 0;
 
-    std::vector<VkSubpassDependency> subpass_dependencies;
+    core::SmallVector<VkSubpassDependency> subpass_dependencies;
 
     VkRenderPassCreateInfo render_pass_create_info = {};
     render_pass_create_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
@@ -826,19 +907,21 @@ class GraphicsPass : public Pass {
     return absl::OkStatus();
   }
 
-  absl::Status begin_render_pass(CommandBuffer *command_buffer) {
-    std::vector<VkClearValue> clear_values;
-    std::vector<VkImageView> image_views;
-
-    clear_values.resize(attachment_count_);
-    image_views.resize(attachment_count_);
+  // the framebuffer is kept alive by `command_buffer`, the clear values live in `frame_allocator`
+  absl::Status create_framebuffer(CommandBuffer *command_buffer,
+                                  core::LinearAllocator *frame_allocator,
+                                  VkRenderPassBeginInfo *render_pass_begin_info) {
+    // read when the render pass begins, after this returns
+    VkClearValue *clear_values = frame_allocator->allocate_array<VkClearValue>(attachment_count_);
+    std::fill_n(clear_values, attachment_count_, VkClearValue{});
+    auto image_views = core::make_frame_vector<VkImageView>(frame_allocator, attachment_count_);
 
     for (const auto &pair : builder_->color_attachments) {
       clear_values[pair.first] = pair.second.description.clear_value;
       image_views[pair.first] = pair.second.image->image_view();
     }
 
-    VLOG(10) << "[begin_render_pass] clear_values: "
+    VLOG(10) << "[create_framebuffer] clear_values: "
              << ", attachment_count: " << attachment_count_;
 
     VkFramebufferCreateInfo framebuffer_create_info = {};
@@ -858,16 +941,13 @@ class GraphicsPass : public Pass {
 
     LANCE_RETURN_IF_FAILED(command_buffer->add_temporary_resource(framebuffer));
 
-    VkRenderPassBeginInfo render_pass_begin_info = {};
-    render_pass_begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    render_pass_begin_info.renderPass = render_pass_->vk_render_pass();
-    render_pass_begin_info.framebuffer = vk_framebuffer;
-    render_pass_begin_info.renderArea = render_area_;
-    render_pass_begin_info.clearValueCount = clear_values.size();
-    render_pass_begin_info.pClearValues = clear_values.data();
-
-    VkApi::get()->vkCmdBeginRenderPass(command_buffer->vk_command_buffer(), &render_pass_begin_info,
-                                       VK_SUBPASS_CONTENTS_INLINE);
+    *render_pass_begin_info = {};
+    render_pass_begin_info->sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    render_pass_begin_info->renderPass = render_pass_->vk_render_pass();
+    render_pass_begin_info->framebuffer = vk_framebuffer;
+    render_pass_begin_info->renderArea = render_area_;
+    render_pass_begin_info->clearValueCount = attachment_count_;
+    render_pass_begin_info->pClearValues = clear_values;
 
     return absl::OkStatus();
   }
@@ -886,26 +966,78 @@ class GraphicsPass : public Pass {
   core::RefCountPtr<PipelineLayout> pipeline_layout_;
 };
 
+// the secondary command buffers of one parallel execute. the primary command buffer references
+// it until it is recorded again, the graph reuses it afterwards.
+class ParallelRecording : public core::Inherit<ParallelRecording, core::Object> {
+ public:
+  // a job records consecutive passes into its own pool, no other thread touches it
+  struct Job {
+    core::RefCountPtr<CommandPool> command_pool;
+    // allocated once, reused after every pool reset
+    std::vector<core::RefCountPtr<CommandBuffer>> command_buffers;
+    core::LinearAllocator frame_allocator;
+  };
+
+  struct RecordedPass {
+    CommandBuffer *command_buffer = nullptr;
+    VkRenderPassBeginInfo render_pass_begin_info = {};
+    absl::Status status;
+  };
+
+  explicit ParallelRecording(uint32_t queue_family_index)
+      : queue_family_index(queue_family_index) {}
+
+  const uint32_t queue_family_index;
+  // set once the gpu is done with the primary command buffer that executed it
+  std::shared_ptr<std::atomic_bool> available = std::make_shared<std::atomic_bool>(true);
+  std::vector<std::unique_ptr<Job>> jobs;
+  // indexed like the graph's passes
+  std::vector<RecordedPass> passes;
+};
+
+// a temporary resource of the primary command buffer that executed a recording. the primary
+// releases it when it is recorded again, or when it is destroyed, possibly with the submission
+// still pending. the recording becomes available once every submission made by then completed.
+class ParallelRecordingLease : public core::Inherit<ParallelRecordingLease, core::Object> {
+ public:
+  ParallelRecordingLease(core::RefCountPtr<Device> device,
+                         std::shared_ptr<std::atomic_bool> available)
+      : device_(device), available_(std::move(available)) {}
+
+  ~ParallelRecordingLease() override {
+    // no reference to the device is deferred, nor to the recording that holds its pools
+    device_->destroy_deferred([available = std::move(available_)]() { available->store(true); });
+  }
+
+ private:
+  core::RefCountPtr<Device> device_;
+  std::shared_ptr<std::atomic_bool> available_;
+};
+
 class RenderGraphImpl : public core::Inherit<RenderGraphImpl, RenderGraph> {
  public:
   explicit RenderGraphImpl(core::RefCountPtr<Device> device) : device_(device) {}
 
-  absl::StatusOr<int32_t> import_resource(
-      const std::string &name, const core::RefCountPtr<RenderGraphResource> &resource) override {
-    return absl::OkStatus();
+  absl::StatusOr<ResourceHandle> import_resource(
+      core::InternedString name, const core::RefCountPtr<RenderGraphResource> &resource) override {
+    LANCE_ASSIGN_OR_RETURN(handle, add_resource(name, resource, true));
+
+    VLOG(10) << "import resource, name: " << name << ", index: " << handle.index();
+
+    return handle;
   }
 
-  absl::StatusOr<int32_t> create_resource(const std::string &name) override {
-    return absl::OkStatus();
+  absl::StatusOr<ResourceHandle> create_resource(core::InternedString name) override {
+    return absl::UnimplementedError("create_resource");
   }
 
-  absl::StatusOr<core::RefCountPtr<RenderGraphImage>> create_texture2d(const std::string &name,
+  absl::StatusOr<core::RefCountPtr<RenderGraphImage>> create_texture2d(core::InternedString name,
                                                                        VkFormat format,
                                                                        VkExtent2D extent) override {
     auto texture2d = core::make_refcounted<RenderGraphTexture2D>(
         static_cast<int32_t>(resources_.size()), format, extent);
 
-    resources_[texture2d->id()] = texture2d;
+    LANCE_RETURN_IF_FAILED(add_resource(name, texture2d, false).status());
 
     VLOG(10) << "create texture2d, name: " << name << ", extent: (" << extent.width << ","
              << extent.height << ")";
@@ -934,66 +1066,268 @@ class RenderGraphImpl : public core::Inherit<RenderGraphImpl, RenderGraph> {
     return absl::OkStatus();
   }
 
-  absl::Status add_compute_pass(std::string name,
-                                std::function<absl::Status(ComputePassBuilder *)> setup_fn,
-                                std::function<absl::Status(Context *)> execute_fn) override {
+  absl::StatusOr<PassHandle> add_compute_pass(
+      core::InternedString name, std::function<absl::Status(ComputePassBuilder *)> setup_fn,
+      std::function<absl::Status(Context *)> execute_fn) override {
+    LANCE_RETURN_IF_FAILED(check_pass_name(name));
+
     PassBuilderImpl builder(device_);
     LANCE_RETURN_IF_FAILED(setup_fn(&builder));
 
     LANCE_ASSIGN_OR_RETURN(pass, builder.create_pass(std::move(execute_fn)));
 
-    passes_.push_back(std::move(pass));
-
-    return absl::OkStatus();
+    return add_pass(name, std::move(pass));
   }
 
-  absl::Status add_graphics_pass(std::string_view name,
-                                 std::function<absl::Status(GraphicsPassBuilder *)> setup_fn,
-                                 std::function<absl::Status(Context *)> execute_fn) override {
+  absl::StatusOr<PassHandle> add_graphics_pass(
+      core::InternedString name, std::function<absl::Status(GraphicsPassBuilder *)> setup_fn,
+      std::function<absl::Status(Context *)> execute_fn) override {
+    LANCE_RETURN_IF_FAILED(check_pass_name(name));
+
     auto builder = std::make_unique<GraphicsPassBuilderImpl>(this, device_);
     LANCE_RETURN_IF_FAILED(setup_fn(builder.get()));
 
     auto graphics_pass = std::make_unique<GraphicsPass>(std::move(builder), std::move(execute_fn));
 
-    passes_.push_back(std::move(graphics_pass));
+    return add_pass(name, std::move(graphics_pass));
+  }
 
-    return absl::OkStatus();
+  ResourceHandle find_resource(core::InternedString name) const override {
+    auto it = resource_indices_.find(name);
+    return it == resource_indices_.end() ? ResourceHandle() : ResourceHandle(it->second);
+  }
+
+  PassHandle find_pass(core::InternedString name) const override {
+    auto it = pass_indices_.find(name);
+    return it == pass_indices_.end() ? PassHandle() : PassHandle(it->second);
+  }
+
+  core::InternedString resource_name(ResourceHandle handle) const override {
+    return handle.index() < resources_.size() ? resources_[handle.index()].name
+                                              : core::InternedString();
+  }
+
+  core::InternedString pass_name(PassHandle handle) const override {
+    return handle.index() < passes_.size() ? passes_[handle.index()].name : core::InternedString();
   }
 
   absl::Status compile(const CompileOptions *options) override {
-    // setup resource
-    for (auto &pair : resources_) {
-      LANCE_RETURN_IF_FAILED(pair.second->initialize(device_.get()));
+    LANCE_PROFILE_ZONE("RenderGraph::compile");
+
+    // setup resource, imported ones are initialized by their owner
+    for (auto &entry : resources_) {
+      if (!entry.imported) {
+        LANCE_RETURN_IF_FAILED(entry.resource->initialize(device_.get()));
+      }
     }
 
     // compile passes
-    for (const auto &pass : passes_) {
-      LANCE_RETURN_IF_FAILED(pass->compile(device_.get()));
+    for (const auto &entry : passes_) {
+      LANCE_RETURN_IF_FAILED(entry.pass->compile(device_.get()));
     }
 
     return absl::OkStatus();
   }
 
-  absl::Status execute(
-      CommandBuffer *command_buffer,
-      absl::Span<const std::pair<std::string, core::RefCountPtr<RenderGraphResource>>> inputs)
-      override {
-    for (auto &pass : passes_) {
-      VLOG(1) << "[execute] pass: " << pass->name();
+  absl::Status execute(CommandBuffer *command_buffer, const ExecuteOptions *options) override {
+    LANCE_PROFILE_ZONE("RenderGraph::execute");
 
-      LANCE_RETURN_IF_FAILED(pass->execute(command_buffer));
+    if (options && options->job_system) {
+      return execute_parallel(command_buffer, *options);
+    }
+
+    // nothing recorded by the previous execute is referenced any more
+    frame_allocator_.reset();
+
+    for (auto &entry : passes_) {
+      VLOG(1) << "[execute] pass: " << entry.name << ", kind: " << entry.pass->name();
+
+      LANCE_RETURN_IF_FAILED(entry.pass->execute(command_buffer, &frame_allocator_));
     }
 
     return absl::OkStatus();
   }
 
  private:
-  std::unordered_map<int64_t, core::RefCountPtr<RenderGraphResource>> resources_;
+  struct ResourceEntry {
+    core::InternedString name;
+    core::RefCountPtr<RenderGraphResource> resource;
+    bool imported = false;
+  };
+
+  struct PassEntry {
+    core::InternedString name;
+    std::unique_ptr<Pass> pass;
+  };
+
+  absl::Status execute_parallel(CommandBuffer *command_buffer, const ExecuteOptions &options) {
+    if (passes_.empty()) {
+      return absl::OkStatus();
+    }
+
+    core::JobSystem *job_system = options.job_system;
+    const size_t pass_count = passes_.size();
+    const size_t threads = job_system->num_workers() + 1;
+    const size_t passes_per_job =
+        options.passes_per_job != 0 ? options.passes_per_job : (pass_count + threads - 1) / threads;
+    const size_t job_count = (pass_count + passes_per_job - 1) / passes_per_job;
+
+    const uint32_t queue_family_index = command_buffer->command_pool()->queue_family_index();
+    LANCE_ASSIGN_OR_RETURN(recording, acquire_parallel_recording(queue_family_index, job_count));
+    LANCE_RETURN_IF_FAILED(command_buffer->add_temporary_resource(
+        core::make_refcounted<ParallelRecordingLease>(device_, recording->available)));
+    recording->passes.resize(pass_count);
+
+    // chunks start at multiples of passes_per_job, one chunk per job
+    job_system->parallel_for(0, pass_count, passes_per_job, [&](size_t begin, size_t end) {
+      auto &job = *recording->jobs[begin / passes_per_job];
+      for (size_t i = begin; i < end; ++i) {
+        recording->passes[i].status = record_secondary(&job, i - begin, i, recording.get());
+      }
+    });
+
+    // stitch in graph order, consecutive passes outside of render passes in one call
+    const VkCommandBuffer vk_command_buffer = command_buffer->vk_command_buffer();
+    core::SmallVector<VkCommandBuffer, 16> secondaries;
+    const auto flush_secondaries = [&]() {
+      if (!secondaries.empty()) {
+        VkApi::get()->vkCmdExecuteCommands(vk_command_buffer, secondaries.size(),
+                                           secondaries.data());
+        secondaries.clear();
+      }
+    };
+
+    for (const auto &pass : recording->passes) {
+      LANCE_RETURN_IF_FAILED(pass.status);
+
+      const VkCommandBuffer secondary = pass.command_buffer->vk_command_buffer();
+      if (pass.render_pass_begin_info.renderPass == VK_NULL_HANDLE) {
+        secondaries.push_back(secondary);
+        continue;
+      }
+
+      flush_secondaries();
+      VkApi::get()->vkCmdBeginRenderPass(vk_command_buffer, &pass.render_pass_begin_info,
+                                         VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+      VkApi::get()->vkCmdExecuteCommands(vk_command_buffer, 1, &secondary);
+      VkApi::get()->vkCmdEndRenderPass(vk_command_buffer);
+    }
+    flush_secondaries();
+
+    VLOG(1) << "[execute_parallel] passes: " << pass_count << ", jobs: " << job_count;
+
+    return absl::OkStatus();
+  }
+
+  // runs on a job system thread, `job` is not shared with other threads
+  absl::Status record_secondary(ParallelRecording::Job *job, size_t command_buffer_index,
+                                size_t pass_index, ParallelRecording *recording) {
+    if (command_buffer_index == job->command_buffers.size()) {
+      LANCE_ASSIGN_OR_RETURN(
+          secondary, job->command_pool->allocate_command_buffer(VK_COMMAND_BUFFER_LEVEL_SECONDARY));
+      job->command_buffers.push_back(secondary);
+    }
+
+    auto &entry = passes_[pass_index];
+    VLOG(1) << "[execute] pass: " << entry.name << ", kind: " << entry.pass->name();
+
+    auto &recorded = recording->passes[pass_index];
+    recorded.command_buffer = job->command_buffers[command_buffer_index].get();
+    return entry.pass->execute_secondary(recorded.command_buffer, &job->frame_allocator,
+                                         &recorded.render_pass_begin_info);
+  }
+
+  // a recording the gpu is done with, with `job_count` reset jobs
+  absl::StatusOr<core::RefCountPtr<ParallelRecording>> acquire_parallel_recording(
+      uint32_t queue_family_index, size_t job_count) {
+    const auto find_available = [&]() {
+      core::RefCountPtr<ParallelRecording> recording;
+      for (const auto &candidate : parallel_recordings_) {
+        if (candidate->queue_family_index == queue_family_index && candidate->available->load()) {
+          recording = candidate;
+          break;
+        }
+      }
+      return recording;
+    };
+
+    auto recording = find_available();
+    if (recording.get() == nullptr) {
+      // leases released since the last poll may have completed
+      LANCE_RETURN_IF_FAILED(device_->poll());
+      recording = find_available();
+    }
+
+    if (recording.get() == nullptr) {
+      recording = core::make_refcounted<ParallelRecording>(queue_family_index);
+      parallel_recordings_.push_back(recording);
+    }
+    recording->available->store(false);
+
+    while (recording->jobs.size() < job_count) {
+      auto job = std::make_unique<ParallelRecording::Job>();
+      LANCE_ASSIGN_OR_RETURN(command_pool, CommandPool::create(device_, queue_family_index));
+      job->command_pool = command_pool;
+      recording->jobs.push_back(std::move(job));
+    }
+
+    // the primary command buffer that executed it completed, so did its secondaries
+    for (size_t i = 0; i < job_count; ++i) {
+      LANCE_RETURN_IF_FAILED(recording->jobs[i]->command_pool->reset());
+      recording->jobs[i]->frame_allocator.reset();
+    }
+
+    return recording;
+  }
+
+  // unnamed resources and passes can only be reached through their handles
+  absl::StatusOr<ResourceHandle> add_resource(core::InternedString name,
+                                              core::RefCountPtr<RenderGraphResource> resource,
+                                              bool imported) {
+    const auto index = static_cast<uint32_t>(resources_.size());
+    if (!name.empty() && !resource_indices_.emplace(name, index).second) {
+      return absl::AlreadyExistsError(absl::StrFormat("resource: %s", name.str()));
+    }
+
+    resources_.push_back(ResourceEntry{name, std::move(resource), imported});
+
+    return ResourceHandle(index);
+  }
+
+  absl::Status check_pass_name(core::InternedString name) const {
+    if (!name.empty() && pass_indices_.count(name) != 0) {
+      return absl::AlreadyExistsError(absl::StrFormat("pass: %s", name.str()));
+    }
+
+    return absl::OkStatus();
+  }
+
+  PassHandle add_pass(core::InternedString name, std::unique_ptr<Pass> pass) {
+    const auto index = static_cast<uint32_t>(passes_.size());
+    if (!name.empty()) {
+      pass_indices_.emplace(name, index);
+    }
+
+    passes_.push_back(PassEntry{name, std::move(pass)});
+
+    return PassHandle(index);
+  }
+
+  // indexed by handle
+  std::vector<ResourceEntry> resources_;
+  std::unordered_map<core::InternedString, uint32_t> resource_indices_;
 
   // device for create resource
   core::RefCountPtr<Device> device_;
 
-  std::vector<std::unique_ptr<Pass>> passes_;
+  std::vector<PassEntry> passes_;
+  std::unordered_map<core::InternedString, uint32_t> pass_indices_;
+
+  // transient cpu data of the execute in flight
+  core::LinearAllocator frame_allocator_;
+
+  // reused once their primary command buffer released them
+  std::vector<core::RefCountPtr<ParallelRecording>> parallel_recordings_;
 };
 
 }  // namespace
@@ -1,12 +1,40 @@
 #pragma once
 
+#include <limits>
+
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
 #include "device.h"
+#include "lance/core/interned_string.h"
+#include "lance/core/job_system.h"
 #include "lance/core/object.h"
 
 namespace lance {
 namespace rendering {
+// index of a resource or pass in its render graph. the tag keeps resource and pass handles apart.
+template <typename Tag>
+class Handle {
+ public:
+  static constexpr uint32_t kInvalidIndex = std::numeric_limits<uint32_t>::max();
+
+  Handle() = default;
+
+  explicit Handle(uint32_t index) : index_(index) {}
+
+  uint32_t index() const { return index_; }
+
+  bool valid() const { return index_ != kInvalidIndex; }
+
+  friend bool operator==(Handle a, Handle b) { return a.index_ == b.index_; }
+  friend bool operator!=(Handle a, Handle b) { return a.index_ != b.index_; }
+
+ private:
+  uint32_t index_ = kInvalidIndex;
+};
+
+using ResourceHandle = Handle<struct ResourceHandleTag>;
+using PassHandle = Handle<struct PassHandleTag>;
+
 class RenderGraphResource : public core::Inherit<RenderGraphResource, core::Object> {
  public:
   virtual absl::Status initialize(Device* device) = 0;
@@ -242,26 +270,38 @@ class IPass : public core::Inherit<IPass, core::Object> {
   virtual absl::Status execute(Context* ctx) = 0;
 };
 
+// names are interned when a resource or pass is added, afterwards everything is addressed by
+// handle. look names up once at setup, not per frame.
 class RenderGraph : public core::Inherit<RenderGraph, core::Object> {
  public:
-  virtual absl::StatusOr<int32_t> import_resource(
-      const std::string& name, const core::RefCountPtr<RenderGraphResource>& resource) = 0;
+  // `resource` is initialized by its owner
+  virtual absl::StatusOr<ResourceHandle> import_resource(
+      core::InternedString name, const core::RefCountPtr<RenderGraphResource>& resource) = 0;
 
-  virtual absl::StatusOr<int32_t> create_resource(const std::string& name) = 0;
+  virtual absl::StatusOr<ResourceHandle> create_resource(core::InternedString name) = 0;
+
+  // the image's id() is the index of its handle
   virtual absl::StatusOr<core::RefCountPtr<RenderGraphImage>> create_texture2d(
-      const std::string& name, VkFormat format, VkExtent2D extent) = 0;
+      core::InternedString name, VkFormat format, VkExtent2D extent) = 0;
 
   virtual absl::StatusOr<std::string> create_attachment(VkImageType image_type, VkFormat format,
                                                         VkImageUsageFlags usage,
                                                         VkExtent3D extent) = 0;
 
-  virtual absl::Status add_compute_pass(std::string name,
-                                        std::function<absl::Status(ComputePassBuilder*)> setup_fn,
-                                        std::function<absl::Status(Context* ctx)> execute_fn) = 0;
+  virtual absl::StatusOr<PassHandle> add_compute_pass(
+      core::InternedString name, std::function<absl::Status(ComputePassBuilder*)> setup_fn,
+      std::function<absl::Status(Context* ctx)> execute_fn) = 0;
+
+  virtual absl::StatusOr<PassHandle> add_graphics_pass(
+      core::InternedString name, std::function<absl::Status(GraphicsPassBuilder*)> setup_fn,
+      std::function<absl::Status(Context*)> execute_fn) = 0;
 
-  virtual absl::Status add_graphics_pass(std::string_view name,
-                                         std::function<absl::Status(GraphicsPassBuilder*)> setup_fn,
-                                         std::function<absl::Status(Context*)> execute_fn) = 0;
+  // invalid handles if there is no such name
+  virtual ResourceHandle find_resource(core::InternedString name) const = 0;
+  virtual PassHandle find_pass(core::InternedString name) const = 0;
+
+  virtual core::InternedString resource_name(ResourceHandle handle) const = 0;
+  virtual core::InternedString pass_name(PassHandle handle) const = 0;
 
   struct CompileOptions {
     bool enable_pass_fusion = true;
@@ -269,9 +309,20 @@ class RenderGraph : public core::Inherit<RenderGraph, core::Object> {
 
   virtual absl::Status compile(const CompileOptions* options = nullptr) = 0;
 
-  virtual absl::Status execute(
-      CommandBuffer* command_buffer,
-      absl::Span<const std::pair<std::string, core::RefCountPtr<RenderGraphResource>>> inputs) = 0;
+  struct ExecuteOptions {
+    // records the passes into secondary command buffers on its threads, which the primary one
+    // executes in graph order. nullptr records them on the calling thread.
+    core::JobSystem* job_system = nullptr;
+
+    // consecutive passes recorded by one job into its own command pool, 0 gives every thread
+    // one job
+    uint32_t passes_per_job = 0;
+  };
+
+  // records the passes in graph order. the execute_fns of the passes run concurrently with a job
+  // system, and must only touch their own context.
+  virtual absl::Status execute(CommandBuffer* command_buffer,
+                               const ExecuteOptions* options = nullptr) = 0;
 };
 
 absl::StatusOr<core::RefCountPtr<RenderGraph>> create_render_graph(
@@ -0,0 +1,97 @@
+#include "device.h"
+#include "gtest/gtest.h"
+#include "lance/core/testing/allocation_counter.h"
+#include "render_graph.h"
+
+namespace lance {
+namespace rendering {
+TEST(render_graph, steady_state_execute_does_not_allocate) {
+  auto instance = Instance::create_for_3d().value();
+  auto device = instance->create_device_for_graphics().value();
+
+  const uint32_t graphics_queue_family_index =
+      device->find_queue_family_index(VK_QUEUE_GRAPHICS_BIT).value();
+
+  auto rg = create_render_graph(device).value();
+
+  auto color0 = rg->create_texture2d("color0", VK_FORMAT_R8G8B8A8_UNORM, {640, 480}).value();
+  auto color1 = rg->create_texture2d("color1", VK_FORMAT_R8G8B8A8_UNORM, {640, 480}).value();
+
+  auto pass = rg->add_graphics_pass(
+      "triangle",
+      [&](GraphicsPassBuilder* builder) -> absl::Status {
+        builder->set_shader_by_glsl(VK_SHADER_STAGE_VERTEX_BIT, R"glsl(
+#version 450 core
+
+vec2 positions[3] = {
+  vec2(0,0),
+  vec2(0,-1),
+  vec2(1,0),
+};
+
+void main() {
+  gl_Position = vec4(positions[gl_VertexIndex], 0, 1);
+}
+)glsl");
+
+        builder->set_shader_by_glsl(VK_SHADER_STAGE_FRAGMENT_BIT, R"glsl(
+#version 450 core
+
+layout(location = 0) out vec4 outColor0;
+layout(location = 1) out vec4 outColor1;
+
+void main() {
+  outColor0 = vec4(1,1,0,1);
+  outColor1 = vec4(0,1,1,1);
+}
+)glsl");
+
+        builder->add_color_attachment(
+            color0, 0, AttachmentDescription(color0.get()).clear_to({0.f, 0.f, 0.f, 1.f}));
+        builder->add_color_attachment(
+            color1, 1, AttachmentDescription(color1.get()).clear_to({0.f, 0.f, 0.f, 1.f}));
+
+        return absl::OkStatus();
+      },
+      [](Context* ctx) -> absl::Status {
+        ctx->set_viewport(0, {VkViewport{0, 0, 640.f, 480.f, 0.f, 1.f}});
+        ctx->set_scissors(0, {VkRect2D{{0, 0}, {640, 480}}});
+        ctx->draw(3, 1, 0, 0);
+
+        return absl::OkStatus();
+      });
+  LANCE_THROW_IF_FAILED(pass.status());
+
+  LANCE_THROW_IF_FAILED(rg->compile());
+
+  auto command_pool = CommandPool::create(device, graphics_queue_family_index).value();
+  auto command_buffer =
+      command_pool->allocate_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY).value();
+
+  // the first frames grow the frame allocator, the pools and the temporary resource list
+  constexpr int kWarmupFrames = 3;
+  constexpr int kFrames = 20;
+
+  uint64_t steady_state_allocations = 0;
+  for (int frame = 0; frame < kWarmupFrames + kFrames; ++frame) {
+    // submit() waited for the previous frame, the pool does not reset single command buffers
+    LANCE_THROW_IF_FAILED(command_pool->reset());
+    LANCE_THROW_IF_FAILED(command_buffer->begin());
+
+    const uint64_t before = core::heap_allocations();
+    LANCE_THROW_IF_FAILED(rg->execute(command_buffer.get()));
+    const uint64_t after = core::heap_allocations();
+
+    LANCE_THROW_IF_FAILED(command_buffer->end());
+    LANCE_THROW_IF_FAILED(
+        device->submit(graphics_queue_family_index, {command_buffer->vk_command_buffer()}));
+
+    if (frame >= kWarmupFrames) {
+      steady_state_allocations += after - before;
+    }
+  }
+
+  ASSERT_EQ(0, steady_state_allocations);
+}
+}  // namespace rendering
+}  // namespace lance
@@ -1,5 +1,10 @@
 #include "render_graph.h"
 
+#include <atomic>
+#include <mutex>
+#include <set>
+
+#include "absl/strings/str_format.h"
 #include "device.h"
 #include "glog/logging.h"
 #include "gtest/gtest.h"
@@ -76,7 +81,7 @@ void main() {
 
   LANCE_THROW_IF_FAILED(command_buffer->begin());
 
-  LANCE_THROW_IF_FAILED(rg->execute(command_buffer.get(), {}));
+  LANCE_THROW_IF_FAILED(rg->execute(command_buffer.get()));
 
   LANCE_THROW_IF_FAILED(command_buffer->end());
 
@@ -88,6 +93,24 @@ void main() {
   render_doc_end_capture();
 }
 
+TEST(render_graph, names_and_handles) {
+  auto rg = create_render_graph(test_device()).value();
+
+  auto color0 = rg->create_texture2d("color0", VK_FORMAT_R8G8B8A8_UNORM, {640, 480}).value();
+  ASSERT_EQ(absl::StatusCode::kAlreadyExists,
+            rg->create_texture2d("color0", VK_FORMAT_R8G8B8A8_UNORM, {640, 480}).status().code());
+
+  auto backbuffer = rg->import_resource("backbuffer", nullptr).value();
+
+  const ResourceHandle handle = rg->find_resource("color0");
+  ASSERT_TRUE(handle.valid());
+  ASSERT_EQ(static_cast<uint32_t>(color0->id()), handle.index());
+  ASSERT_EQ(backbuffer, rg->find_resource("backbuffer"));
+  ASSERT_EQ("backbuffer", rg->resource_name(backbuffer).str());
+  ASSERT_FALSE(rg->find_resource("missing").valid());
+  ASSERT_FALSE(rg->find_pass("missing").valid());
+}
+
 TEST(render_graph, graphics) {
   const uint32_t graphics_queue_family_index =
       test_device()->find_queue_family_index(VK_QUEUE_GRAPHICS_BIT).value();
@@ -96,7 +119,7 @@ TEST(render_graph, graphics) {
 
   auto color0 = rg->create_texture2d("color0", VK_FORMAT_R8G8B8A8_UNORM, {640, 480}).value();
 
-  LANCE_THROW_IF_FAILED(rg->add_graphics_pass(
+  auto pass = rg->add_graphics_pass(
       "clear",
       [&](GraphicsPassBuilder* builder) -> absl::Status {
         // input
@@ -131,7 +154,8 @@ void main() {
 
         return absl::OkStatus();
       },
-      [=](Context* ctx) -> absl::Status { return absl::OkStatus(); }));
+      [=](Context* ctx) -> absl::Status { return absl::OkStatus(); });
+  LANCE_THROW_IF_FAILED(pass.status());
 
   LANCE_THROW_IF_FAILED(rg->compile());
 }
@@ -144,7 +168,7 @@ TEST(render_graph, depth_test) {
 
   auto color0 = rg->create_texture2d("depth-buffer", VK_FORMAT_R8G8B8A8_SNORM, {640, 480}).value();
 
-  LANCE_THROW_IF_FAILED(rg->add_graphics_pass(
+  auto pass = rg->add_graphics_pass(
       "DepthPass",
       [color0](GraphicsPassBuilder* builder) -> absl::Status {
         builder->set_shader_by_glsl(VK_SHADER_STAGE_VERTEX_BIT, R"glsl(
@@ -186,7 +210,8 @@ void main() {
         ctx->draw(3, 1, 0, 0);
 
         return absl::OkStatus();
-      }));
+      });
+  LANCE_THROW_IF_FAILED(pass.status());
 
   LANCE_THROW_IF_FAILED(rg->compile());
 
@@ -197,7 +222,7 @@ void main() {
 
   LANCE_THROW_IF_FAILED(command_buffer->begin());
 
-  auto st_v1 = rg->execute(command_buffer.get(), {});
+  auto st_v1 = rg->execute(command_buffer.get());
 
   LANCE_THROW_IF_FAILED(command_buffer->end());
 
@@ -208,5 +233,94 @@ void main() {
 
   render_doc_end_capture();
 }
+
+TEST(render_graph, parallel_execute) {
+  auto graphics_queue_family_index =
+      test_device()->find_queue_family_index(VK_QUEUE_GRAPHICS_BIT).value();
+
+  auto rg = create_render_graph(test_device()).value();
+  auto color0 = rg->create_texture2d("color0", VK_FORMAT_R8G8B8A8_UNORM, {640, 480}).value();
+
+  std::atomic<int> executed{0};
+  // secondary command buffers the passes were recorded into, per frame
+  std::mutex mutex;
+  std::set<CommandBuffer*> secondaries[2];
+  int frame = 0;
+  for (int i = 0; i < 8; ++i) {
+    auto pass = rg->add_graphics_pass(
+        absl::StrFormat("Pass%d", i),
+        [color0](GraphicsPassBuilder* builder) -> absl::Status {
+          builder->set_shader_by_glsl(VK_SHADER_STAGE_VERTEX_BIT, R"glsl(
+#version 450 core
+
+void main() {
+  gl_Position = vec4(0, 0, 0, 1);
+}
+)glsl");
+
+          builder->set_shader_by_glsl(VK_SHADER_STAGE_FRAGMENT_BIT, R"glsl(
+#version 450 core
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+  outColor = vec4(1);
+}
+)glsl");
+
+          builder->add_color_attachment(
+              color0, 0,
+              AttachmentDescription(color0.get())
+                  .set_final_layout(VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
+                  .set_initial_layout(VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL));
+
+          return absl::OkStatus();
+        },
+        [&](Context* ctx) -> absl::Status {
+          ctx->set_viewport(0, {VkViewport{0, 0, 640.f, 480.f, 0.f, 1.f}});
+          ctx->set_scissors(0, {VkRect2D{{0, 0}, {640, 480}}});
+          ctx->draw(3, 1, 0, 0);
+          ++executed;
+
+          std::lock_guard<std::mutex> lock(mutex);
+          secondaries[frame].insert(ctx->command_buffer());
+
+          return absl::OkStatus();
+        });
+    LANCE_THROW_IF_FAILED(pass.status());
+  }
+
+  LANCE_THROW_IF_FAILED(rg->compile());
+
+  auto command_pool = CommandPool::create(test_device(), graphics_queue_family_index).value();
+  auto command_buffer =
+      command_pool->allocate_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY).value();
+
+  core::JobSystem::Options job_system_options;
+  job_system_options.num_workers = 3;
+  core::JobSystem job_system(job_system_options);
+
+  RenderGraph::ExecuteOptions options;
+  options.job_system = &job_system;
+  options.passes_per_job = 3;
+
+  for (frame = 0; frame < 2; ++frame) {
+    // submit() waited for the previous frame, the pool does not reset single command buffers
+    LANCE_THROW_IF_FAILED(command_pool->reset());
+    LANCE_THROW_IF_FAILED(command_buffer->begin());
+    LANCE_THROW_IF_FAILED(rg->execute(command_buffer.get(), &options));
+    LANCE_THROW_IF_FAILED(command_buffer->end());
+
+    LANCE_THROW_IF_FAILED(
+        test_device()->submit(graphics_queue_family_index, {command_buffer->vk_command_buffer()}));
+  }
+
+  ASSERT_EQ(16, executed.load());
+
+  // one per pass, the second execute reused those of the first rather than allocating
+  ASSERT_EQ(8, secondaries[0].size());
+  ASSERT_EQ(secondaries[0], secondaries[1]);
+  ASSERT_EQ(0, secondaries[0].count(command_buffer.get()));
+}
 }  // namespace rendering
 }  // namespace lance
@@ -3,6 +3,7 @@
 #include "absl/strings/str_format.h"
 #include "glog/logging.h"
 #include "glslang/Public/resource_limits_c.h"
+#include "lance/core/profiler.h"
 #include "lance/core/util.h"
 
 namespace lance {
@@ -19,6 +20,8 @@ void make_sure_glslang_ready() {
 
 absl::StatusOr<core::RefCountPtr<core::Blob>> compile_glsl_shader(const char* source,
                                                                   glslang_stage_t stage) {
+  LANCE_PROFILE_ZONE("compile_glsl_shader");
+
   make_sure_glslang_ready();
 
   glslang_input_t input = {};
@@ -72,8 +75,9 @@ absl::StatusOr<core::RefCountPtr<core::Blob>> compile_glsl_shader(const char* so
 
   glslang_program_SPIRV_generate(program, stage);
 
+  // copy the spirv out, so that the program and shader go away before returning
   return core::Blob::create(glslang_program_SPIRV_get_ptr(program),
-                            glslang_program_SPIRV_get_size(program) * 4);
+                            glslang_program_SPIRV_get_size(program) * sizeof(uint32_t));
 }
 }  // namespace rendering
 }  // namespace lance
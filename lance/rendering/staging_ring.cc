@@ -0,0 +1,332 @@
+#include "staging_ring.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "absl/strings/str_format.h"
+#include "glog/logging.h"
+#include "lance/core/profiler.h"
+#include "lance/core/small_containers.h"
+#include "memory_allocator.h"
+#include "vk_api.h"
+
+namespace lance {
+namespace rendering {
+namespace {
+constexpr VkDeviceSize kBufferCopyAlignment = 16;
+
+uint64_t round_up(uint64_t v, uint64_t alignment) {
+  return (v + alignment - 1) / alignment * alignment;
+}
+
+bool ranges_overlap(int64_t l_begin, int64_t l_size, int64_t r_begin, int64_t r_size) {
+  return l_begin < r_begin + r_size && r_begin < l_begin + l_size;
+}
+
+bool regions_overlap(const VkBufferCopy& l, const VkBufferCopy& r) {
+  return ranges_overlap(l.dstOffset, l.size, r.dstOffset, r.size);
+}
+
+bool regions_overlap(const VkBufferImageCopy& l, const VkBufferImageCopy& r) {
+  const auto& ls = l.imageSubresource;
+  const auto& rs = r.imageSubresource;
+  return (ls.aspectMask & rs.aspectMask) && ls.mipLevel == rs.mipLevel &&
+         ranges_overlap(ls.baseArrayLayer, ls.layerCount, rs.baseArrayLayer, rs.layerCount) &&
+         ranges_overlap(l.imageOffset.x, l.imageExtent.width, r.imageOffset.x,
+                        r.imageExtent.width) &&
+         ranges_overlap(l.imageOffset.y, l.imageExtent.height, r.imageOffset.y,
+                        r.imageExtent.height) &&
+         ranges_overlap(l.imageOffset.z, l.imageExtent.depth, r.imageOffset.z, r.imageExtent.depth);
+}
+
+// one copy command per destination, with all of its regions. the regions of one command must not
+// overlap, an upload overlapping an earlier one to the same destination starts another command
+// after `barrier`, so that the later upload wins.
+template <typename Copy, typename Record, typename Barrier>
+void record_copies(std::vector<Copy>* copies, Record record, Barrier barrier) {
+  std::stable_sort(copies->begin(), copies->end(),
+                   [](const Copy& l, const Copy& r) { return l.dst < r.dst; });
+
+  core::SmallVector<decltype(Copy::region), 16> regions;
+  for (size_t i = 0; i < copies->size();) {
+    regions.clear();
+    size_t j = i;
+    for (; j < copies->size() && (*copies)[j].dst == (*copies)[i].dst; ++j) {
+      const auto& region = (*copies)[j].region;
+      const bool overlaps = std::any_of(regions.begin(), regions.end(), [&](const auto& r) {
+        return regions_overlap(r, region);
+      });
+      if (overlaps) {
+        record((*copies)[i].dst, static_cast<uint32_t>(regions.size()), regions.data());
+        barrier();
+        regions.clear();
+      }
+
+      regions.push_back(region);
+    }
+
+    record((*copies)[i].dst, static_cast<uint32_t>(regions.size()), regions.data());
+    i = j;
+  }
+}
+}  // namespace
+
+absl::StatusOr<core::RefCountPtr<StagingRing>> StagingRing::create(
+    const core::RefCountPtr<Device>& device, uint32_t queue_family_index,
+    const StagingRingOptions& options) {
+  if (options.capacity == 0 || options.max_flushes_in_flight == 0) {
+    return absl::InvalidArgumentError("capacity and max_flushes_in_flight must not be 0");
+  }
+
+  VkPhysicalDeviceProperties properties;
+  VkApi::get()->vkGetPhysicalDeviceProperties(device->vk_physical_device(), &properties);
+  const VkDeviceSize image_copy_alignment =
+      std::max(kBufferCopyAlignment, properties.limits.optimalBufferCopyOffsetAlignment);
+
+  // every aligned offset stays aligned when the ring wraps
+  const VkDeviceSize capacity = round_up(options.capacity, image_copy_alignment);
+
+  LANCE_ASSIGN_OR_RETURN(
+      buffer, device->create_buffer(
+                  VK_BUFFER_USAGE_TRANSFER_SRC_BIT, capacity,
+                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+  LANCE_ASSIGN_OR_RETURN(mapped, buffer->memory()->map());
+
+  auto ring = core::make_refcounted<StagingRing>(device, queue_family_index, buffer,
+                                                 static_cast<uint8_t*>(mapped), capacity,
+                                                 image_copy_alignment);
+  LANCE_RETURN_IF_FAILED(ring->initialize(options.max_flushes_in_flight));
+
+  return ring;
+}
+
+StagingRing::StagingRing(core::RefCountPtr<Device> device, uint32_t queue_family_index,
+                         core::RefCountPtr<Buffer> buffer, uint8_t* mapped, VkDeviceSize capacity,
+                         VkDeviceSize image_copy_alignment)
+    : device_(device),
+      queue_family_index_(queue_family_index),
+      buffer_(buffer),
+      mapped_(mapped),
+      capacity_(capacity),
+      image_copy_alignment_(image_copy_alignment) {}
+
+StagingRing::~StagingRing() {
+  // flushes complete in order
+  auto status = device_->wait(last_flush_);
+  if (!status.ok()) {
+    LOG(ERROR) << "failed to wait for staging flushes: " << status;
+  }
+
+  if (!buffer_copies_.empty() || !image_copies_.empty()) {
+    LOG(WARNING) << "staging ring destroyed with " << buffer_copies_.size() + image_copies_.size()
+                 << " uploads never flushed";
+  }
+}
+
+absl::Status StagingRing::initialize(uint32_t max_flushes_in_flight) {
+  flushes_.resize(max_flushes_in_flight);
+  for (auto& flush : flushes_) {
+    LANCE_ASSIGN_OR_RETURN(command_pool, CommandPool::create(device_, queue_family_index_));
+    LANCE_ASSIGN_OR_RETURN(command_buffer,
+                           command_pool->allocate_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY));
+    flush.command_pool = command_pool;
+    flush.command_buffer = command_buffer;
+  }
+
+  return absl::OkStatus();
+}
+
+absl::Status StagingRing::upload_buffer(const Buffer* dst, VkDeviceSize dst_offset,
+                                        const void* data, VkDeviceSize size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  LANCE_ASSIGN_OR_RETURN(staging_offset, push(data, size, kBufferCopyAlignment));
+
+  BufferCopy copy;
+  copy.dst = dst->vk_buffer();
+  copy.region.srcOffset = staging_offset;
+  copy.region.dstOffset = dst_offset;
+  copy.region.size = size;
+  buffer_copies_.push_back(copy);
+
+  return absl::OkStatus();
+}
+
+absl::Status StagingRing::upload_image(VkImage dst, const VkImageSubresourceLayers& subresource,
+                                       VkOffset3D offset, VkExtent3D extent, const void* data,
+                                       VkDeviceSize size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  LANCE_ASSIGN_OR_RETURN(staging_offset, push(data, size, image_copy_alignment_));
+
+  ImageCopy copy;
+  copy.dst = dst;
+  copy.region = {};
+  copy.region.bufferOffset = staging_offset;
+  copy.region.imageSubresource = subresource;
+  copy.region.imageOffset = offset;
+  copy.region.imageExtent = extent;
+  image_copies_.push_back(copy);
+
+  return absl::OkStatus();
+}
+
+absl::StatusOr<VkDeviceSize> StagingRing::push(const void* data, VkDeviceSize size,
+                                               VkDeviceSize alignment) {
+  if (size == 0 || size > capacity_) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("upload size: %d, staging capacity: %d", size, capacity_));
+  }
+
+  LANCE_RETURN_IF_FAILED(reclaim(false));
+
+  for (;;) {
+    if (tail_ == head_) {
+      // empty, restart at the beginning of the ring so that anything up to capacity_ fits
+      head_ = tail_ = round_up(head_, capacity_);
+    }
+
+    uint64_t position = round_up(head_, alignment);
+    if (position % capacity_ + size > capacity_) {
+      // does not fit before the end, the rest of this lap is wasted
+      position = round_up(position, capacity_);
+    }
+
+    if (position + size - tail_ <= capacity_) {
+      head_ = position + size;
+
+      const VkDeviceSize offset = position % capacity_;
+      std::memcpy(mapped_ + offset, data, size);
+      return offset;
+    }
+
+    // full, submit what is pending so that there is a flush to wait for
+    if (in_flight_.empty()) {
+      LANCE_RETURN_IF_FAILED(flush_locked());
+    }
+    CHECK(!in_flight_.empty());
+
+    LANCE_PROFILE_ZONE("StagingRing::wait");
+    LANCE_RETURN_IF_FAILED(reclaim(true));
+  }
+}
+
+absl::Status StagingRing::reclaim(bool wait) {
+  while (!in_flight_.empty()) {
+    const Flush& flush = flushes_[in_flight_.front()];
+
+    if (wait) {
+      LANCE_RETURN_IF_FAILED(device_->wait(flush.token));
+      wait = false;
+    } else {
+      LANCE_ASSIGN_OR_RETURN(complete, device_->is_complete(flush.token));
+      if (!complete) {
+        break;
+      }
+    }
+
+    tail_ = flush.ring_end;
+    in_flight_.pop_front();
+  }
+
+  return absl::OkStatus();
+}
+
+absl::Status StagingRing::flush() {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  return flush_locked();
+}
+
+absl::Status StagingRing::flush_locked() {
+  if (buffer_copies_.empty() && image_copies_.empty()) {
+    return absl::OkStatus();
+  }
+
+  LANCE_PROFILE_ZONE("StagingRing::flush");
+
+  // flushes are reused round robin, if this one is in flight it is the oldest
+  if (!in_flight_.empty() && in_flight_.front() == next_flush_) {
+    LANCE_RETURN_IF_FAILED(reclaim(true));
+  }
+
+  Flush& flush = flushes_[next_flush_];
+  LANCE_RETURN_IF_FAILED(flush.command_pool->reset());
+  LANCE_RETURN_IF_FAILED(flush.command_buffer->begin());
+
+  const VkCommandBuffer vk_command_buffer = flush.command_buffer->vk_command_buffer();
+  const VkBuffer src = buffer_->vk_buffer();
+
+  // orders the copies of overlapping uploads
+  const auto write_after_write = [&]() {
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    VkApi::get()->vkCmdPipelineBarrier(vk_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr,
+                                       0, nullptr);
+  };
+
+  record_copies(
+      &buffer_copies_,
+      [&](VkBuffer dst, uint32_t count, const VkBufferCopy* regions) {
+        VkApi::get()->vkCmdCopyBuffer(vk_command_buffer, src, dst, count, regions);
+      },
+      write_after_write);
+
+  record_copies(
+      &image_copies_,
+      [&](VkImage dst, uint32_t count, const VkBufferImageCopy* regions) {
+        VkApi::get()->vkCmdCopyBufferToImage(vk_command_buffer, src, dst,
+                                             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, count, regions);
+      },
+      write_after_write);
+
+  VkMemoryBarrier barrier = {};
+  barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+  VkApi::get()->vkCmdPipelineBarrier(vk_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                     VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0,
+                                     nullptr, 0, nullptr);
+
+  LANCE_RETURN_IF_FAILED(flush.command_buffer->end());
+
+  SubmitInfo submit_info;
+  submit_info.command_buffers = absl::MakeConstSpan(&vk_command_buffer, 1);
+  LANCE_ASSIGN_OR_RETURN(token, device_->submit_async(queue_family_index_, submit_info));
+
+  VLOG(2) << "staging flush, buffer copies: " << buffer_copies_.size()
+          << ", image copies: " << image_copies_.size() << ", ring bytes in use: " << head_ - tail_;
+
+  flush.token = token;
+  flush.ring_end = head_;
+  last_flush_ = token;
+  in_flight_.push_back(next_flush_);
+  next_flush_ = (next_flush_ + 1) % flushes_.size();
+
+  buffer_copies_.clear();
+  image_copies_.clear();
+
+  return absl::OkStatus();
+}
+
+SubmitToken StagingRing::last_flush() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  return last_flush_;
+}
+
+absl::Status StagingRing::wait_idle() {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  while (!in_flight_.empty()) {
+    LANCE_RETURN_IF_FAILED(reclaim(true));
+  }
+
+  return absl::OkStatus();
+}
+
+}  // namespace rendering
+}  // namespace lance
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "device.h"
+#include "lance/core/object.h"
+
+namespace lance {
+namespace rendering {
+struct StagingRingOptions {
+  // size of the host visible ring, uploads larger than this are rejected
+  VkDeviceSize capacity = VkDeviceSize(64) << 20;
+
+  // flushes whose copies may execute at once, each has its own command pool
+  uint32_t max_flushes_in_flight = 3;
+};
+
+// uploads through one persistently mapped, host visible buffer used as a ring. enqueueing an
+// upload copies the data into the ring, flush() records all pending copies into one command
+// buffer and submits it. the ring space of a flush is reclaimed once its submission completed,
+// an upload that does not fit waits for the oldest flush instead of allocating. thread-safe.
+class StagingRing : public core::Inherit<StagingRing, core::Object> {
+ public:
+  // copies are submitted to the queue of `queue_family_index`
+  static absl::StatusOr<core::RefCountPtr<StagingRing>> create(
+      const core::RefCountPtr<Device>& device, uint32_t queue_family_index,
+      const StagingRingOptions& options = {});
+
+  StagingRing(core::RefCountPtr<Device> device, uint32_t queue_family_index,
+              core::RefCountPtr<Buffer> buffer, uint8_t* mapped, VkDeviceSize capacity,
+              VkDeviceSize image_copy_alignment);
+
+  // waits for the flushes in flight, pending uploads are dropped
+  ~StagingRing() override;
+
+  // `dst` must be alive until the flush executed. of uploads to overlapping ranges before a flush
+  // the last one wins.
+  absl::Status upload_buffer(const Buffer* dst, VkDeviceSize dst_offset, const void* data,
+                             VkDeviceSize size);
+
+  // `data` holds tightly packed texel blocks of 1, 2, 4, 8 or 16 bytes. `dst` must be alive and
+  // in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL when the flush executes. of uploads to overlapping
+  // regions before a flush the last one wins.
+  absl::Status upload_image(VkImage dst, const VkImageSubresourceLayers& subresource,
+                            VkOffset3D offset, VkExtent3D extent, const void* data,
+                            VkDeviceSize size);
+
+  // submits the uploads enqueued since the last flush, followed by a barrier that makes them
+  // visible to later submissions on the same queue. submissions on other queues wait for
+  // `device->wait_semaphore(last_flush())`. does nothing if there are none.
+  absl::Status flush();
+
+  // completion of the last flush
+  SubmitToken last_flush() const;
+
+  // waits until every flushed upload completed
+  absl::Status wait_idle();
+
+  VkDeviceSize capacity() const { return capacity_; }
+
+ private:
+  struct BufferCopy {
+    VkBuffer dst;
+    VkBufferCopy region;
+  };
+
+  struct ImageCopy {
+    VkImage dst;
+    VkBufferImageCopy region;
+  };
+
+  struct Flush {
+    core::RefCountPtr<CommandPool> command_pool;
+    core::RefCountPtr<CommandBuffer> command_buffer;
+    SubmitToken token;
+    // ring position after the flush's data, becomes the tail once it completed
+    uint64_t ring_end = 0;
+  };
+
+  absl::Status initialize(uint32_t max_flushes_in_flight);
+
+  // offset in the ring of `size` bytes copied from `data`
+  absl::StatusOr<VkDeviceSize> push(const void* data, VkDeviceSize size, VkDeviceSize alignment);
+
+  absl::Status flush_locked();
+
+  // reclaims the space of completed flushes, waits for the oldest one if `wait`
+  absl::Status reclaim(bool wait);
+
+  core::RefCountPtr<Device> device_;
+  const uint32_t queue_family_index_;
+  core::RefCountPtr<Buffer> buffer_;
+  uint8_t* const mapped_;
+  const VkDeviceSize capacity_;
+  const VkDeviceSize image_copy_alignment_;
+
+  mutable std::mutex mutex_;
+
+  // positions grow monotonically, the ring offset is position % capacity_
+  uint64_t head_ = 0;
+  uint64_t tail_ = 0;
+
+  std::vector<BufferCopy> buffer_copies_;
+  std::vector<ImageCopy> image_copies_;
+
+  std::vector<Flush> flushes_;
+  uint32_t next_flush_ = 0;
+  SubmitToken last_flush_;
+  // indices of the flushes in flight, oldest first
+  std::deque<uint32_t> in_flight_;
+};
+
+}  // namespace rendering
+}  // namespace lance
@@ -0,0 +1,81 @@
+#include "staging_ring.h"
+
+#include <cstring>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "memory_allocator.h"
+
+namespace lance {
+namespace rendering {
+TEST(staging_ring, upload_buffers_through_wrapping_ring) {
+  auto instance = Instance::create_for_3d().value();
+  auto device = instance->create_device_for_graphics().value();
+  const uint32_t queue_family_index =
+      device->find_queue_family_index(VK_QUEUE_GRAPHICS_BIT).value();
+
+  StagingRingOptions options;
+  options.capacity = 64 * 1024;
+  auto ring = StagingRing::create(device, queue_family_index, options).value();
+
+  // many times the ring capacity, space is reclaimed from completed flushes
+  constexpr size_t kChunkSize = 10000;
+  constexpr size_t kChunks = 64;
+  auto dst = device
+                 ->create_buffer(VK_BUFFER_USAGE_TRANSFER_DST_BIT, kChunkSize * kChunks,
+                                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                     VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
+                 .value();
+
+  std::vector<uint8_t> chunk(kChunkSize);
+  for (size_t i = 0; i < kChunks; ++i) {
+    std::memset(chunk.data(), static_cast<int>(i), chunk.size());
+    ASSERT_TRUE(ring->upload_buffer(dst.get(), i * kChunkSize, chunk.data(), chunk.size()).ok());
+    if (i % 4 == 3) {
+      ASSERT_TRUE(ring->flush().ok());
+    }
+  }
+  ASSERT_TRUE(ring->flush().ok());
+  ASSERT_TRUE(ring->wait_idle().ok());
+
+  const auto* mapped = static_cast<const uint8_t*>(dst->memory()->map().value());
+  for (size_t i = 0; i < kChunks; ++i) {
+    ASSERT_EQ(i, mapped[i * kChunkSize]);
+    ASSERT_EQ(i, mapped[(i + 1) * kChunkSize - 1]);
+  }
+
+  ASSERT_FALSE(ring->upload_buffer(dst.get(), 0, chunk.data(), ring->capacity() + 1).ok());
+}
+
+TEST(staging_ring, overlapping_uploads) {
+  auto instance = Instance::create_for_3d().value();
+  auto device = instance->create_device_for_graphics().value();
+  const uint32_t queue_family_index =
+      device->find_queue_family_index(VK_QUEUE_GRAPHICS_BIT).value();
+
+  auto ring = StagingRing::create(device, queue_family_index).value();
+  auto dst = device
+                 ->create_buffer(VK_BUFFER_USAGE_TRANSFER_DST_BIT, 4096,
+                                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                     VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
+                 .value();
+
+  // copied by separate commands in upload order
+  const std::vector<uint8_t> first(2048, 1);
+  const std::vector<uint8_t> second(2048, 2);
+  const std::vector<uint8_t> third(1024, 3);
+  ASSERT_TRUE(ring->upload_buffer(dst.get(), 0, first.data(), first.size()).ok());
+  ASSERT_TRUE(ring->upload_buffer(dst.get(), 1024, second.data(), second.size()).ok());
+  ASSERT_TRUE(ring->upload_buffer(dst.get(), 1024, third.data(), third.size()).ok());
+  ASSERT_TRUE(ring->flush().ok());
+  ASSERT_TRUE(ring->wait_idle().ok());
+
+  const auto* mapped = static_cast<const uint8_t*>(dst->memory()->map().value());
+  ASSERT_EQ(1, mapped[1023]);
+  ASSERT_EQ(3, mapped[1024]);
+  ASSERT_EQ(3, mapped[2047]);
+  ASSERT_EQ(2, mapped[2048]);
+  ASSERT_EQ(2, mapped[3071]);
+}
+}  // namespace rendering
+}  // namespace lance
@@ -99,6 +99,10 @@ VkApi::VkApi() {
   VK_API_LOAD(vkCreateComputePipelines);
   VK_API_LOAD(vkCreateGraphicsPipelines);
   VK_API_LOAD(vkCreatePipelineLayout);
+  VK_API_LOAD(vkCreatePipelineCache);
+  VK_API_LOAD(vkDestroyPipelineCache);
+  VK_API_LOAD(vkGetPipelineCacheData);
+  VK_API_LOAD(vkMergePipelineCaches);
   VK_API_LOAD(vkCreateDescriptorSetLayout);
   VK_API_LOAD(vkDestroyDescriptorSetLayout);
   VK_API_LOAD(vkCmdPushConstants);
@@ -106,6 +110,7 @@ VkApi::VkApi() {
   VK_API_LOAD(vkDestroyPipelineLayout);
   VK_API_LOAD(vkCreateCommandPool);
   VK_API_LOAD(vkDestroyCommandPool);
+  VK_API_LOAD(vkResetCommandPool);
   VK_API_LOAD(vkAllocateCommandBuffers);
   VK_API_LOAD(vkFreeCommandBuffers);
   VK_API_LOAD(vkBeginCommandBuffer);
@@ -115,12 +120,18 @@ VkApi::VkApi() {
   VK_API_LOAD(vkCreateFence);
   VK_API_LOAD(vkDestroyFence);
   VK_API_LOAD(vkWaitForFences);
+  VK_API_LOAD(vkCreateSemaphore);
+  VK_API_LOAD(vkDestroySemaphore);
+  VK_API_LOAD(vkGetSemaphoreCounterValue);
+  VK_API_LOAD(vkWaitSemaphores);
+  VK_API_LOAD(vkDeviceWaitIdle);
   VK_API_LOAD(vkCreateFramebuffer);
   VK_API_LOAD(vkDestroyFramebuffer);
   VK_API_LOAD(vkCreateRenderPass);
   VK_API_LOAD(vkDestroyRenderPass);
   VK_API_LOAD(vkCmdBeginRenderPass);
   VK_API_LOAD(vkCmdEndRenderPass);
+  VK_API_LOAD(vkCmdExecuteCommands);
   VK_API_LOAD(vkCmdNextSubpass);
   VK_API_LOAD(vkCmdSetViewport);
   VK_API_LOAD(vkCmdSetScissor);
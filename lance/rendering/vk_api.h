@@ -56,6 +56,10 @@ class VkApi {
   VK_API_DEFINE(vkCreateComputePipelines);
   VK_API_DEFINE(vkCreateGraphicsPipelines);
   VK_API_DEFINE(vkCreatePipelineLayout);
+  VK_API_DEFINE(vkCreatePipelineCache);
+  VK_API_DEFINE(vkDestroyPipelineCache);
+  VK_API_DEFINE(vkGetPipelineCacheData);
+  VK_API_DEFINE(vkMergePipelineCaches);
   VK_API_DEFINE(vkCreateDescriptorSetLayout);
   VK_API_DEFINE(vkDestroyDescriptorSetLayout);
   VK_API_DEFINE(vkCmdPushConstants);
@@ -63,6 +67,7 @@ class VkApi {
   VK_API_DEFINE(vkDestroyPipelineLayout);
   VK_API_DEFINE(vkCreateCommandPool);
   VK_API_DEFINE(vkDestroyCommandPool);
+  VK_API_DEFINE(vkResetCommandPool);
   VK_API_DEFINE(vkAllocateCommandBuffers);
   VK_API_DEFINE(vkFreeCommandBuffers);
   VK_API_DEFINE(vkBeginCommandBuffer);
@@ -72,12 +77,18 @@ class VkApi {
   VK_API_DEFINE(vkCreateFence);
   VK_API_DEFINE(vkDestroyFence);
   VK_API_DEFINE(vkWaitForFences);
+  VK_API_DEFINE(vkCreateSemaphore);
+  VK_API_DEFINE(vkDestroySemaphore);
+  VK_API_DEFINE(vkGetSemaphoreCounterValue);
+  VK_API_DEFINE(vkWaitSemaphores);
+  VK_API_DEFINE(vkDeviceWaitIdle);
   VK_API_DEFINE(vkCreateFramebuffer);
   VK_API_DEFINE(vkDestroyFramebuffer);
   VK_API_DEFINE(vkCreateRenderPass);
   VK_API_DEFINE(vkDestroyRenderPass);
   VK_API_DEFINE(vkCmdBeginRenderPass);
   VK_API_DEFINE(vkCmdEndRenderPass);
+  VK_API_DEFINE(vkCmdExecuteCommands);
   VK_API_DEFINE(vkCmdNextSubpass);
   VK_API_DEFINE(vkCmdSetViewport);
   VK_API_DEFINE(vkCmdSetScissor);
@@ -0,0 +1,159 @@
+#include "culling.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "glog/logging.h"
+#include "lance/scene/scene.h"
+
+namespace lance {
+namespace scene {
+namespace {
+core::Float4 normalize_plane(core::Float4 plane) {
+  const float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+  if (length > 0) {
+    for (size_t i = 0; i < 4; ++i) {
+      plane[i] /= length;
+    }
+  }
+  return plane;
+}
+
+// row 3 of the matrix plus or minus `row`
+core::Float4 make_plane(const core::Matrix4x4& m, size_t row, float sign) {
+  return normalize_plane(core::Float4(m.m[3][0] + sign * m.m[row][0],
+                                      m.m[3][1] + sign * m.m[row][1],
+                                      m.m[3][2] + sign * m.m[row][2],
+                                      m.m[3][3] + sign * m.m[row][3]));
+}
+
+// test boxes [begin, end), `begin` must be a multiple of 64
+void cull_range(const Frustum& frustum, const core::BoundingBox* boxes, size_t begin, size_t end,
+                uint64_t* visibility) {
+  DCHECK_EQ(begin % 64, 0);
+
+  for (size_t w = begin / 64; w < visibility_mask_size(end); ++w) {
+    visibility[w] = 0;
+  }
+
+  size_t i = begin;
+
+#if defined(LANCE_SIMD_AVX2)
+  // broadcast plane components once, together with the side of the box facing each normal
+  struct PlaneX8 {
+    __m256 x, y, z, d;
+    bool x_positive, y_positive, z_positive;
+  } planes[Frustum::kPlaneCount];
+
+  for (size_t p = 0; p < Frustum::kPlaneCount; ++p) {
+    const core::Float4& plane = frustum.planes[p];
+    planes[p] = PlaneX8{
+        _mm256_set1_ps(plane.x), _mm256_set1_ps(plane.y), _mm256_set1_ps(plane.z),
+        _mm256_set1_ps(plane.w), plane.x >= 0,           plane.y >= 0,
+        plane.z >= 0,
+    };
+  }
+
+  // a BoundingBox is 6 floats: lower.xyz, upper.xyz
+  const __m256i stride = _mm256_setr_epi32(0, 6, 12, 18, 24, 30, 36, 42);
+  constexpr size_t kLanes = 8;
+
+  for (; i + kLanes <= end; i += kLanes) {
+    const float* f = &boxes[i].lower.x;
+    const __m256 lx = _mm256_i32gather_ps(f + 0, stride, sizeof(float));
+    const __m256 ly = _mm256_i32gather_ps(f + 1, stride, sizeof(float));
+    const __m256 lz = _mm256_i32gather_ps(f + 2, stride, sizeof(float));
+    const __m256 ux = _mm256_i32gather_ps(f + 3, stride, sizeof(float));
+    const __m256 uy = _mm256_i32gather_ps(f + 4, stride, sizeof(float));
+    const __m256 uz = _mm256_i32gather_ps(f + 5, stride, sizeof(float));
+
+    // a box is outside if its corner furthest along the normal is behind any plane
+    __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for (const auto& plane : planes) {
+      const __m256 px = plane.x_positive ? ux : lx;
+      const __m256 py = plane.y_positive ? uy : ly;
+      const __m256 pz = plane.z_positive ? uz : lz;
+
+      __m256 distance = _mm256_fmadd_ps(plane.x, px, plane.d);
+      distance = _mm256_fmadd_ps(plane.y, py, distance);
+      distance = _mm256_fmadd_ps(plane.z, pz, distance);
+
+      inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GE_OQ));
+    }
+
+    const uint64_t bits = static_cast<uint32_t>(_mm256_movemask_ps(inside));
+    visibility[i / 64] |= bits << (i % 64);
+  }
+#endif
+
+  for (; i < end; ++i) {
+    if (frustum.intersects(boxes[i])) {
+      visibility[i / 64] |= uint64_t(1) << (i % 64);
+    }
+  }
+}
+}  // namespace
+
+Frustum Frustum::from_matrix(const core::Matrix4x4& m) {
+  Frustum frustum;
+  frustum.planes[kLeft] = make_plane(m, 0, 1.0f);
+  frustum.planes[kRight] = make_plane(m, 0, -1.0f);
+  frustum.planes[kBottom] = make_plane(m, 1, 1.0f);
+  frustum.planes[kTop] = make_plane(m, 1, -1.0f);
+  frustum.planes[kFar] = make_plane(m, 2, -1.0f);
+
+  // z >= 0
+  frustum.planes[kNear] =
+      normalize_plane(core::Float4(m.m[2][0], m.m[2][1], m.m[2][2], m.m[2][3]));
+
+  return frustum;
+}
+
+Frustum Frustum::from_camera(const Camera* camera) {
+  return from_matrix(camera->projection_matrix());
+}
+
+bool Frustum::intersects(const core::BoundingBox& box) const {
+  for (const auto& plane : planes) {
+    const float px = plane.x >= 0 ? box.upper.x : box.lower.x;
+    const float py = plane.y >= 0 ? box.upper.y : box.lower.y;
+    const float pz = plane.z >= 0 ? box.upper.z : box.lower.z;
+
+    if (plane.x * px + plane.y * py + plane.z * pz + plane.w < 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void cull_bounding_boxes(const Frustum& frustum, absl::Span<const core::BoundingBox> boxes,
+                         absl::Span<uint64_t> visibility, const CullOptions* options) {
+  CHECK_GE(visibility.size(), visibility_mask_size(boxes.size()));
+
+  const CullOptions default_options;
+  if (!options) {
+    options = &default_options;
+  }
+
+  if (boxes.size() <= options->parallel_threshold) {
+    cull_range(frustum, boxes.data(), 0, boxes.size(), visibility.data());
+    return;
+  }
+
+  core::JobSystem* job_system = options->job_system;
+  if (!job_system) {
+    job_system = core::JobSystem::global();
+  }
+
+  // jobs cover whole mask words, so that no two jobs write the same word
+  const size_t words_per_job = std::max<size_t>(1, visibility_mask_size(options->boxes_per_job));
+
+  job_system->parallel_for(0, visibility_mask_size(boxes.size()), words_per_job,
+                           [&](size_t begin, size_t end) {
+                             cull_range(frustum, boxes.data(), begin * 64,
+                                        std::min(boxes.size(), end * 64), visibility.data());
+                           });
+}
+}  // namespace scene
+}  // namespace lance
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+
+#include "absl/types/span.h"
+#include "lance/core/job_system.h"
+#include "lance/core/linalg.h"
+
+namespace lance {
+namespace scene {
+class Camera;
+
+struct Frustum {
+  enum PlaneIndex {
+    kLeft = 0,
+    kRight,
+    kBottom,
+    kTop,
+    kNear,
+    kFar,
+    kPlaneCount,
+  };
+
+  // (nx, ny, nz, d), a point p is inside the plane if dot(n, p) + d >= 0
+  core::Float4 planes[kPlaneCount];
+
+  // extract the planes from a row major (view) projection matrix, clip space follows the vulkan
+  // convention: x, y in [-w, w] and z in [0, w]
+  static Frustum from_matrix(const core::Matrix4x4& view_projection);
+
+  // frustum of `camera` in camera space
+  static Frustum from_camera(const Camera* camera);
+
+  bool intersects(const core::BoundingBox& box) const;
+};
+
+// number of uint64_t words of a visibility mask for `num_boxes` boxes
+inline size_t visibility_mask_size(size_t num_boxes) { return (num_boxes + 63) / 64; }
+
+struct CullOptions {
+  // arrays with more boxes than this are split into jobs
+  size_t parallel_threshold = 64 * 1024;
+
+  // boxes tested by each job, rounded up to a multiple of 64
+  size_t boxes_per_job = 16 * 1024;
+
+  // nullptr means core::JobSystem::global()
+  core::JobSystem* job_system = nullptr;
+};
+
+// set bit (i % 64) of visibility[i / 64] if boxes[i] intersects the frustum. `visibility` must hold
+// at least visibility_mask_size(boxes.size()) words.
+void cull_bounding_boxes(const Frustum& frustum, absl::Span<const core::BoundingBox> boxes,
+                         absl::Span<uint64_t> visibility, const CullOptions* options = nullptr);
+}  // namespace scene
+}  // namespace lance
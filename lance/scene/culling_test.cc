@@ -0,0 +1,101 @@
+#include "culling.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace lance {
+namespace scene {
+namespace {
+// camera looks along +z, clip space follows the vulkan convention
+core::Matrix4x4 perspective(float fov_y, float aspect, float z_near, float z_far) {
+  const float f = 1.0f / std::tan(fov_y * 0.5f);
+
+  core::Matrix4x4 m = {};
+  m.m[0][0] = f / aspect;
+  m.m[1][1] = f;
+  m.m[2][2] = z_far / (z_far - z_near);
+  m.m[2][3] = -z_far * z_near / (z_far - z_near);
+  m.m[3][2] = 1.0f;
+  return m;
+}
+
+core::BoundingBox box_at(float x, float y, float z, float half_extent) {
+  return core::BoundingBox{{x - half_extent, y - half_extent, z - half_extent},
+                           {x + half_extent, y + half_extent, z + half_extent}};
+}
+
+std::vector<core::BoundingBox> random_boxes(size_t n) {
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+  std::uniform_real_distribution<float> extent(0.1f, 5.0f);
+
+  std::vector<core::BoundingBox> boxes(n);
+  for (auto& box : boxes) {
+    box = box_at(position(rng), position(rng), position(rng), extent(rng));
+  }
+  return boxes;
+}
+
+bool is_visible(absl::Span<const uint64_t> visibility, size_t i) {
+  return (visibility[i / 64] >> (i % 64)) & 1;
+}
+}  // namespace
+
+TEST(culling, frustum) {
+  const auto frustum = Frustum::from_matrix(perspective(1.0f, 1.0f, 0.1f, 100.0f));
+
+  EXPECT_TRUE(frustum.intersects(box_at(0, 0, 10, 1)));
+  // behind the camera
+  EXPECT_FALSE(frustum.intersects(box_at(0, 0, -10, 1)));
+  // beyond the far plane
+  EXPECT_FALSE(frustum.intersects(box_at(0, 0, 200, 1)));
+  // off to the side
+  EXPECT_FALSE(frustum.intersects(box_at(100, 0, 10, 1)));
+  EXPECT_FALSE(frustum.intersects(box_at(0, -100, 10, 1)));
+  // straddles the near plane
+  EXPECT_TRUE(frustum.intersects(box_at(0, 0, 0, 1)));
+}
+
+TEST(culling, cull_bounding_boxes) {
+  const auto frustum = Frustum::from_matrix(perspective(1.0f, 1.5f, 0.1f, 150.0f));
+
+  // odd size to cover the scalar tail
+  const auto boxes = random_boxes(10007);
+  std::vector<uint64_t> visibility(visibility_mask_size(boxes.size()), ~uint64_t(0));
+
+  cull_bounding_boxes(frustum, boxes, absl::MakeSpan(visibility));
+
+  size_t num_visible = 0;
+  for (size_t i = 0; i < boxes.size(); ++i) {
+    EXPECT_EQ(frustum.intersects(boxes[i]), is_visible(visibility, i)) << "box: " << i;
+    num_visible += is_visible(visibility, i);
+  }
+
+  EXPECT_GT(num_visible, 0);
+  EXPECT_LT(num_visible, boxes.size());
+}
+
+TEST(culling, cull_bounding_boxes_parallel) {
+  const auto frustum = Frustum::from_matrix(perspective(1.2f, 1.0f, 0.1f, 150.0f));
+  const auto boxes = random_boxes(100003);
+
+  std::vector<uint64_t> expected(visibility_mask_size(boxes.size()));
+  cull_bounding_boxes(frustum, boxes, absl::MakeSpan(expected));
+
+  core::JobSystem job_system(core::JobSystem::Options{7});
+
+  CullOptions options;
+  options.parallel_threshold = 0;
+  options.boxes_per_job = 1000;
+  options.job_system = &job_system;
+
+  std::vector<uint64_t> actual(visibility_mask_size(boxes.size()));
+  cull_bounding_boxes(frustum, boxes, absl::MakeSpan(actual), &options);
+
+  EXPECT_EQ(expected, actual);
+}
+}  // namespace scene
+}  // namespace lance